@@ -1,10 +1,11 @@
 #include "CanReceiver.h"
+#include "PayloadCodec.hpp"
+#include "LatencyRecorder.h"
+#include "WireStats.h"
+#include "IoReactor.h"
 #include <QDebug>
-#include <nlohmann/json.hpp>
-#include <sstream>
-#include <iomanip>
+#include <cerrno>
 #include <cstring>
-#include <iostream>
 #include <linux/can.h>
 #include <linux/can/raw.h>
 #include <sys/socket.h>
@@ -12,13 +13,22 @@
 #include <net/if.h>
 #include <unistd.h>
 #include <arpa/inet.h>
-#include <fstream>
+#include <algorithm>
 
-using json = nlohmann::json;
+// CAN ID of the combined ASCII speed/RPM frame
+static constexpr uint32_t kSpeedRpmFrameId = 0x64;
 
 // Constructor: Initializes CAN receiver with the specified interface
-CanReceiver::CanReceiver(const QString &interfaceName, QObject *parent) : QObject(parent), socketFd(-1)
+CanReceiver::CanReceiver(const QString &interfaceName, SampleRing *ring, DropCounters *drops,
+                         const signaldb::Database *database, const BatchConfig &batchConfig, QObject *parent)
+    : QObject(parent), socketFd(-1), m_batchReader(nullptr), m_ring(ring), m_drops(drops),
+      m_epoch(ring ? ring->epoch() : 0)
 {
+    if (database)
+    {
+        buildDecodePlans(*database);
+    }
+
     // Create a raw CAN socket for communication
     socketFd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
     if (socketFd < 0)
@@ -35,6 +45,16 @@ CanReceiver::CanReceiver(const QString &interfaceName, QObject *parent) : QObjec
         qFatal("Failed to retrieve interface index for %s", interfaceName.toStdString().c_str());
     }
 
+    // Only wake up for frames the dashboard decodes; install before bind so no other traffic is queued
+    setKernelFilter(decodedIds());
+
+    // Receive CAN FD frames too; classic frames keep arriving as CAN_MTU bytes
+    int enableFd = 1;
+    if (setsockopt(socketFd, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enableFd, sizeof(enableFd)) < 0)
+    {
+        qWarning() << "CAN FD frames not supported on" << interfaceName << ":" << strerror(errno);
+    }
+
     // Bind the socket to the specified CAN interface
     struct sockaddr_can addr;
     addr.can_family = AF_CAN;
@@ -44,180 +64,267 @@ CanReceiver::CanReceiver(const QString &interfaceName, QObject *parent) : QObjec
         qFatal("Failed to bind CAN socket to %s", interfaceName.toStdString().c_str());
     }
 
+    // Drain all pending frames per wakeup, with kernel receive timestamps
+    m_batchReader = new DatagramBatchReader(socketFd, CANFD_MTU, batchConfig);
+
     // Set up a socket notifier to handle incoming CAN frames
     notifier = new QSocketNotifier(socketFd, QSocketNotifier::Read, this);
     connect(notifier, &QSocketNotifier::activated, this, &CanReceiver::readCanFrame);
     qDebug() << "CanReceiver initialized successfully for" << interfaceName;
-
-    // Check if can_protocol_receiver.json exists and is valid
-    std::ifstream check_file("can_protocol_receiver.json");
-    bool needs_init = true;
-    if (check_file.is_open())
-    {
-        // Read the content of the JSON file
-        std::stringstream buffer;
-        buffer << check_file.rdbuf();
-        std::string content = buffer.str();
-        check_file.close();
-
-        if (!content.empty())
-        {
-            try
-            {
-                json temp = json::parse(content);
-                if (temp.is_array())
-                {
-                    needs_init = false; // Valid JSON array found, no initialization needed
-                }
-            }
-            catch (const json::exception &e)
-            {
-                qWarning() << "Existing can_protocol_receiver.json is invalid:" << e.what();
-                qWarning() << "File content:" << QString::fromStdString(content);
-            }
-        }
-    }
-
-    // Initialize can_protocol_receiver.json with an empty array if invalid or missing
-    if (needs_init)
-    {
-        std::ofstream json_file("can_protocol_receiver.json");
-        if (json_file.is_open())
-        {
-            json_file << "[]";
-            json_file.close();
-            qDebug() << "Initialized can_protocol_receiver.json as empty array";
-        }
-        else
-        {
-            qWarning() << "Failed to initialize can_protocol_receiver.json";
-        }
-    }
 }
 
 // Destructor: Cleans up resources
 CanReceiver::~CanReceiver()
 {
+    logWireStats("CAN", m_sequence.stats());
+
     // Close the CAN socket if it was opened
     if (socketFd >= 0)
     {
         close(socketFd);
     }
-    // Delete the socket notifier
+    // Delete the socket notifier and the batch reader
     delete notifier;
+    delete m_batchReader;
 }
 
-// Saves JSON data to a specified file
-void CanReceiver::saveJsonFile(const std::string &filename, const nlohmann::json &json_data)
+// Replaces the socket notifier by the I/O reactor
+void CanReceiver::attachToReactor(IoReactor *reactor)
 {
-    std::ofstream file(filename);
-    if (!file.is_open())
+    delete notifier;
+    notifier = nullptr;
+    reactor->add(socketFd, "CAN", [this]() {
+        readCanFrame();
+        return m_batchReader->pending();
+    });
+}
+
+// Returns the CAN IDs decoded by readCanFrame()
+std::vector<uint32_t> CanReceiver::decodedIds() const
+{
+    std::vector<uint32_t> ids = {kSpeedRpmFrameId};
+    for (const DecodePlan &plan : m_decodePlans)
     {
-        qWarning() << "Failed to save JSON file:" << QString::fromStdString(filename);
-        return;
+        ids.push_back(plan.frame.id());
     }
- 
-    // Write JSON data with 2-space indentation
-    file << json_data.dump(2);
-    file.close();
-    qDebug() << "Saved JSON file:" << QString::fromStdString(filename);
+    return ids;
 }
 
-// Logs speed and RPM data to can_protocol_receiver.json
-void CanReceiver::logSignalToJson(float speed, int rpm) {
-    std::lock_guard<std::mutex> lock(m_mutex); // Ensure thread-safe access to the JSON file
-    // Create a JSON entry for the signal data
-    json signalEntry;
-    signalEntry["Speed"] = speed; // Store speed in meters per second
-    signalEntry["RPM"] = rpm;     // Store RPM as an integer
-
-    // Read existing JSON data from file
-    json entries = json::array();
-    std::ifstream in_file("can_protocol_receiver.json");
-    std::string file_content;
-    if (in_file.is_open()) {
-        std::stringstream buffer;
-        buffer << in_file.rdbuf();
-        file_content = buffer.str();
-        in_file.close();
-        if (!file_content.empty()) {
-            try {
-                entries = json::parse(file_content);
-                if (!entries.is_array()) {
-                    qWarning() << "can_protocol_receiver.json is not an array. Resetting to empty array.";
-                    entries = json::array();
-                }
-            } catch (const json::exception &e) {
-                qWarning() << "Failed to parse can_protocol_receiver.json:" << e.what();
-                qWarning() << "File content:" << QString::fromStdString(file_content);
-                entries = json::array();
+// Compiles one decode plan per database message and binds gauge signals
+void CanReceiver::buildDecodePlans(const signaldb::Database &database)
+{
+    size_t maxFields = 0;
+    for (const signaldb::Message &message : database.messages())
+    {
+        if (message.id == kSpeedRpmFrameId)
+        {
+            qWarning() << "Signal database message" << QString::fromStdString(message.name)
+                       << "uses the speed/RPM frame ID and is ignored";
+            continue;
+        }
+
+        DecodePlan plan{signaldb::FramePlan(message), {}};
+        for (size_t i = 0; i < message.signalList.size(); ++i)
+        {
+            const signaldb::Signal &signal = message.signalList[i];
+            if (signal.gauge != signaldb::Gauge::None)
+            {
+                double range = signal.maximum - signal.minimum;
+                plan.gauges.push_back({i, signal.gauge, signal.minimum, range != 0.0 ? range : 1.0});
             }
         }
-    } else {
-        qWarning() << "Failed to open can_protocol_receiver.json for reading";
+        maxFields = std::max(maxFields, message.signalList.size());
+        m_planIndex[message.id] = m_decodePlans.size();
+        m_decodePlans.push_back(std::move(plan));
     }
+    m_values.resize(maxFields);
+    qDebug() << "CanReceiver decodes" << m_decodePlans.size() << "signal database messages";
+}
 
-    // Append the new signal entry to the JSON array
-    entries.push_back(signalEntry);
-    // Save the updated JSON array to the file
-    saveJsonFile("can_protocol_receiver.json", entries);
+// Installs a kernel-side filter accepting only the given CAN IDs
+bool CanReceiver::setKernelFilter(const std::vector<uint32_t> &ids)
+{
+    // Beyond the kernel limit the whole list would be rejected; fall back to accepting all frames
+    bool tooMany = ids.size() > CAN_RAW_FILTER_MAX;
+    if (tooMany)
+    {
+        qWarning() << "Too many CAN IDs for a kernel filter:" << ids.size() << "- accepting all frames";
+    }
+    std::vector<struct can_filter> filters;
+    filters.reserve(tooMany ? 0 : ids.size());
+    for (size_t i = 0; !tooMany && i < ids.size(); ++i)
+    {
+        uint32_t id = ids[i];
+        struct can_filter filter;
+        filter.can_id = id;
+        // Exact match on the identifier and frame format; RTR frames are never decoded
+        filter.can_mask = ((id & CAN_EFF_FLAG) ? CAN_EFF_MASK : CAN_SFF_MASK) | CAN_EFF_FLAG | CAN_RTR_FLAG;
+        filters.push_back(filter);
+    }
+
+    // An empty filter list disables filtering (the kernel default accepts all frames)
+    const struct can_filter acceptAll = {0, 0};
+    const void *data = filters.empty() ? static_cast<const void *>(&acceptAll) : filters.data();
+    socklen_t size = filters.empty() ? sizeof(acceptAll) : static_cast<socklen_t>(filters.size() * sizeof(struct can_filter));
+    if (setsockopt(socketFd, SOL_CAN_RAW, CAN_RAW_FILTER, data, size) < 0)
+    {
+        qWarning() << "Failed to set CAN_RAW_FILTER:" << strerror(errno);
+        return false;
+    }
+    qDebug() << "CAN kernel filter installed for" << filters.size() << "IDs";
+    return true;
 }
 
-// Reads and processes incoming CAN frames
+// Pushes a decoded frame to the CAN sample ring
+void CanReceiver::publishSample(const SignalSample &sample)
+{
+    if (m_ring && !m_ring->push(sample))
+    {
+        m_drops->addQueueOverflow();
+    }
+}
+
+// Drains and processes all pending CAN frames
 void CanReceiver::readCanFrame()
 {
-    struct can_frame frame;
-    // Read a CAN frame from the socket
-    ssize_t nbytes = read(socketFd, &frame, sizeof(struct can_frame));
-    if (nbytes < 0)
+    // A new capture epoch is a new test iteration: the sender restarts its sequence
+    if (m_ring && m_ring->epoch() != m_epoch)
+    {
+        logWireStats("CAN", m_sequence.stats());
+        m_sequence = wire::SequenceTracker();
+        m_epoch = m_ring->epoch();
+    }
+
+    quint64 dropsBefore = m_batchReader->kernelDrops();
+    quint64 truncatedBefore = m_batchReader->truncatedCount();
+    int handled = m_batchReader->drain([this](const uint8_t *data, size_t length, uint64_t timestampNs) {
+        processFrame(data, length, timestampNs);
+    });
+    if (handled < 0)
     {
-        qWarning() << "Error reading CAN frame";
+        qWarning() << "Error reading CAN frame:" << strerror(errno);
         return;
     }
-    if (nbytes < sizeof(struct can_frame))
+
+    m_drops->add(DropCounters::ShortReads, m_batchReader->truncatedCount() - truncatedBefore);
+    quint64 drops = m_batchReader->kernelDrops();
+    if (drops != dropsBefore)
+    {
+        m_drops->add(DropCounters::KernelDrops, drops - dropsBefore);
+        qWarning() << "CAN socket dropped" << (drops - dropsBefore) << "frames, total" << drops;
+    }
+}
+
+// Decodes one CAN frame
+void CanReceiver::processFrame(const uint8_t *buffer, size_t nbytes, uint64_t timestampNs)
+{
+    if (nbytes != CAN_MTU && nbytes != CANFD_MTU)
     {
+        m_drops->add(DropCounters::ShortReads);
         qWarning() << "Short read, message truncated";
         return;
     }
+    // A classic frame is the head of a canfd_frame, with its DLC in len
+    struct canfd_frame frame = {};
+    memcpy(&frame, buffer, nbytes);
 
-    // Process frames with CAN ID 0x64
-    if (frame.can_id == 0x64)
-    {
-        // Convert frame data to a QByteArray (8 bytes)
-        QByteArray data(reinterpret_cast<const char *>(frame.data), 8);
+    // The raw frame goes to the sample ring together with whatever was decoded from it; FD frames
+    // contribute their first bytes only
+    SignalSample sample = {};
+    sample.timestampNs = timestampNs;
+    sample.id = frame.can_id;
+    sample.length = std::min<uint8_t>(frame.len, sizeof(sample.payload));
+    memcpy(sample.payload, frame.data, sizeof(sample.payload));
 
-        // Extract speed and RPM as strings from the ASCII data
-        QString dataStr = QString::fromLatin1(data);
-        QString speedStr = dataStr.left(4); // First 4 characters for speed
-        QString rpmStr = dataStr.mid(4, 4); // Next 4 characters for RPM
+    // Process frames with the speed/RPM CAN ID
+    if (frame.can_id == kSpeedRpmFrameId)
+    {
+        decodeSpeedRpmFrame(frame, sample);
+        return;
+    }
 
-        // Convert strings to numerical values
-        bool ok1 = false, ok2 = false;
-        float speed_raw = speedStr.toFloat(&ok1);
-        int rpm_raw = rpmStr.toInt(&ok2);
+    auto found = m_planIndex.find(frame.can_id);
+    if (found != m_planIndex.end())
+    {
+        decodeDatabaseFrame(m_decodePlans[found->second], frame, sample);
+    }
+}
 
-        if (ok1 && ok2)
+// Decodes the speed/RPM frame
+void CanReceiver::decodeSpeedRpmFrame(const struct canfd_frame &frame, SignalSample &sample)
+{
+    // Fast path for compact binary frames; the ASCII decoding below is the legacy fallback
+    if (wire::isBinary(frame.data, frame.len))
+    {
+        wire::Frame binary;
+        if (!wire::decode(frame.data, frame.len, binary))
         {
-            // Convert speed from m/s to km/h
-            float speed_converted = speed_raw * 3.6f;
-            float rpm_converted = rpm_raw; // RPM is already in the correct unit
-
-            // Log the raw and converted values
-            qDebug().noquote() << QString("CAN Speed raw: %1, converted: %2 km/h; RPM  %3")
-                      .arg(speed_raw, 0, 'f', 2)
-                      .arg(speed_converted, 0, 'f', 2)
-                      .arg(rpm_raw, 0, 'f', 2);
-                          
-            // Emit signals with converted values
-            emit speedDataReceived(speed_converted);
-            emit rpmDataReceived(rpm_converted);
-            
-            // Log the raw data to JSON
-            logSignalToJson(speed_raw, rpm_raw);
+            m_drops->add(DropCounters::DecodeFailures);
+            qWarning() << "Invalid binary CAN speed/RPM frame of" << frame.len << "bytes";
+            return;
         }
-        else
+        m_drops->updateSequence(m_sequence, binary, stampLatency(sample, binary, sample.timestampNs));
+        sample.fields = SpeedField | RpmField;
+        sample.speed = binary.speed;
+        sample.rpm = binary.rpm;
+        publishSample(sample);
+        return;
+    }
+
+    // Decode speed (first 4 characters) and RPM (next 4 characters) from the ASCII data
+    float speed_raw = 0.0f;
+    int rpm_raw = 0;
+
+    if (payload::decodeSpeedRpm(frame.data, speed_raw, rpm_raw))
+    {
+        // Publish the raw data to the GUI and the signal log
+        sample.fields = SpeedField | RpmField;
+        sample.speed = speed_raw;
+        sample.rpm = static_cast<float>(rpm_raw);
+        publishSample(sample);
+    }
+    else
+    {
+        m_drops->add(DropCounters::DecodeFailures);
+        qWarning() << "Failed to convert ASCII CAN data to float.";
+    }
+}
+
+// Decodes a signal database message with its precompiled unpack plan
+void CanReceiver::decodeDatabaseFrame(const DecodePlan &plan, const struct canfd_frame &frame, SignalSample &sample)
+{
+    if (frame.len < plan.frame.length())
+    {
+        m_drops->add(DropCounters::DecodeFailures);
+        qWarning() << "CAN frame" << QString::number(frame.can_id, 16) << "shorter than its database message";
+        return;
+    }
+    plan.frame.unpack(frame.data, m_values.data());
+
+    for (const GaugeBinding &binding : plan.gauges)
+    {
+        double value = m_values[binding.field];
+        switch (binding.gauge)
         {
-            qWarning() << "Failed to convert ASCII CAN data to float.";
+        case signaldb::Gauge::Speed:
+            sample.fields |= SpeedField;
+            sample.speed = static_cast<float>(value);
+            break;
+        case signaldb::Gauge::Rpm:
+            sample.fields |= RpmField;
+            sample.rpm = static_cast<float>(value);
+            break;
+        case signaldb::Gauge::Fuel:
+            sample.fields |= FuelField;
+            sample.fuel = static_cast<float>(std::clamp((value - binding.minimum) / binding.range, 0.0, 1.0));
+            break;
+        case signaldb::Gauge::Temperature:
+            sample.fields |= TemperatureField;
+            sample.temperature = static_cast<float>(std::clamp((value - binding.minimum) / binding.range, 0.0, 1.0));
+            break;
+        case signaldb::Gauge::None:
+            break;
         }
     }
-}
\ No newline at end of file
+    publishSample(sample);
+}
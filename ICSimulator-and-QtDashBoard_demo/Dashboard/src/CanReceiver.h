@@ -1,14 +1,24 @@
 #pragma once
 #include <QObject>
 #include <QSocketNotifier>
-#include <string>
-#include <fstream>
-#include <nlohmann/json.hpp>
-#include <mutex>
+#include "SampleRing.h"
+#include "DatagramBatchReader.h"
+#include "DropCounters.h"
+#include "SignalDatabase.hpp"
+#include "WireFormat.hpp"
+#include <unordered_map>
+#include <vector>
+
+struct canfd_frame;
+class IoReactor;
 
 // Class: CanReceiver
 // Description: Manages the reception and processing of CAN bus frames, parsing speed and RPM data,
-//              and logging it to a JSON file. Inherits from QObject for signal-slot functionality.
+//              and publishing it to a SampleRing. Besides the ASCII speed/RPM frame, every message of the
+//              signal database is decoded with its precompiled unpack plan; signals bound to a gauge drive
+//              the matching value signal. The socket accepts CAN FD frames as well, so FD messages of up to
+//              64 bytes are decoded in the same single unpack pass. Inherits from QObject for signal-slot
+//              functionality.
 class CanReceiver : public QObject
 {
     Q_OBJECT
@@ -16,35 +26,43 @@ public:
     // Constructor: Initializes the CAN receiver with the specified interface name.
     // Parameters:
     //   - interfaceName: The name of the CAN interface (e.g., "can0").
+    //   - ring: Sample ring decoded frames are pushed to; the GUI and the signal log consume it (not owned).
+    //   - drops: Loss counters of the bus (not owned; must outlive the receiver).
+    //   - database: Signal database whose messages are decoded as well (may be null; only read here).
+    //   - batchConfig: recvmmsg batch size and per-wakeup drain budget.
     //   - parent: Optional parent QObject for memory management.
-    explicit CanReceiver(const QString &interfaceName, QObject *parent = nullptr);
+    explicit CanReceiver(const QString &interfaceName, SampleRing *ring, DropCounters *drops,
+                         const signaldb::Database *database, const BatchConfig &batchConfig = BatchConfig(),
+                         QObject *parent = nullptr);
 
     // Destructor: Cleans up resources, including closing the CAN socket and deleting the notifier.
     ~CanReceiver();
 
-signals:
-    // Signal: Emitted when speed data is received from a CAN frame.
-    // Parameters:
-    //   - speed: Vehicle speed in km/h.
-    void speedDataReceived(float speed);
+    // Function: CAN IDs this receiver decodes; the kernel filter is built from this list by default.
+    std::vector<uint32_t> decodedIds() const;
 
-    // Signal: Emitted when RPM data is received from a CAN frame.
+    // Function: Installs a CAN_RAW_FILTER so only the given IDs are delivered to user space.
     // Parameters:
-    //   - rpm: Engine RPM as a float.
-    void rpmDataReceived(float rpm);
+    //   - ids: Standard (11-bit) or extended (CAN_EFF_FLAG set) identifiers. An empty list, or one longer
+    //          than the kernel limit (CAN_RAW_FILTER_MAX), accepts everything.
+    // Returns: true if the filter was applied.
+    bool setKernelFilter(const std::vector<uint32_t> &ids);
 
-    // Signal: Emitted when fuel data is received from a CAN frame.
+    // Function: Hands the CAN socket to an I/O reactor instead of the socket notifier: reads, decoding and
+    //           ring pushes then run on the reactor thread. Call while the reactor is stopped.
     // Parameters:
-    //   - fuel: Fuel level or consumption data.
-    void fuelDataReceived(float fuel);
+    //   - reactor: Reactor serving all bus receivers (not owned; must be cleared before this is deleted).
+    void attachToReactor(IoReactor *reactor);
 
-    // Signal: Emitted when temperature data is received from a CAN frame.
-    // Parameters:
-    //   - temp: Temperature reading (e.g., engine or coolant temperature).
-    void tempDataReceived(float temp);
+    // Function: Cumulative frames dropped by the kernel because the socket buffer was full.
+    quint64 kernelDropCount() const { return m_batchReader->kernelDrops(); }
+
+    // Function: Loss, duplication, reordering and latency of the binary speed/RPM frames received in the current
+    //           capture epoch.
+    const wire::StreamStats &wireStats() const { return m_sequence.stats(); }
 
 private slots:
-    // Slot: Reads and processes incoming CAN frames from the socket.
+    // Slot: Drains and processes all pending CAN frames from the socket.
     void readCanFrame();
 
 private:
@@ -54,18 +72,64 @@ private:
     // Member: QSocketNotifier for asynchronous monitoring of CAN socket events.
     QSocketNotifier *notifier;
 
-    // Function: Logs speed and RPM data to a JSON file.
-    // Parameters:
-    //   - speed: Raw speed value in meters per second.
-    //   - rpm: Raw RPM value as an integer.
-    void logSignalToJson(float speed, int rpm);
+    // Member: Batched recvmmsg reader for the socket.
+    DatagramBatchReader *m_batchReader;
+
+    // Member: Ring of decoded samples shared by the GUI and the signal log (not owned).
+    SampleRing *m_ring;
+
+    // Member: Loss counters of the bus (not owned).
+    DropCounters *m_drops;
+
+    // Struct: Signal of a database message that drives a gauge.
+    //   - field: Index of the signal in the message.
+    //   - gauge: Gauge it drives.
+    //   - minimum/range: Signal range used to scale fuel and temperature to 0..1.
+    struct GaugeBinding
+    {
+        size_t field;
+        signaldb::Gauge gauge;
+        double minimum;
+        double range;
+    };
+
+    // Struct: Precompiled decoder of one database message.
+    struct DecodePlan
+    {
+        signaldb::FramePlan frame;
+        std::vector<GaugeBinding> gauges;
+    };
+
+    // Member: Decoders of the database messages, indexed by CAN ID through m_planIndex.
+    std::vector<DecodePlan> m_decodePlans;
+    std::unordered_map<uint32_t, size_t> m_planIndex;
+
+    // Member: Scratch buffer for unpacked physical values.
+    std::vector<double> m_values;
+
+    // Member: Sequence and latency tracking of the binary speed/RPM frames.
+    wire::SequenceTracker m_sequence;
+
+    // Member: Capture epoch of the ring when m_sequence was started.
+    uint32_t m_epoch;
+
+    // Function: Builds the decode plans of every database message.
+    void buildDecodePlans(const signaldb::Database &database);
+
+    // Function: Pushes a decoded frame to the sample ring.
+    void publishSample(const SignalSample &sample);
+
+    // Function: Decodes the speed/RPM frame (compact binary, or legacy ASCII) into sample.
+    void decodeSpeedRpmFrame(const struct canfd_frame &frame, SignalSample &sample);
+
+    // Function: Decodes a database message into sample with its unpack plan.
+    void decodeDatabaseFrame(const DecodePlan &plan, const struct canfd_frame &frame, SignalSample &sample);
 
-    // Function: Saves JSON data to the specified file.
+    // Function: Decodes one received CAN or CAN FD frame and publishes its values.
     // Parameters:
-    //   - filename: Path to the JSON file.
-    //   - json_data: JSON data to be written.
-    void saveJsonFile(const std::string &filename, const nlohmann::json &json_data);
+    //   - buffer: Raw struct can_frame (CAN_MTU) or struct canfd_frame (CANFD_MTU) bytes.
+    //   - nbytes: Number of bytes received.
+    //   - timestampNs: Kernel receive time in CLOCK_REALTIME nanoseconds.
+    void processFrame(const uint8_t *buffer, size_t nbytes, uint64_t timestampNs);
 
-    // Member: Mutex for thread-safe access to the JSON file.
-    std::mutex m_mutex;
 };
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "DatagramBatchReader.h"
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <time.h>
+
+// Control buffer large enough for one timestamp and one drop counter message
+static constexpr size_t kControlSize = CMSG_SPACE(sizeof(struct timespec)) + CMSG_SPACE(sizeof(uint32_t));
+
+// Constructor: Preallocates one buffer per batch slot and enables kernel metadata on the socket
+DatagramBatchReader::DatagramBatchReader(int fd, size_t maxPacketSize, const BatchConfig &config)
+    : m_fd(fd), m_packetSize(maxPacketSize), m_config(config), m_timestampsEnabled(false),
+      m_dropCounterEnabled(false), m_lastOverflow(0), m_kernelDrops(0), m_truncated(0), m_pending(false)
+{
+    if (m_config.batchSize == 0)
+    {
+        m_config.batchSize = 1;
+    }
+    if (m_config.drainBudget < m_config.batchSize)
+    {
+        m_config.drainBudget = m_config.batchSize;
+    }
+
+    const size_t slotCount = m_config.batchSize;
+    m_buffers.resize(slotCount * m_packetSize);
+    m_control.resize(slotCount * kControlSize);
+    m_iovecs.resize(slotCount);
+    m_messages.resize(slotCount);
+    m_timestamps.resize(slotCount);
+
+    // The kernel caps the request at net.core.rmem_max
+    if (m_config.receiveBufferBytes > 0 &&
+        setsockopt(m_fd, SOL_SOCKET, SO_RCVBUF, &m_config.receiveBufferBytes, sizeof(m_config.receiveBufferBytes)) < 0)
+    {
+        qWarning() << "Failed to set SO_RCVBUF:" << strerror(errno);
+    }
+
+    int enable = 1;
+    m_timestampsEnabled = setsockopt(m_fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) == 0;
+    if (!m_timestampsEnabled)
+    {
+        qWarning() << "SO_TIMESTAMPNS not supported, falling back to user-space receive timestamps";
+    }
+    m_dropCounterEnabled = setsockopt(m_fd, SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable)) == 0;
+    if (!m_dropCounterEnabled)
+    {
+        qWarning() << "SO_RXQ_OVFL not supported, kernel drops will not be counted";
+    }
+}
+
+// Receives up to maxCount datagrams with a single recvmmsg call
+int DatagramBatchReader::readBatch(unsigned maxCount)
+{
+    // msg_controllen and msg_flags are overwritten by the kernel, so reset every slot before each call
+    for (unsigned i = 0; i < maxCount; ++i)
+    {
+        m_iovecs[i].iov_base = &m_buffers[i * m_packetSize];
+        m_iovecs[i].iov_len = m_packetSize;
+
+        struct msghdr &hdr = m_messages[i].msg_hdr;
+        hdr.msg_name = nullptr;
+        hdr.msg_namelen = 0;
+        hdr.msg_iov = &m_iovecs[i];
+        hdr.msg_iovlen = 1;
+        hdr.msg_control = &m_control[i * kControlSize];
+        hdr.msg_controllen = kControlSize;
+        hdr.msg_flags = 0;
+        m_messages[i].msg_len = 0;
+    }
+
+    int count = recvmmsg(m_fd, m_messages.data(), maxCount, MSG_DONTWAIT, nullptr);
+    if (count < 0)
+    {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        {
+            return 0;
+        }
+        qWarning() << "recvmmsg failed:" << strerror(errno);
+        return -1;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        uint64_t stamp = 0;
+        struct msghdr &hdr = m_messages[i].msg_hdr;
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&hdr); cmsg; cmsg = CMSG_NXTHDR(&hdr, cmsg))
+        {
+            if (cmsg->cmsg_level != SOL_SOCKET)
+            {
+                continue;
+            }
+            if (cmsg->cmsg_type == SCM_TIMESTAMPNS)
+            {
+                struct timespec ts;
+                memcpy(&ts, CMSG_DATA(cmsg), sizeof(ts));
+                stamp = static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+            }
+            else if (cmsg->cmsg_type == SO_RXQ_OVFL)
+            {
+                // The kernel reports the socket's cumulative drop count; accumulate the increase
+                uint32_t overflow;
+                memcpy(&overflow, CMSG_DATA(cmsg), sizeof(overflow));
+                m_kernelDrops += static_cast<uint32_t>(overflow - m_lastOverflow);
+                m_lastOverflow = overflow;
+            }
+        }
+        if (stamp == 0)
+        {
+            struct timespec ts;
+            clock_gettime(CLOCK_REALTIME, &ts);
+            stamp = static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+        }
+        m_timestamps[i] = stamp;
+    }
+    return count;
+}
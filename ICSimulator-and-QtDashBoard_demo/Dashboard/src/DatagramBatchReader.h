@@ -0,0 +1,124 @@
+#ifndef DATAGRAMBATCHREADER_H
+#define DATAGRAMBATCHREADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+// Struct: BatchConfig
+// Description: Tuning for batched socket reads.
+//   - batchSize: Maximum datagrams fetched by one recvmmsg call.
+//   - drainBudget: Maximum datagrams handled per notifier wakeup before yielding to the event loop.
+//   - receiveBufferBytes: Requested SO_RCVBUF so bursts are absorbed by the kernel (0 keeps the default).
+struct BatchConfig
+{
+    unsigned batchSize = 64;
+    unsigned drainBudget = 1024;
+    int receiveBufferBytes = 4 * 1024 * 1024;
+};
+
+// Class: DatagramBatchReader
+// Description: Drains a datagram socket with recvmmsg into preallocated buffers. Optionally collects the
+//              kernel receive timestamp (SO_TIMESTAMPNS) of every datagram and the socket drop counter
+//              (SO_RXQ_OVFL). Works for UDP and raw CAN sockets.
+class DatagramBatchReader
+{
+public:
+    // Constructor: Preallocates buffers and enables kernel timestamps and the drop counter on the socket.
+    // Parameters:
+    //   - fd: Bound datagram socket (not owned).
+    //   - maxPacketSize: Size of each receive buffer; longer datagrams are reported as truncated.
+    //   - config: Batch size and drain budget.
+    DatagramBatchReader(int fd, size_t maxPacketSize, const BatchConfig &config = BatchConfig());
+
+    // Function: Drains the socket, calling handler(data, length, timestampNs) for every complete datagram.
+    //           timestampNs is the kernel CLOCK_REALTIME receive time, or the user-space time when
+    //           kernel timestamps are unavailable.
+    // Returns: Number of datagrams handled (including truncated ones), or -1 on a socket error.
+    template <typename Handler>
+    int drain(Handler &&handler)
+    {
+        unsigned handled = 0;
+        m_pending = false;
+        while (handled < m_config.drainBudget)
+        {
+            unsigned want = m_config.drainBudget - handled;
+            int count = readBatch(want < m_config.batchSize ? want : m_config.batchSize);
+            if (count < 0)
+            {
+                return handled > 0 ? static_cast<int>(handled) : -1;
+            }
+            for (int i = 0; i < count; ++i)
+            {
+                if (isTruncated(i))
+                {
+                    ++m_truncated;
+                    continue;
+                }
+                handler(data(i), length(i), timestampNs(i));
+            }
+            handled += static_cast<unsigned>(count);
+            // A short batch means the socket queue is empty
+            if (static_cast<unsigned>(count) < m_config.batchSize)
+            {
+                break;
+            }
+        }
+        m_pending = handled >= m_config.drainBudget;
+        return static_cast<int>(handled);
+    }
+
+    // Function: Whether the last drain() stopped at the drain budget, so datagrams may still be queued.
+    //           An edge-triggered caller must drain again before waiting for the next edge.
+    bool pending() const { return m_pending; }
+
+    // Function: Cumulative datagrams dropped by the kernel because the socket buffer was full.
+    uint64_t kernelDrops() const { return m_kernelDrops; }
+
+    // Function: Cumulative datagrams discarded because they did not fit the receive buffer.
+    uint64_t truncatedCount() const { return m_truncated; }
+
+    // Function: Whether SO_TIMESTAMPNS / SO_RXQ_OVFL could be enabled on the socket.
+    bool hasKernelTimestamps() const { return m_timestampsEnabled; }
+    bool hasDropCounter() const { return m_dropCounterEnabled; }
+
+private:
+    // Function: Receives up to maxCount datagrams without blocking.
+    // Returns: Number of datagrams received, 0 if none were pending, -1 on error.
+    int readBatch(unsigned maxCount);
+
+    const uint8_t *data(int index) const { return &m_buffers[static_cast<size_t>(index) * m_packetSize]; }
+    size_t length(int index) const { return m_messages[index].msg_len; }
+    uint64_t timestampNs(int index) const { return m_timestamps[index]; }
+    bool isTruncated(int index) const { return (m_messages[index].msg_hdr.msg_flags & MSG_TRUNC) != 0; }
+
+    // Member: Socket being drained (not owned).
+    int m_fd;
+
+    // Member: Size of each receive buffer.
+    size_t m_packetSize;
+
+    // Member: Batch size and drain budget.
+    BatchConfig m_config;
+
+    // Member: Preallocated recvmmsg state, one entry per batch slot.
+    std::vector<uint8_t> m_buffers;
+    std::vector<uint8_t> m_control;
+    std::vector<struct iovec> m_iovecs;
+    std::vector<struct mmsghdr> m_messages;
+    std::vector<uint64_t> m_timestamps;
+
+    // Member: Drop accounting.
+    bool m_timestampsEnabled;
+    bool m_dropCounterEnabled;
+    uint32_t m_lastOverflow;
+    uint64_t m_kernelDrops;
+    uint64_t m_truncated;
+
+    // Member: Set when the last drain() stopped at the budget.
+    bool m_pending;
+};
+
+#endif // DATAGRAMBATCHREADER_H
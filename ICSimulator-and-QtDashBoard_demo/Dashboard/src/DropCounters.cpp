@@ -0,0 +1,116 @@
+#include "DropCounters.h"
+#include <QDebug>
+#include <QFile>
+
+// Counter names, in Counter order
+static const char *const kCounterNames[DropCounters::CounterCount] = {
+    "kernelDrops", "shortReads", "decodeFailures", "sequenceGaps", "queueOverflows"};
+
+// Sum of all counters
+uint64_t DropCounters::Snapshot::total() const
+{
+    uint64_t sum = 0;
+    for (uint64_t value : values)
+    {
+        sum += value;
+    }
+    return sum;
+}
+
+// Constructor: Starts every counter at zero
+DropCounters::DropCounters(const QString &bus)
+    : m_bus(bus)
+{
+    for (int i = 0; i < CounterCount; ++i)
+    {
+        m_counters[i].value.store(0, std::memory_order_relaxed);
+        m_baseline[i].value.store(0, std::memory_order_relaxed);
+    }
+}
+
+// Counter values minus the baseline
+DropCounters::Snapshot DropCounters::snapshot() const
+{
+    Snapshot snapshot;
+    for (int i = 0; i < CounterCount; ++i)
+    {
+        uint64_t value = m_counters[i].value.load(std::memory_order_relaxed);
+        uint64_t baseline = m_baseline[i].value.load(std::memory_order_relaxed);
+        snapshot.values[i] = value > baseline ? value - baseline : 0;
+    }
+    return snapshot;
+}
+
+// Moves the baseline to the current values
+void DropCounters::reset()
+{
+    for (int i = 0; i < CounterCount; ++i)
+    {
+        m_baseline[i].value.store(m_counters[i].value.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+// Name of a counter
+const char *DropCounters::counterName(Counter counter)
+{
+    return kCounterNames[counter];
+}
+
+// Snapshots of several buses as one JSON object
+QByteArray DropCounters::toJson(const QList<DropCounters *> &buses)
+{
+    QByteArray json = "{";
+    for (int bus = 0; bus < buses.size(); ++bus)
+    {
+        Snapshot snapshot = buses[bus]->snapshot();
+        json += bus ? ", \"" : "\"";
+        json += buses[bus]->bus().toUtf8();
+        json += "\": {";
+        for (int i = 0; i < CounterCount; ++i)
+        {
+            json += i ? ", \"" : "\"";
+            json += kCounterNames[i];
+            json += "\": ";
+            json += QByteArray::number(static_cast<qulonglong>(snapshot.values[i]));
+        }
+        json += "}";
+    }
+    json += "}\n";
+    return json;
+}
+
+// Writes the JSON report to a file
+bool DropCounters::writeJson(const QList<DropCounters *> &buses, const QString &path)
+{
+    QFile file(path);
+    QByteArray json = toJson(buses);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size())
+    {
+        qWarning() << "Failed to write drop counters to" << path << ":" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+// Logs one line per bus
+void DropCounters::log(const QList<DropCounters *> &buses)
+{
+    for (DropCounters *counters : buses)
+    {
+        Snapshot snapshot = counters->snapshot();
+        qInfo().noquote() << QString("%1 drops: kernel %2, short reads %3, decode failures %4, sequence gaps %5, "
+                                     "queue overflows %6")
+                                 .arg(counters->bus())
+                                 .arg(snapshot[KernelDrops])
+                                 .arg(snapshot[ShortReads])
+                                 .arg(snapshot[DecodeFailures])
+                                 .arg(snapshot[SequenceGaps])
+                                 .arg(snapshot[QueueOverflows]);
+    }
+}
+
+// Warns about samples dropped on a full ring
+void DropCounters::logQueueOverflow(uint64_t total) const
+{
+    qWarning().noquote() << QString("%1 sample ring full, %2 samples dropped so far").arg(m_bus).arg(total);
+}
@@ -0,0 +1,130 @@
+#ifndef DROPCOUNTERS_H
+#define DROPCOUNTERS_H
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include "WireFormat.hpp"
+
+// Class: DropCounters
+// Description: Where the frames of one bus were lost, counted on every receive path:
+//   - KernelDrops: dropped by the kernel because the socket buffer was full (SO_RXQ_OVFL), or reported
+//                  as an overrun by the LIN driver.
+//   - ShortReads: datagrams truncated by the receive buffer or shorter than a frame of the bus.
+//   - DecodeFailures: frames of the right size that could not be decoded (invalid binary frame, ASCII
+//                     that does not parse, database frame shorter than its message).
+//   - SequenceGaps: binary frames missing from the sender's sequence when the next one arrived.
+//   - QueueOverflows: decoded samples rejected by the full SampleRing.
+//              The receiver thread is the only writer: each counter is a relaxed atomic on its own cache
+//              line, incremented with a plain load and store, so counting costs no locked instruction and
+//              readers on other threads never bounce the writer's lines. reset() therefore does not clear
+//              the counters; it moves a baseline that snapshot() subtracts.
+class DropCounters
+{
+public:
+    enum Counter
+    {
+        KernelDrops,
+        ShortReads,
+        DecodeFailures,
+        SequenceGaps,
+        QueueOverflows,
+        CounterCount
+    };
+
+    // Struct: Snapshot
+    // Description: Counter values since the last reset(), indexed by Counter.
+    struct Snapshot
+    {
+        uint64_t values[CounterCount];
+
+        uint64_t operator[](Counter counter) const { return values[counter]; }
+        uint64_t total() const;
+    };
+
+    // Constructor: Starts every counter at zero.
+    // Parameters:
+    //   - bus: Bus name used in the reports (e.g., "CAN").
+    explicit DropCounters(const QString &bus);
+
+    DropCounters(const DropCounters &) = delete;
+    DropCounters &operator=(const DropCounters &) = delete;
+
+    // Function: Adds to a counter. Receiver thread only.
+    void add(Counter counter, uint64_t count = 1)
+    {
+        std::atomic<uint64_t> &value = m_counters[counter].value;
+        value.store(value.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+
+    // Function: Counts a sample dropped because the sample ring was full. Logs the first drop and then every
+    //           kOverflowLogInterval drops with the total, so an overloaded receiver does not also format
+    //           a log line per frame. Receiver thread only.
+    void addQueueOverflow()
+    {
+        add(QueueOverflows);
+        uint64_t total = m_counters[QueueOverflows].value.load(std::memory_order_relaxed);
+        if (total % kOverflowLogInterval == 1)
+        {
+            logQueueOverflow(total);
+        }
+    }
+
+    // Function: Updates a sequence tracker with a binary frame and counts the frames it found missing.
+    //           Late frames that fill a gap afterwards are not subtracted. Receiver thread only.
+    void updateSequence(wire::SequenceTracker &tracker, const wire::Frame &frame, uint64_t nowNs)
+    {
+        uint64_t lostBefore = tracker.stats().lost;
+        tracker.update(frame, nowNs);
+        if (tracker.stats().lost > lostBefore)
+        {
+            add(SequenceGaps, tracker.stats().lost - lostBefore);
+        }
+    }
+
+    // Function: Counter values since the last reset(). Any thread.
+    Snapshot snapshot() const;
+
+    // Function: Starts counting from zero again. Any thread.
+    void reset();
+
+    // Function: Bus name.
+    const QString &bus() const { return m_bus; }
+
+    // Function: Name of a counter in the reports (e.g., "kernelDrops").
+    static const char *counterName(Counter counter);
+
+    // Function: Snapshots of several buses as one JSON object, {"CAN": {"kernelDrops": 0, ...}, ...}.
+    static QByteArray toJson(const QList<DropCounters *> &buses);
+
+    // Function: Writes toJson() to a file.
+    // Returns: false if the file could not be written.
+    static bool writeJson(const QList<DropCounters *> &buses, const QString &path);
+
+    // Function: Logs one line per bus with qInfo.
+    static void log(const QList<DropCounters *> &buses);
+
+private:
+    // Ring overflows between two overflow warnings
+    static constexpr uint64_t kOverflowLogInterval = 10000;
+
+    // Function: Logs the overflow warning with the total since start.
+    void logQueueOverflow(uint64_t total) const;
+
+    // Struct: One counter on its own cache line.
+    struct alignas(64) Slot
+    {
+        std::atomic<uint64_t> value;
+    };
+
+    // Member: Counters (written by the receiver thread) and the reset baseline (written by reset()).
+    Slot m_counters[CounterCount];
+    Slot m_baseline[CounterCount];
+
+    // Member: Bus name.
+    QString m_bus;
+};
+
+#endif // DROPCOUNTERS_H
@@ -0,0 +1,512 @@
+#include "ExportCodec.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+// Text byte standing for a number, and the byte preceding a literal kPlaceholder or kEscape in the text
+static constexpr uint8_t kPlaceholder = 0x01;
+static constexpr uint8_t kEscape = 0x02;
+
+// Flag in a number's tag (its fraction digits) when its difference is of the plain digits, because aligning
+// it to its column's fraction would overflow
+static constexpr uint8_t kUnaligned = 0x40;
+
+// Most digits of a number replaced by a placeholder, so its digits fit an int64_t
+static constexpr int kMaxDigits = 18;
+
+// Powers of ten up to 10^kMaxDigits
+static constexpr int64_t kPowers[kMaxDigits + 1] = {1LL,
+                                                    10LL,
+                                                    100LL,
+                                                    1000LL,
+                                                    10000LL,
+                                                    100000LL,
+                                                    1000000LL,
+                                                    10000000LL,
+                                                    100000000LL,
+                                                    1000000000LL,
+                                                    10000000000LL,
+                                                    100000000000LL,
+                                                    1000000000000LL,
+                                                    10000000000000LL,
+                                                    100000000000000LL,
+                                                    1000000000000000LL,
+                                                    10000000000000000LL,
+                                                    100000000000000000LL,
+                                                    1000000000000000000LL};
+
+// Longest run of number bytes the encoder keeps back at the end of a chunk
+static constexpr size_t kHoldBack = 32;
+
+// Smallest output growth step of the zlib loops
+static constexpr size_t kOutputStep = 16 * 1024;
+
+// Codec names, in ExportCodec order
+static const char *const kCodecNames[ExportCodecCount] = {"none", "deflate", "delta+deflate"};
+
+const char *exportCodecName(ExportCodec codec)
+{
+    return codec < ExportCodecCount ? kCodecNames[codec] : "unknown";
+}
+
+static bool isDigit(uint8_t c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Bytes a number cannot directly follow: it would be part of a word, an identifier or another number
+static bool isWordByte(uint8_t c)
+{
+    return isDigit(c) || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_' || c == '.';
+}
+
+static bool isNumberByte(uint8_t c)
+{
+    return isDigit(c) || c == '.' || c == '-';
+}
+
+static void appendVarint(std::vector<uint8_t> &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Returns: false if the varint runs past end or over 64 bits
+static bool readVarint(const uint8_t *&data, const uint8_t *end, uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (data == end)
+        {
+            return false;
+        }
+        uint8_t byte = *data++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Function: Parses the number at the start of data: -?(0|[1-9][0-9]*)(\.[0-9]+)?, at most kMaxDigits digits,
+//           not negative zero, and not followed by a digit, '.' or an exponent.
+// Parameters:
+//   - length: Set to the bytes of the number.
+//   - value: Set to the digits as an integer, with the sign.
+//   - scale: Set to the number of fraction digits.
+// Returns: false if data does not start with such a number.
+static bool parseNumber(const uint8_t *data, size_t size, size_t &length, int64_t &value, uint8_t &scale)
+{
+    size_t i = 0;
+    bool negative = data[0] == '-';
+    if (negative)
+    {
+        ++i;
+    }
+    if (i >= size || !isDigit(data[i]))
+    {
+        return false;
+    }
+
+    uint64_t mantissa = 0;
+    int digits = 0;
+    if (data[i] == '0')
+    {
+        ++i;
+        digits = 1;
+    }
+    else
+    {
+        for (; i < size && isDigit(data[i]); ++i)
+        {
+            if (++digits > kMaxDigits)
+            {
+                return false;
+            }
+            mantissa = mantissa * 10 + (data[i] - '0');
+        }
+    }
+    int fraction = 0;
+    if (i + 1 < size && data[i] == '.' && isDigit(data[i + 1]))
+    {
+        for (++i; i < size && isDigit(data[i]); ++i, ++fraction)
+        {
+            if (++digits > kMaxDigits)
+            {
+                return false;
+            }
+            mantissa = mantissa * 10 + (data[i] - '0');
+        }
+    }
+    if (i < size && (isDigit(data[i]) || data[i] == '.' || data[i] == 'e' || data[i] == 'E'))
+    {
+        return false;
+    }
+    if (negative && mantissa == 0)
+    {
+        return false;
+    }
+
+    length = i;
+    value = negative ? -static_cast<int64_t>(mantissa) : static_cast<int64_t>(mantissa);
+    scale = static_cast<uint8_t>(fraction);
+    return true;
+}
+
+// Function: Writes a number back as parseNumber() read it.
+// Returns: false if the value cannot come from parseNumber().
+static bool formatNumber(int64_t value, uint8_t scale, std::vector<uint8_t> &out)
+{
+    if (scale >= kMaxDigits)
+    {
+        return false;
+    }
+    uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    char digits[24];
+    int count = 0;
+    do
+    {
+        digits[count++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude > 0 && count < kMaxDigits + 1);
+    if (magnitude > 0)
+    {
+        return false;
+    }
+    // Leading zeros up to one integer digit: 5 with 2 fraction digits is 0.05
+    while (count < scale + 1)
+    {
+        digits[count++] = '0';
+    }
+
+    if (value < 0)
+    {
+        out.push_back('-');
+    }
+    for (int i = count - 1; i >= 0; --i)
+    {
+        out.push_back(static_cast<uint8_t>(digits[i]));
+        if (i == scale && scale > 0)
+        {
+            out.push_back('.');
+        }
+    }
+    return true;
+}
+
+// Function: Multiplies value by 10^exponent (exponent < kMaxDigits).
+// Returns: false if the product overflows.
+static bool scaleUp(int64_t value, int exponent, int64_t &out)
+{
+    int64_t limit = INT64_MAX / kPowers[exponent];
+    if (value > limit || value < -limit)
+    {
+        return false;
+    }
+    out = value * kPowers[exponent];
+    return true;
+}
+
+static uint64_t zigzag(uint64_t delta)
+{
+    return (delta << 1) ^ static_cast<uint64_t>(static_cast<int64_t>(delta) >> 63);
+}
+
+static uint64_t unzigzag(uint64_t value)
+{
+    return (value >> 1) ^ (0 - (value & 1));
+}
+
+// Clears the column state and the text history
+void NumericDeltaTransform::reset()
+{
+    memset(m_columns, 0, sizeof(m_columns));
+    m_history = 0;
+}
+
+// Replaces the numbers of one chunk by placeholders and column deltas
+void NumericDeltaTransform::encode(const uint8_t *data, size_t length, std::vector<uint8_t> &out)
+{
+    m_text.clear();
+    m_tags.clear();
+    m_numbers.clear();
+    size_t i = 0;
+    while (i < length)
+    {
+        uint8_t c = data[i];
+        size_t numberLength;
+        int64_t value;
+        uint8_t scale;
+        if ((c == '-' || isDigit(c)) && !isWordByte(static_cast<uint8_t>(m_history)) &&
+            parseNumber(data + i, length - i, numberLength, value, scale))
+        {
+            // Differences in unsigned arithmetic: they wrap identically in the decoder
+            Column &previous = m_columns[column()];
+            int aligned = std::max(scale, previous.scale);
+            int64_t current, base;
+            uint8_t tag = scale;
+            if (!scaleUp(value, aligned - scale, current) || !scaleUp(previous.value, aligned - previous.scale, base))
+            {
+                current = value;
+                base = previous.value;
+                tag |= kUnaligned;
+            }
+            appendVarint(m_numbers, zigzag(static_cast<uint64_t>(current) - static_cast<uint64_t>(base)));
+            previous = Column{value, scale};
+            m_text.push_back(kPlaceholder);
+            m_tags.push_back(tag);
+            m_history = (m_history << 8) | kPlaceholder;
+            i += numberLength;
+            continue;
+        }
+
+        if (c == kPlaceholder || c == kEscape)
+        {
+            m_text.push_back(kEscape);
+        }
+        m_text.push_back(c);
+        m_history = (m_history << 8) | c;
+        ++i;
+    }
+
+    appendVarint(out, m_text.size());
+    appendVarint(out, m_tags.size());
+    out.insert(out.end(), m_text.begin(), m_text.end());
+    out.insert(out.end(), m_tags.begin(), m_tags.end());
+    out.insert(out.end(), m_numbers.begin(), m_numbers.end());
+}
+
+// Rebuilds the original bytes of one block
+bool NumericDeltaTransform::decode(const uint8_t *data, size_t length, std::vector<uint8_t> &out)
+{
+    const uint8_t *end = data + length;
+    uint64_t textLength, tagCount;
+    if (!readVarint(data, end, textLength) || !readVarint(data, end, tagCount) ||
+        textLength > static_cast<uint64_t>(end - data) || tagCount > static_cast<uint64_t>(end - data) - textLength)
+    {
+        return false;
+    }
+    const uint8_t *text = data;
+    const uint8_t *textEnd = text + textLength;
+    const uint8_t *tags = textEnd;
+    const uint8_t *tagsEnd = tags + tagCount;
+    const uint8_t *numbers = tagsEnd;
+
+    while (text < textEnd)
+    {
+        uint8_t c = *text++;
+        if (c == kEscape)
+        {
+            if (text == textEnd)
+            {
+                return false;
+            }
+            c = *text++;
+        }
+        else if (c == kPlaceholder)
+        {
+            if (!decodeNumber(tags, tagsEnd, numbers, end, out))
+            {
+                return false;
+            }
+            continue;
+        }
+        out.push_back(c);
+        m_history = (m_history << 8) | c;
+    }
+    return tags == tagsEnd && numbers == end;
+}
+
+// Rebuilds one number from its tag and difference
+bool NumericDeltaTransform::decodeNumber(const uint8_t *&tags, const uint8_t *tagsEnd, const uint8_t *&numbers,
+                                         const uint8_t *numbersEnd, std::vector<uint8_t> &out)
+{
+    uint64_t delta;
+    if (tags == tagsEnd || !readVarint(numbers, numbersEnd, delta))
+    {
+        return false;
+    }
+    uint8_t tag = *tags++;
+    uint8_t scale = tag & ~kUnaligned;
+    if (scale >= kMaxDigits)
+    {
+        return false;
+    }
+    Column &previous = m_columns[column()];
+    int64_t value;
+    if (tag & kUnaligned)
+    {
+        value = static_cast<int64_t>(static_cast<uint64_t>(previous.value) + unzigzag(delta));
+    }
+    else
+    {
+        int aligned = std::max(scale, previous.scale);
+        int64_t base;
+        if (!scaleUp(previous.value, aligned - previous.scale, base))
+        {
+            return false;
+        }
+        int64_t current = static_cast<int64_t>(static_cast<uint64_t>(base) + unzigzag(delta));
+        if (current % kPowers[aligned - scale] != 0)
+        {
+            return false;
+        }
+        value = current / kPowers[aligned - scale];
+    }
+    previous = Column{value, scale};
+    m_history = (m_history << 8) | kPlaceholder;
+    return formatNumber(value, scale, out);
+}
+
+// Cuts before a trailing run of number bytes, unless the run is too long to be one number
+size_t NumericDeltaTransform::cutBefore(const uint8_t *data, size_t length)
+{
+    size_t cut = length;
+    while (cut > 0 && isNumberByte(data[cut - 1]))
+    {
+        if (length - cut == kHoldBack)
+        {
+            return length;
+        }
+        --cut;
+    }
+    return cut;
+}
+
+// Multiplicative hash of the last 8 bytes of text, numbers counted as one placeholder byte
+size_t NumericDeltaTransform::column() const
+{
+    return static_cast<size_t>((m_history * 0x9E3779B97F4A7C15ull) >> (64 - kColumnBits));
+}
+
+// Constructor: Starts a zlib stream for one file
+ExportEncoder::ExportEncoder(ExportCodec codec, int level)
+    : m_codec(codec)
+{
+    memset(&m_stream, 0, sizeof(m_stream));
+    m_ready = deflateInit(&m_stream, level) == Z_OK;
+}
+
+ExportEncoder::~ExportEncoder()
+{
+    if (m_ready)
+    {
+        deflateEnd(&m_stream);
+    }
+}
+
+// Compresses one chunk, flushed so the receiver can decode it on its own
+bool ExportEncoder::encode(const uint8_t *data, size_t length, bool last, std::vector<uint8_t> &out, size_t &rawLength)
+{
+    out.clear();
+    rawLength = 0;
+    if (!m_ready)
+    {
+        return false;
+    }
+
+    const uint8_t *input = data;
+    size_t inputLength = length;
+    if (m_codec == ExportCodecDeltaDeflate)
+    {
+        m_input.insert(m_input.end(), data, data + length);
+        size_t cut = last ? m_input.size() : NumericDeltaTransform::cutBefore(m_input.data(), m_input.size());
+        m_block.clear();
+        m_delta.encode(m_input.data(), cut, m_block);
+        m_input.erase(m_input.begin(), m_input.begin() + static_cast<std::ptrdiff_t>(cut));
+        rawLength = cut;
+        input = m_block.data();
+        inputLength = m_block.size();
+    }
+    else
+    {
+        rawLength = length;
+    }
+
+    m_stream.next_in = const_cast<Bytef *>(input);
+    m_stream.avail_in = static_cast<uInt>(inputLength);
+    int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+    size_t produced = 0;
+    while (true)
+    {
+        out.resize(produced + std::max(kOutputStep, static_cast<size_t>(m_stream.avail_in) / 4));
+        m_stream.next_out = out.data() + produced;
+        m_stream.avail_out = static_cast<uInt>(out.size() - produced);
+        int status = deflate(&m_stream, flush);
+        produced = out.size() - m_stream.avail_out;
+        if (status == Z_STREAM_ERROR)
+        {
+            out.clear();
+            return false;
+        }
+        // A flush is complete once deflate() stops filling the whole output buffer
+        if (last ? status == Z_STREAM_END : m_stream.avail_out != 0)
+        {
+            break;
+        }
+    }
+    out.resize(produced);
+    return true;
+}
+
+// Constructor: Starts a zlib stream for one file
+ExportDecoder::ExportDecoder(ExportCodec codec)
+    : m_codec(codec)
+{
+    memset(&m_stream, 0, sizeof(m_stream));
+    m_ready = inflateInit(&m_stream) == Z_OK;
+}
+
+ExportDecoder::~ExportDecoder()
+{
+    if (m_ready)
+    {
+        inflateEnd(&m_stream);
+    }
+}
+
+// Decompresses one chunk; each chunk ends on a flush, so it inflates completely on its own
+bool ExportDecoder::decode(const uint8_t *data, size_t length, std::vector<uint8_t> &out)
+{
+    out.clear();
+    if (!m_ready)
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> &target = m_codec == ExportCodecDeltaDeflate ? m_block : out;
+    target.clear();
+    m_stream.next_in = const_cast<Bytef *>(data);
+    m_stream.avail_in = static_cast<uInt>(length);
+    size_t produced = 0;
+    while (true)
+    {
+        target.resize(produced + std::max(kOutputStep, static_cast<size_t>(m_stream.avail_in) * 4));
+        m_stream.next_out = target.data() + produced;
+        m_stream.avail_out = static_cast<uInt>(target.size() - produced);
+        int status = inflate(&m_stream, Z_SYNC_FLUSH);
+        produced = target.size() - m_stream.avail_out;
+        if (status != Z_OK && status != Z_BUF_ERROR && status != Z_STREAM_END)
+        {
+            return false;
+        }
+        if (status == Z_STREAM_END || (m_stream.avail_in == 0 && m_stream.avail_out != 0))
+        {
+            break;
+        }
+    }
+    target.resize(produced);
+
+    if (m_codec == ExportCodecDeltaDeflate)
+    {
+        return m_delta.decode(m_block.data(), m_block.size(), out);
+    }
+    return true;
+}
@@ -0,0 +1,141 @@
+#ifndef EXPORTCODEC_H
+#define EXPORTCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <zlib.h>
+
+// Compression of exported files, negotiated per connection (see ExportFraming.h):
+//   - ExportCodecNone: raw bytes.
+//   - ExportCodecDeflate: one zlib stream per file.
+//   - ExportCodecDeltaDeflate: NumericDeltaTransform, then one zlib stream per file.
+// Files are coded chunk by chunk; every chunk is sync-flushed, so the receiver can decode it on arrival
+// and memory on both sides stays bounded by the chunk size.
+enum ExportCodec : uint8_t
+{
+    ExportCodecNone = 0,
+    ExportCodecDeflate = 1,
+    ExportCodecDeltaDeflate = 2,
+    ExportCodecCount
+};
+
+// Function: Name of a codec in the logs (e.g., "delta+deflate").
+const char *exportCodecName(ExportCodec codec);
+
+// Class: NumericDeltaTransform
+// Description: Reversible preprocessing of text with numeric series, such as the JSON logs
+//              ({"Speed":12.5,"RPM":1250} repeated thousands of times). Every plain decimal number (optional
+//              minus sign, at most 18 digits, optional fraction, not part of a word or exponent) is
+//              replaced in the text by a one-byte placeholder; its number of fraction digits goes to a tag
+//              stream and its digits, as an integer, to a number stream. Each number is stored as the
+//              zigzag varint difference to the previous number of its column, both aligned to the longer
+//              fraction (12.3 after 12.25 is +5 hundredths); the column is a hash of the 8 bytes of text
+//              with placeholders before the number (e.g., `{"Speed":`), so each key gets its own series.
+//              The text left is nearly constant and the differences are mostly one small byte, which
+//              deflate then shrinks far better than the original text.
+//              Any segmentation of the input decodes to the same bytes; the encoder and the decoder keep
+//              their column state and text history across chunks of one file.
+//              One transformed block: varint text length, varint number count, text, tags, differences.
+class NumericDeltaTransform
+{
+public:
+    NumericDeltaTransform() { reset(); }
+
+    // Function: Clears the column state and the text history for a new file.
+    void reset();
+
+    // Function: Appends the transformed block of one chunk of input to out.
+    void encode(const uint8_t *data, size_t length, std::vector<uint8_t> &out);
+
+    // Function: Appends the original bytes of one transformed block to out.
+    // Returns: false if the block is malformed.
+    bool decode(const uint8_t *data, size_t length, std::vector<uint8_t> &out);
+
+    // Function: Length of the input prefix that does not end inside a number, so a chunk can stop there
+    //           and keep the number whole; length if no such cut is close to the end.
+    static size_t cutBefore(const uint8_t *data, size_t length);
+
+private:
+    static constexpr int kColumnBits = 6;
+
+    // Function: Column of the next number, from the text history.
+    size_t column() const;
+
+    // Function: Decodes the next number of a block from its tag and difference and appends it to out.
+    bool decodeNumber(const uint8_t *&tags, const uint8_t *tagsEnd, const uint8_t *&numbers, const uint8_t *numbersEnd,
+                      std::vector<uint8_t> &out);
+
+    // Struct: Last number of a column: its digits as an integer and its fraction digits.
+    struct Column
+    {
+        int64_t value;
+        uint8_t scale;
+    };
+
+    // Member: Last number of every column, and the last 8 bytes of text with placeholders.
+    Column m_columns[1 << kColumnBits];
+    uint64_t m_history;
+
+    // Member: Scratch streams of the encoder.
+    std::vector<uint8_t> m_text;
+    std::vector<uint8_t> m_tags;
+    std::vector<uint8_t> m_numbers;
+};
+
+// Class: ExportEncoder
+// Description: Compresses one file chunk by chunk.
+class ExportEncoder
+{
+public:
+    // Constructor: Starts the stream of one file.
+    // Parameters:
+    //   - codec: ExportCodecDeflate or ExportCodecDeltaDeflate.
+    //   - level: zlib compression level.
+    explicit ExportEncoder(ExportCodec codec, int level = Z_DEFAULT_COMPRESSION);
+    ~ExportEncoder();
+
+    ExportEncoder(const ExportEncoder &) = delete;
+    ExportEncoder &operator=(const ExportEncoder &) = delete;
+
+    // Function: Compresses the next input bytes into one chunk in out (replacing its contents). Unless last,
+    //           the delta codec may keep a few trailing bytes back for the next call so no number is split.
+    // Parameters:
+    //   - last: true for the final input of the file; finishes the stream.
+    //   - rawLength: Set to the original bytes the chunk decodes to.
+    // Returns: false on a zlib error.
+    bool encode(const uint8_t *data, size_t length, bool last, std::vector<uint8_t> &out, size_t &rawLength);
+
+private:
+    ExportCodec m_codec;
+    z_stream m_stream;
+    bool m_ready;
+    NumericDeltaTransform m_delta;
+    std::vector<uint8_t> m_input;
+    std::vector<uint8_t> m_block;
+};
+
+// Class: ExportDecoder
+// Description: Decompresses one file chunk by chunk.
+class ExportDecoder
+{
+public:
+    explicit ExportDecoder(ExportCodec codec);
+    ~ExportDecoder();
+
+    ExportDecoder(const ExportDecoder &) = delete;
+    ExportDecoder &operator=(const ExportDecoder &) = delete;
+
+    // Function: Decompresses one chunk produced by ExportEncoder::encode() into out (replacing its contents).
+    // Returns: false if the chunk is corrupt.
+    bool decode(const uint8_t *data, size_t length, std::vector<uint8_t> &out);
+
+private:
+    ExportCodec m_codec;
+    z_stream m_stream;
+    bool m_ready;
+    NumericDeltaTransform m_delta;
+    std::vector<uint8_t> m_block;
+};
+
+#endif // EXPORTCODEC_H
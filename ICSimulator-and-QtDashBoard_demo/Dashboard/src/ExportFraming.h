@@ -0,0 +1,89 @@
+#ifndef EXPORTFRAMING_H
+#define EXPORTFRAMING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <endian.h>
+
+// Framing of the log export stream (see ExportService). Right after connecting, the Dashboard sends a hello
+// header offering its codecs (see ExportCodec.h) and the receiver answers with a hello naming the one it
+// picked; the receiver sends nothing else. The Dashboard then sends every file of a batch back to back over
+// the persistent connection, each as a 16-byte header, the file name and the file data; a header with no
+// flags, an empty name and no data ends the batch. Header fields, big-endian:
+//   - magic: "SGEX".
+//   - version: kExportVersion.
+//   - flags: kExportHelloFlag for a hello, otherwise the codec of the file data (0 at the end of a batch).
+//   - nameLength: Bytes of the file name (without directory) following the header; 0 in a hello.
+//   - dataLength: Bytes of the original file. In a hello, the bit mask of the offered codecs (1 << codec),
+//                 or the codec picked in the answer.
+// With ExportCodecNone the file bytes follow the name as they are. With another codec they follow as
+// chunks, each an 8-byte header (big-endian compressed length and original length) and the compressed
+// bytes, until the original lengths add up to dataLength; an empty file still has one chunk.
+static constexpr char kExportMagic[4] = {'S', 'G', 'E', 'X'};
+static constexpr uint8_t kExportVersion = 2;
+static constexpr size_t kExportHeaderSize = 16;
+static constexpr uint8_t kExportHelloFlag = 0x80;
+static constexpr size_t kExportChunkHeaderSize = 8;
+
+// Struct: ExportFrameHeader
+// Description: Decoded header of one exported file, of a hello, or of the end of a batch.
+struct ExportFrameHeader
+{
+    uint8_t version;
+    uint8_t flags;
+    uint16_t nameLength;
+    uint64_t dataLength;
+
+    bool hello() const { return flags == kExportHelloFlag && nameLength == 0; }
+    bool endOfBatch() const { return flags == 0 && nameLength == 0 && dataLength == 0; }
+};
+
+// Function: Writes a header in its wire layout.
+inline void encodeExportFrameHeader(const ExportFrameHeader &header, uint8_t out[kExportHeaderSize])
+{
+    uint16_t nameLength = htobe16(header.nameLength);
+    uint64_t dataLength = htobe64(header.dataLength);
+    memcpy(out, kExportMagic, sizeof(kExportMagic));
+    out[4] = header.version;
+    out[5] = header.flags;
+    memcpy(out + 6, &nameLength, sizeof(nameLength));
+    memcpy(out + 8, &dataLength, sizeof(dataLength));
+}
+
+// Function: Reads a header from its wire layout.
+// Returns: false if the magic or the version does not match.
+inline bool decodeExportFrameHeader(const uint8_t in[kExportHeaderSize], ExportFrameHeader &header)
+{
+    if (memcmp(in, kExportMagic, sizeof(kExportMagic)) != 0 || in[4] != kExportVersion)
+    {
+        return false;
+    }
+    uint16_t nameLength;
+    uint64_t dataLength;
+    memcpy(&nameLength, in + 6, sizeof(nameLength));
+    memcpy(&dataLength, in + 8, sizeof(dataLength));
+    header.version = in[4];
+    header.flags = in[5];
+    header.nameLength = be16toh(nameLength);
+    header.dataLength = be64toh(dataLength);
+    return true;
+}
+
+// Function: Writes a chunk header: compressed and original lengths.
+inline void encodeExportChunkHeader(uint32_t wireLength, uint32_t rawLength, uint8_t out[kExportChunkHeaderSize])
+{
+    uint32_t lengths[2] = {htobe32(wireLength), htobe32(rawLength)};
+    memcpy(out, lengths, sizeof(lengths));
+}
+
+// Function: Reads a chunk header.
+inline void decodeExportChunkHeader(const uint8_t in[kExportChunkHeaderSize], uint32_t &wireLength, uint32_t &rawLength)
+{
+    uint32_t lengths[2];
+    memcpy(lengths, in, sizeof(lengths));
+    wireLength = be32toh(lengths[0]);
+    rawLength = be32toh(lengths[1]);
+}
+
+#endif // EXPORTFRAMING_H
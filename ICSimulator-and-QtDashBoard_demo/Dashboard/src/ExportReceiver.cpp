@@ -0,0 +1,356 @@
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include "ExportCodec.h"
+#include "ExportFraming.h"
+
+// Reference receiver of the Dashboard log export (see ExportService and ExportFraming.h): accepts the
+// Dashboard's connection, picks the best codec the Dashboard offers, stores every file of each batch under its
+// name in the output directory and prints one line per batch with its files, bytes, compression ratio and
+// throughput. With --discard the data is read and dropped, to measure the transfer alone. A receiver on the
+// Autoware side follows the same loop.
+
+// Struct: ReceiverOptions
+// Description: Command-line settings.
+//   - address: IPv4 address to listen on.
+//   - port: TCP port to listen on (the Dashboard's <port> argument).
+//   - directory: Directory the files are written to.
+//   - discard: Read the data without writing it.
+//   - batches: Exit after this many batches; 0 to run until interrupted.
+//   - compress: Accept the compressed codecs; otherwise ask for the files as they are.
+struct ReceiverOptions
+{
+    std::string address = "0.0.0.0";
+    int port = 5000;
+    std::string directory = ".";
+    bool discard = false;
+    long batches = 0;
+    bool compress = true;
+};
+
+// Read buffer for file data
+static constexpr size_t kBufferSize = 1 << 20;
+
+// Largest compressed chunk accepted, to bound memory against a corrupt chunk header
+static constexpr uint32_t kMaxChunkSize = 64 << 20;
+
+// Function: Reads exactly length bytes.
+// Returns: false if the connection closed or failed first.
+static bool readAll(int fd, void *data, size_t length)
+{
+    char *bytes = static_cast<char *>(data);
+    while (length > 0)
+    {
+        ssize_t n = recv(fd, bytes, length, 0);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        bytes += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Function: Receives one file's data into out (-1 to discard).
+static bool receiveData(int fd, int out, uint64_t length, std::vector<char> &buffer)
+{
+    while (length > 0)
+    {
+        size_t chunk = length < buffer.size() ? static_cast<size_t>(length) : buffer.size();
+        ssize_t n = recv(fd, buffer.data(), chunk, 0);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            return false;
+        }
+        if (out >= 0 && write(out, buffer.data(), static_cast<size_t>(n)) != n)
+        {
+            perror("write");
+            return false;
+        }
+        length -= static_cast<uint64_t>(n);
+    }
+    return true;
+}
+
+// Function: Receives one file's compressed chunks, decoding them into out (-1 to discard).
+// Parameters:
+//   - length: Original bytes of the file.
+//   - wireBytes: Incremented by the bytes of the chunks received.
+static bool receiveCompressed(int fd, int out, uint64_t length, ExportCodec codec, uint64_t &wireBytes)
+{
+    ExportDecoder decoder(codec);
+    std::vector<uint8_t> chunk;
+    std::vector<uint8_t> decoded;
+    uint64_t received = 0;
+    do
+    {
+        uint8_t raw[kExportChunkHeaderSize];
+        uint32_t wireLength, rawLength;
+        if (!readAll(fd, raw, sizeof(raw)))
+        {
+            return false;
+        }
+        decodeExportChunkHeader(raw, wireLength, rawLength);
+        if (wireLength > kMaxChunkSize || rawLength > length - received)
+        {
+            fprintf(stderr, "Invalid chunk header\n");
+            return false;
+        }
+        chunk.resize(wireLength);
+        if (!readAll(fd, chunk.data(), chunk.size()))
+        {
+            return false;
+        }
+        if (!decoder.decode(chunk.data(), chunk.size(), decoded) || decoded.size() != rawLength)
+        {
+            fprintf(stderr, "Corrupt %s chunk\n", exportCodecName(codec));
+            return false;
+        }
+        if (out >= 0 && write(out, decoded.data(), decoded.size()) != static_cast<ssize_t>(decoded.size()))
+        {
+            perror("write");
+            return false;
+        }
+        received += rawLength;
+        wireBytes += sizeof(raw) + wireLength;
+    } while (received < length);
+    return true;
+}
+
+// Function: Answers the Dashboard's hello with the best codec it offers.
+// Returns: The codec, or ExportCodecCount if the hello is invalid or no offered codec is acceptable.
+static ExportCodec negotiateCodec(int fd, const ReceiverOptions &options)
+{
+    uint8_t raw[kExportHeaderSize];
+    ExportFrameHeader hello;
+    if (!readAll(fd, raw, sizeof(raw)) || !decodeExportFrameHeader(raw, hello) || !hello.hello())
+    {
+        fprintf(stderr, "Invalid export hello, closing the connection\n");
+        return ExportCodecCount;
+    }
+    static const ExportCodec kPreference[] = {ExportCodecDeltaDeflate, ExportCodecDeflate, ExportCodecNone};
+    for (ExportCodec codec : kPreference)
+    {
+        if ((codec == ExportCodecNone || options.compress) && (hello.dataLength & (1u << codec)))
+        {
+            encodeExportFrameHeader(ExportFrameHeader{kExportVersion, kExportHelloFlag, 0, codec}, raw);
+            if (send(fd, raw, sizeof(raw), MSG_NOSIGNAL) != static_cast<ssize_t>(sizeof(raw)))
+            {
+                return ExportCodecCount;
+            }
+            printf("Dashboard connected, codec %s\n", exportCodecName(codec));
+            fflush(stdout);
+            return codec;
+        }
+    }
+    fprintf(stderr, "No acceptable codec offered, closing the connection\n");
+    return ExportCodecCount;
+}
+
+// Function: Serves one connection until the Dashboard closes it.
+// Returns: Batches received.
+static long serveConnection(int fd, const ReceiverOptions &options, long remaining)
+{
+    ExportCodec codec = negotiateCodec(fd, options);
+    if (codec == ExportCodecCount)
+    {
+        return 0;
+    }
+
+    std::vector<char> buffer(kBufferSize);
+    long batches = 0;
+    int files = 0;
+    uint64_t bytes = 0;
+    uint64_t wireBytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    bool inBatch = false;
+    uint8_t raw[kExportHeaderSize];
+    while (readAll(fd, raw, sizeof(raw)))
+    {
+        ExportFrameHeader header;
+        if (!decodeExportFrameHeader(raw, header) || (header.flags != ExportCodecNone && header.flags != codec))
+        {
+            fprintf(stderr, "Invalid export header, closing the connection\n");
+            break;
+        }
+        if (header.endOfBatch())
+        {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            printf("batch %ld: %d files, %llu bytes, %llu on the wire (%.1fx), %.1f ms, %.1f MB/s\n", ++batches, files,
+                   static_cast<unsigned long long>(bytes), static_cast<unsigned long long>(wireBytes),
+                   wireBytes > 0 ? static_cast<double>(bytes) / wireBytes : 1.0, seconds * 1000.0,
+                   seconds > 0.0 ? bytes / seconds / 1e6 : 0.0);
+            fflush(stdout);
+            if (remaining > 0 && batches >= remaining)
+            {
+                break;
+            }
+            files = 0;
+            bytes = 0;
+            wireBytes = 0;
+            inBatch = false;
+            continue;
+        }
+        if (!inBatch)
+        {
+            // A batch is timed from its first header
+            start = std::chrono::steady_clock::now();
+            inBatch = true;
+        }
+
+        std::string name(header.nameLength, '\0');
+        if (!readAll(fd, &name[0], name.size()))
+        {
+            break;
+        }
+        if (name.find('/') != std::string::npos || name == "." || name == "..")
+        {
+            fprintf(stderr, "Refusing file name %s\n", name.c_str());
+            break;
+        }
+        int out = -1;
+        if (!options.discard)
+        {
+            std::string path = options.directory + "/" + name;
+            out = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (out < 0)
+            {
+                perror(path.c_str());
+            }
+        }
+        bool ok;
+        if (header.flags == ExportCodecNone)
+        {
+            ok = receiveData(fd, out, header.dataLength, buffer);
+            wireBytes += header.dataLength;
+        }
+        else
+        {
+            ok = receiveCompressed(fd, out, header.dataLength, codec, wireBytes);
+        }
+        if (out >= 0)
+        {
+            close(out);
+        }
+        if (!ok)
+        {
+            fprintf(stderr, "Connection lost in %s\n", name.c_str());
+            break;
+        }
+        ++files;
+        bytes += header.dataLength;
+    }
+    return batches;
+}
+
+// Function: Prints the command-line usage.
+static void printUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --address IP   address to listen on (default 0.0.0.0)\n"
+            "  --port N       port to listen on (default 5000)\n"
+            "  --dir PATH     directory for the received files (default .)\n"
+            "  --discard 1    read the data without writing it\n"
+            "  --batches N    exit after N batches (default: run until interrupted)\n"
+            "  --compress 0   ask for uncompressed files (default 1: best codec offered)\n",
+            program);
+}
+
+int main(int argc, char *argv[])
+{
+    ReceiverOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            printUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--address")
+        {
+            options.address = value;
+        }
+        else if (arg == "--port" && atoi(value.c_str()) > 0 && atoi(value.c_str()) < 65536)
+        {
+            options.port = atoi(value.c_str());
+        }
+        else if (arg == "--dir")
+        {
+            options.directory = value;
+        }
+        else if (arg == "--discard")
+        {
+            options.discard = value != "0";
+        }
+        else if (arg == "--batches" && atol(value.c_str()) >= 0)
+        {
+            options.batches = atol(value.c_str());
+        }
+        else if (arg == "--compress")
+        {
+            options.compress = value != "0";
+        }
+        else
+        {
+            fprintf(stderr, "Invalid option %s %s\n", arg.c_str(), value.c_str());
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    int listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(options.port));
+    if (inet_pton(AF_INET, options.address.c_str(), &address.sin_addr) != 1 ||
+        bind(listener, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0 || listen(listener, 4) < 0)
+    {
+        perror("Export listener");
+        return 1;
+    }
+    printf("Waiting for the Dashboard export on %s:%d\n", options.address.c_str(), options.port);
+    fflush(stdout);
+
+    long received = 0;
+    while (options.batches == 0 || received < options.batches)
+    {
+        int fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            perror("accept");
+            return 1;
+        }
+        received += serveConnection(fd, options, options.batches ? options.batches - received : 0);
+        close(fd);
+    }
+    close(listener);
+    return 0;
+}
@@ -0,0 +1,450 @@
+#include "ExportService.h"
+#include "ExportFraming.h"
+#include <QDebug>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Connection attempt timeout, and the send timeout after which a stalled receiver fails the batch
+static constexpr int kConnectTimeoutMs = 2000;
+static constexpr int kSendTimeoutS = 5;
+
+// Attempts per batch and the delay between them
+static constexpr int kMaxAttempts = 3;
+static constexpr std::chrono::milliseconds kRetryDelay(500);
+
+// Largest chunk handed to one sendfile() call
+static constexpr size_t kSendfileChunk = 1 << 20;
+
+// File bytes compressed per chunk: small enough to keep memory bounded and to start sending early, large
+// enough for deflate to find the repetitions of the logs
+static constexpr size_t kCompressChunk = 256 * 1024;
+
+// Constructor: Starts the export thread
+ExportService::ExportService(const QString &host, quint16 port, bool compress)
+    : m_host(host.toStdString()), m_port(port),
+      m_codecs(compress ? (1u << ExportCodecNone) | (1u << ExportCodecDeflate) | (1u << ExportCodecDeltaDeflate)
+                        : (1u << ExportCodecNone)),
+      m_fd(-1), m_codec(ExportCodecNone), m_stop(false)
+{
+    m_thread = std::thread(&ExportService::run, this);
+}
+
+// Destructor: Stops the export thread after its current job
+ExportService::~ExportService()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wakeCv.notify_one();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+    disconnect();
+}
+
+// Queues a job for the export thread
+void ExportService::submit(const QStringList &files, const std::function<void()> &prepare)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(Job{files, prepare});
+    }
+    m_wakeCv.notify_one();
+}
+
+// Returns the totals so far
+ExportService::Stats ExportService::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+// Export thread: runs the queued jobs in order
+void ExportService::run()
+{
+    // sendfile() to a connection the peer reset raises SIGPIPE on this thread; blocked, it fails with EPIPE
+    sigset_t pipe;
+    sigemptyset(&pipe);
+    sigaddset(&pipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipe, nullptr);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_wakeCv.wait(lock, [this] { return m_stop || !m_jobs.empty(); });
+        if (m_stop)
+        {
+            break;
+        }
+        Job job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+        lock.unlock();
+
+        if (job.prepare)
+        {
+            job.prepare();
+        }
+        if (!job.files.isEmpty())
+        {
+            sendBatch(job.files);
+        }
+
+        lock.lock();
+    }
+    if (!m_jobs.empty())
+    {
+        qWarning() << "Export service stopped with" << m_jobs.size() << "jobs pending";
+    }
+}
+
+// Sends one batch, retrying from its first file on a fresh connection
+void ExportService::sendBatch(const QStringList &files)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int attempt = 1; attempt <= kMaxAttempts; ++attempt)
+    {
+        uint64_t bytes = 0;
+        uint64_t wireBytes = 0;
+        int sent = 0;
+        if (ensureConnected() && sendFiles(files, bytes, wireBytes, sent))
+        {
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_stats.batches;
+                m_stats.files += static_cast<uint64_t>(sent);
+                m_stats.bytes += bytes;
+                m_stats.wireBytes += wireBytes;
+            }
+            qInfo().noquote() << QString("Sent %1 files (%2 bytes, %3 on the wire with %4, %5x) to %6:%7 in %8 ms, "
+                                         "%9 MB/s")
+                                     .arg(sent)
+                                     .arg(bytes)
+                                     .arg(wireBytes)
+                                     .arg(QString::fromLatin1(exportCodecName(m_codec)))
+                                     .arg(wireBytes > 0 ? double(bytes) / wireBytes : 1.0, 0, 'f', 1)
+                                     .arg(QString::fromStdString(m_host))
+                                     .arg(m_port)
+                                     .arg(seconds * 1000.0, 0, 'f', 1)
+                                     .arg(seconds > 0.0 ? bytes / seconds / 1e6 : 0.0, 0, 'f', 1);
+            return;
+        }
+
+        disconnect();
+        qWarning() << "Attempt" << attempt << "to send" << files.size() << "files to"
+                   << QString::fromStdString(m_host) << ":" << m_port << "failed";
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (attempt == kMaxAttempts || m_wakeCv.wait_for(lock, kRetryDelay, [this] { return m_stop; }))
+        {
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_stats.failures;
+    qWarning() << "Failed to send" << files.size() << "files to" << QString::fromStdString(m_host) << ":" << m_port;
+}
+
+// Sends the files of a batch and its end marker
+bool ExportService::sendFiles(const QStringList &files, uint64_t &bytes, uint64_t &wireBytes, int &sent)
+{
+    for (const QString &file : files)
+    {
+        std::string path = file.toStdString();
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) < 0)
+        {
+            qWarning() << "Export file" << file << "skipped:" << strerror(errno);
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+            continue;
+        }
+        std::string name = path.substr(path.find_last_of('/') + 1);
+        uint64_t size = static_cast<uint64_t>(st.st_size);
+        bool ok;
+        if (m_codec == ExportCodecNone)
+        {
+            ok = sendFile(fd, name, size);
+            wireBytes += size;
+        }
+        else
+        {
+            ok = sendCompressedFile(fd, name, size, wireBytes);
+        }
+        close(fd);
+        if (!ok)
+        {
+            qWarning() << "Failed to send" << file;
+            return false;
+        }
+        bytes += static_cast<uint64_t>(st.st_size);
+        ++sent;
+    }
+
+    uint8_t end[kExportHeaderSize];
+    encodeExportFrameHeader(ExportFrameHeader{kExportVersion, 0, 0, 0}, end);
+    return sendAll(end, sizeof(end), 0);
+}
+
+// Sends the framing header and the name of a file; MSG_MORE holds them back to share a segment with the data
+bool ExportService::sendFileHeader(const std::string &name, uint64_t size)
+{
+    uint8_t header[kExportHeaderSize];
+    ExportFrameHeader frame{kExportVersion, m_codec, static_cast<uint16_t>(name.size()), size};
+    encodeExportFrameHeader(frame, header);
+    std::string prefix(reinterpret_cast<const char *>(header), sizeof(header));
+    prefix += name;
+    // A compressed file always has at least one chunk
+    return sendAll(prefix.data(), prefix.size(), size > 0 || m_codec != ExportCodecNone ? MSG_MORE : 0);
+}
+
+// Sends one file: framing header and name, then its data straight from the page cache
+bool ExportService::sendFile(int fd, const std::string &name, uint64_t size)
+{
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    if (!sendFileHeader(name, size))
+    {
+        return false;
+    }
+
+    off_t offset = 0;
+    while (static_cast<uint64_t>(offset) < size)
+    {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(size - static_cast<uint64_t>(offset), kSendfileChunk));
+        ssize_t n = sendfile(m_fd, fd, &offset, chunk);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            // 0: the file shrank under us, and the receiver still expects the announced length
+            qWarning() << "Export sendfile failed:" << (n == 0 ? "file truncated while sending" : strerror(errno));
+            return false;
+        }
+    }
+    return true;
+}
+
+// Sends one file compressed: each chunk is read, encoded and handed to the socket before the next is read
+bool ExportService::sendCompressedFile(int fd, const std::string &name, uint64_t size, uint64_t &wireBytes)
+{
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    if (!sendFileHeader(name, size))
+    {
+        return false;
+    }
+
+    ExportEncoder encoder(m_codec);
+    m_chunk.resize(kCompressChunk);
+    uint64_t remaining = size;
+    do
+    {
+        size_t length = static_cast<size_t>(std::min<uint64_t>(remaining, kCompressChunk));
+        size_t done = 0;
+        while (done < length)
+        {
+            ssize_t n = read(fd, m_chunk.data() + done, length - done);
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (n <= 0)
+            {
+                qWarning() << "Export read failed:" << (n == 0 ? "file truncated while sending" : strerror(errno));
+                return false;
+            }
+            done += static_cast<size_t>(n);
+        }
+        remaining -= length;
+
+        size_t rawLength;
+        if (!encoder.encode(m_chunk.data(), length, remaining == 0, m_encoded, rawLength))
+        {
+            qWarning() << "Export compression failed for" << QString::fromStdString(name);
+            return false;
+        }
+        uint8_t chunkHeader[kExportChunkHeaderSize];
+        encodeExportChunkHeader(static_cast<uint32_t>(m_encoded.size()), static_cast<uint32_t>(rawLength), chunkHeader);
+        if (!sendAll(chunkHeader, sizeof(chunkHeader), MSG_MORE) || !sendAll(m_encoded.data(), m_encoded.size(), 0))
+        {
+            return false;
+        }
+        wireBytes += sizeof(chunkHeader) + m_encoded.size();
+    } while (remaining > 0);
+    return true;
+}
+
+// Writes a whole buffer to the connection
+bool ExportService::sendAll(const void *data, size_t length, int flags)
+{
+    const char *bytes = static_cast<const char *>(data);
+    while (length > 0)
+    {
+        ssize_t n = send(m_fd, bytes, length, flags | MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            qWarning() << "Export send failed:" << strerror(errno);
+            return false;
+        }
+        bytes += n;
+        length -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Opens the connection unless the open one is still usable
+bool ExportService::ensureConnected()
+{
+    if (m_fd >= 0)
+    {
+        // The receiver sends nothing after the hello, so readability means it closed or reset the connection
+        struct pollfd poller = {m_fd, POLLIN | POLLRDHUP, 0};
+        if (poll(&poller, 1, 0) == 0)
+        {
+            return true;
+        }
+        qInfo() << "Export connection closed by" << QString::fromStdString(m_host) << ", reconnecting";
+        disconnect();
+    }
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(m_port);
+    if (inet_pton(AF_INET, m_host.c_str(), &address.sin_addr) != 1)
+    {
+        qWarning() << "Invalid export address" << QString::fromStdString(m_host);
+        return false;
+    }
+
+    m_fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (m_fd < 0)
+    {
+        qWarning() << "Failed to create export socket:" << strerror(errno);
+        return false;
+    }
+
+    // Non-blocking connect bounded by kConnectTimeoutMs
+    int error = 0;
+    if (connect(m_fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0)
+    {
+        error = errno;
+        if (error == EINPROGRESS)
+        {
+            struct pollfd poller = {m_fd, POLLOUT, 0};
+            socklen_t length = sizeof(error);
+            if (poll(&poller, 1, kConnectTimeoutMs) <= 0)
+            {
+                error = ETIMEDOUT;
+            }
+            else if (getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0)
+            {
+                error = errno;
+            }
+        }
+    }
+    if (error != 0)
+    {
+        qWarning() << "Failed to connect to" << QString::fromStdString(m_host) << ":" << m_port << ":"
+                   << strerror(error);
+        disconnect();
+        return false;
+    }
+
+    // Blocking from here on, with a send timeout so a stalled receiver cannot hold the thread forever
+    fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) & ~O_NONBLOCK);
+    struct timeval timeout = {kSendTimeoutS, 0};
+    setsockopt(m_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    int keepAlive = 1;
+    setsockopt(m_fd, SOL_SOCKET, SO_KEEPALIVE, &keepAlive, sizeof(keepAlive));
+    if (!negotiateCodec())
+    {
+        disconnect();
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_stats.connects;
+    qInfo() << "Export connection to" << QString::fromStdString(m_host) << ":" << m_port << "opened, codec"
+            << exportCodecName(m_codec);
+    return true;
+}
+
+// Sends the hello with the offered codecs and waits up to kConnectTimeoutMs for the receiver's answer
+bool ExportService::negotiateCodec()
+{
+    uint8_t hello[kExportHeaderSize];
+    encodeExportFrameHeader(ExportFrameHeader{kExportVersion, kExportHelloFlag, 0, m_codecs}, hello);
+    if (!sendAll(hello, sizeof(hello), 0))
+    {
+        return false;
+    }
+
+    size_t received = 0;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kConnectTimeoutMs);
+    while (received < sizeof(hello))
+    {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        struct pollfd poller = {m_fd, POLLIN, 0};
+        if (left.count() <= 0 || poll(&poller, 1, static_cast<int>(left.count())) == 0)
+        {
+            qWarning() << "No export hello from" << QString::fromStdString(m_host) << ":" << m_port;
+            return false;
+        }
+        ssize_t n = recv(m_fd, hello + received, sizeof(hello) - received, MSG_DONTWAIT);
+        if (n < 0 && (errno == EINTR || errno == EAGAIN))
+        {
+            continue;
+        }
+        if (n <= 0)
+        {
+            qWarning() << "Export hello failed:" << (n == 0 ? "connection closed" : strerror(errno));
+            return false;
+        }
+        received += static_cast<size_t>(n);
+    }
+
+    ExportFrameHeader answer;
+    if (!decodeExportFrameHeader(hello, answer) || !answer.hello() || answer.dataLength >= ExportCodecCount ||
+        !(m_codecs & (1u << answer.dataLength)))
+    {
+        qWarning() << "Invalid export hello from" << QString::fromStdString(m_host) << ":" << m_port;
+        return false;
+    }
+    m_codec = static_cast<ExportCodec>(answer.dataLength);
+    return true;
+}
+
+// Closes the connection
+void ExportService::disconnect()
+{
+    if (m_fd >= 0)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
@@ -0,0 +1,147 @@
+#ifndef EXPORTSERVICE_H
+#define EXPORTSERVICE_H
+
+#include "ExportCodec.h"
+#include <QString>
+#include <QStringList>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Class: ExportService
+// Description: Sends exported log files to Autoware from its own thread, so neither the GUI nor the TCP
+//              control thread waits for a transfer. Jobs run in submission order; each first runs its
+//              prepare step (e.g., converting the captures to JSON) and then streams its files back to back
+//              over one persistent TCP connection in the ExportFraming.h layout, ending with an end-of-batch
+//              header. The codec is negotiated when the connection opens. Uncompressed, file data goes from
+//              the page cache to the socket with sendfile(), without being copied through user space, and
+//              the header is sent with MSG_MORE so it shares a segment with the first data bytes.
+//              Compressed, a file is read and encoded one chunk at a time, so memory stays bounded by the
+//              chunk whatever the file size, and each chunk is sent as soon as it is encoded: the kernel
+//              transmits it from the socket buffer while the next one is being compressed.
+//              The connection is opened on the first job and kept; a connection the peer closed is
+//              reopened, and a batch that fails is retried from its first file.
+class ExportService
+{
+public:
+    // Struct: Stats
+    // Description: Totals since the service started.
+    //   - batches: Batches sent completely.
+    //   - files: Files sent.
+    //   - bytes: File bytes sent.
+    //   - wireBytes: Bytes of file data on the wire, after compression.
+    //   - connects: Connections opened.
+    //   - failures: Batches given up after all attempts.
+    struct Stats
+    {
+        uint64_t batches = 0;
+        uint64_t files = 0;
+        uint64_t bytes = 0;
+        uint64_t wireBytes = 0;
+        uint64_t connects = 0;
+        uint64_t failures = 0;
+    };
+
+    // Constructor: Starts the export thread; nothing is connected until the first job.
+    // Parameters:
+    //   - host: IPv4 address of the receiver.
+    //   - port: TCP port of the receiver.
+    //   - compress: Offer the compressed codecs to the receiver; otherwise files are sent as they are.
+    ExportService(const QString &host, quint16 port, bool compress = true);
+
+    // Destructor: Finishes the running job, drops the queued ones and closes the connection.
+    ~ExportService();
+
+    ExportService(const ExportService &) = delete;
+    ExportService &operator=(const ExportService &) = delete;
+
+    // Function: Queues a job and returns at once. Any thread.
+    // Parameters:
+    //   - files: Files to send, in order; missing files are skipped with a warning. May be empty, which
+    //            only runs prepare after the jobs queued before it.
+    //   - prepare: Optional step run on the export thread before the files are sent.
+    void submit(const QStringList &files, const std::function<void()> &prepare = std::function<void()>());
+
+    // Function: Totals so far. Any thread.
+    Stats stats() const;
+
+private:
+    // Struct: One queued job.
+    struct Job
+    {
+        QStringList files;
+        std::function<void()> prepare;
+    };
+
+    // Function: Export thread body; runs the queued jobs.
+    void run();
+
+    // Function: Sends the files of a job as one batch, reconnecting and retrying on failure.
+    void sendBatch(const QStringList &files);
+
+    // Function: Sends every file and the end-of-batch header over the open connection.
+    // Returns: false on the first send error; the connection is then unusable.
+    bool sendFiles(const QStringList &files, uint64_t &bytes, uint64_t &wireBytes, int &sent);
+
+    // Function: Sends the header of a file in m_codec and its name.
+    bool sendFileHeader(const std::string &name, uint64_t size);
+
+    // Function: Sends one open file: header and name, then the file data with sendfile().
+    // Parameters:
+    //   - fd: File to send, read from offset 0.
+    //   - name: File name announced in the header.
+    //   - size: Bytes to send.
+    bool sendFile(int fd, const std::string &name, uint64_t size);
+
+    // Function: Sends one open file compressed with m_codec, chunk by chunk.
+    // Parameters:
+    //   - fd: File to send, read from offset 0.
+    //   - name: File name announced in the header.
+    //   - size: Bytes of the file.
+    //   - wireBytes: Incremented by the bytes of the chunks sent.
+    bool sendCompressedFile(int fd, const std::string &name, uint64_t size, uint64_t &wireBytes);
+
+    // Function: Writes a whole buffer to the connection.
+    bool sendAll(const void *data, size_t length, int flags);
+
+    // Function: Opens the connection unless it is open and the peer has not closed it.
+    bool ensureConnected();
+
+    // Function: Offers the codecs on a new connection and reads the receiver's choice into m_codec.
+    bool negotiateCodec();
+
+    // Function: Closes the connection.
+    void disconnect();
+
+    // Member: Receiver address.
+    std::string m_host;
+    uint16_t m_port;
+
+    // Member: Codecs offered, as a bit mask of 1 << ExportCodec.
+    uint64_t m_codecs;
+
+    // Member: Connected socket, or -1, and the codec negotiated on it. Export thread only.
+    int m_fd;
+    ExportCodec m_codec;
+
+    // Member: Read and compressed chunk buffers. Export thread only.
+    std::vector<uint8_t> m_chunk;
+    std::vector<uint8_t> m_encoded;
+
+    // Member: Job queue and totals, guarded by m_mutex.
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeCv;
+    std::deque<Job> m_jobs;
+    Stats m_stats;
+    bool m_stop;
+
+    // Member: Export thread.
+    std::thread m_thread;
+};
+
+#endif // EXPORTSERVICE_H
@@ -1,20 +1,27 @@
 #include "FlexrayReceiver.h"
+#include "PayloadCodec.hpp"
+#include "LatencyRecorder.h"
+#include "WireStats.h"
+#include "IoReactor.h"
+#include "Multicast.hpp"
 #include <QDebug>
-#include <nlohmann/json.hpp>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
-#include <iostream>
-#include <fstream>
-#include <sstream>
 
-using json = nlohmann::json;
+// Receive buffer size; larger than any frame the senders produce so oversize packets are detected
+static constexpr size_t kMaxPacketSize = 64;
+
+// Size of a legacy ASCII speed/RPM payload
+static constexpr size_t kPayloadSize = 8;
 
 // Constructor: Initializes FlexRay receiver with the specified IP and port
-FlexRayReceiver::FlexRayReceiver(const QString &ip, quint16 port, QObject *parent)
-    : QObject(parent), socketFd(-1)
+FlexRayReceiver::FlexRayReceiver(const QString &ip, quint16 port, SampleRing *ring, DropCounters *drops,
+                                 const BatchConfig &batchConfig, const QString &multicastGroup, QObject *parent)
+    : QObject(parent), socketFd(-1), m_batchReader(nullptr), m_ring(ring), m_drops(drops),
+      m_epoch(ring ? ring->epoch() : 0)
 {
     // Create a UDP socket for FlexRay communication
     socketFd = socket(AF_INET, SOCK_DGRAM, 0);
@@ -33,179 +40,156 @@ FlexRayReceiver::FlexRayReceiver(const QString &ip, quint16 port, QObject *paren
         qFatal("Invalid IP address: %s", ip.toStdString().c_str());
     }
 
-    // Bind the socket to the specified IP and port
-    if (bind(socketFd, (struct sockaddr *)&serverAddr, sizeof(serverAddr)) < 0)
-    {
-        qFatal("Failed to bind flexray socket to %s:%d", ip.toStdString().c_str(), port);
-    }
-
-    // Set up a socket notifier to handle incoming FlexRay packets
-    notifier = new QSocketNotifier(socketFd, QSocketNotifier::Read, this);
-    connect(notifier, &QSocketNotifier::activated, this, &FlexRayReceiver::readflexrayPacket);
-    qDebug() << "FlexRayReceiver initialized successfully for" << ip << ":" << port;
-
-    // Check if flexray_protocol_receiver.json exists and is valid
-    std::ifstream check_file("flexray_protocol_receiver.json");
-    bool needs_init = true;
-    if (check_file.is_open())
+    if (multicastGroup.isEmpty())
     {
-        // Read the content of the JSON file
-        std::stringstream buffer;
-        buffer << check_file.rdbuf();
-        std::string content = buffer.str();
-        check_file.close();
-
-        if (!content.empty())
+        // Bind the socket to the specified IP and port
+        if (bind(socketFd, (struct sockaddr *)&serverAddr, sizeof(serverAddr)) < 0)
         {
-            try
-            {
-                json temp = json::parse(content);
-                if (temp.is_array())
-                {
-                    needs_init = false; // Valid JSON array found, no initialization needed
-                }
-            }
-            catch (const json::exception &e)
-            {
-                qWarning() << "Existing flexray_protocol_receiver.json is invalid:" << e.what();
-                qWarning() << "File content:" << QString::fromStdString(content);
-            }
+            qFatal("Failed to bind flexray socket to %s:%d", ip.toStdString().c_str(), port);
         }
     }
-
-    // Initialize flexray_protocol_receiver.json with an empty array if invalid or missing
-    if (needs_init)
+    else
     {
-        std::ofstream json_file("flexray_protocol_receiver.json");
-        if (json_file.is_open())
+        // Bind the group and port instead, and join the group on the interface with address ip
+        struct in_addr group;
+        if (!mcast::parseAddress(multicastGroup.toStdString().c_str(), group) || !mcast::isMulticast(group))
         {
-            json_file << "[]";
-            json_file.close();
-            qDebug() << "Initialized flexray_protocol_receiver.json as empty array";
+            qFatal("Invalid multicast group: %s", multicastGroup.toStdString().c_str());
         }
-        else
+        if (!mcast::bindReceiver(socketFd, group, ntohs(serverAddr.sin_port), serverAddr.sin_addr))
         {
-            qWarning() << "Failed to initialize flexray_protocol_receiver.json";
+            qFatal("Failed to join flexray socket to %s:%d on %s: %s", multicastGroup.toStdString().c_str(),
+                   ntohs(serverAddr.sin_port), ip.toStdString().c_str(), strerror(errno));
         }
     }
+
+    // Drain the socket in batches; packets left over after the budget re-trigger the notifier
+    m_batchReader = new DatagramBatchReader(socketFd, kMaxPacketSize, batchConfig);
+
+    // Set up a socket notifier to handle incoming FlexRay packets
+    notifier = new QSocketNotifier(socketFd, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, &FlexRayReceiver::readflexrayPacket);
+    qDebug() << "FlexRayReceiver initialized successfully for" << ip << ":" << port;
 }
 
 // Destructor: Cleans up resources
 FlexRayReceiver::~FlexRayReceiver()
 {
+    logWireStats("FlexRay", m_sequence.stats());
+
     // Close the UDP socket if it was opened
     if (socketFd >= 0)
     {
         close(socketFd);
     }
-    // Delete the socket notifier
+    // Delete the socket notifier and the batch reader
     delete notifier;
+    delete m_batchReader;
 }
 
-// Saves JSON data to a specified file
-void FlexRayReceiver::saveJsonFile(const std::string &filename, const nlohmann::json &json_data)
+// Replaces the socket notifier by the I/O reactor
+void FlexRayReceiver::attachToReactor(IoReactor *reactor)
 {
-    std::ofstream file(filename);
-    if (!file.is_open())
+    delete notifier;
+    notifier = nullptr;
+    reactor->add(socketFd, "FlexRay", [this]() {
+        readflexrayPacket();
+        return m_batchReader->pending();
+    });
+}
+
+// Pushes the raw frame and decoded values to the FlexRay sample ring
+void FlexRayReceiver::publishSample(uint32_t id, const uint8_t *payload, float speed, float rpm, uint64_t timestampNs,
+                                    const wire::Frame *frame)
+{
+    SignalSample sample = {};
+    sample.timestampNs = timestampNs;
+    sample.id = id;
+    sample.length = kPayloadSize;
+    sample.fields = SpeedField | RpmField;
+    memcpy(sample.payload, payload, sizeof(sample.payload));
+    sample.speed = speed;
+    sample.rpm = rpm;
+    if (frame)
     {
-        qWarning() << "Failed to save JSON file:" << QString::fromStdString(filename);
-        return;
+        m_drops->updateSequence(m_sequence, *frame, stampLatency(sample, *frame, timestampNs));
+    }
+    if (m_ring && !m_ring->push(sample))
+    {
+        m_drops->addQueueOverflow();
     }
- 
-    // Write JSON data with 2-space indentation
-    file << json_data.dump(2);
-    file.close();
-    qDebug() << "Saved JSON file:" << QString::fromStdString(filename);
 }
 
-// Logs speed and RPM data to flexray_protocol_receiver.json
-void FlexRayReceiver::logSignalToJson(float speed, int rpm) {
-    std::lock_guard<std::mutex> lock(m_mutex); // Ensure thread-safe access to the JSON file
-    // Create a JSON entry for the signal data
-    json signalEntry;
-    signalEntry["Speed"] = speed; // Store speed in meters per second
-    signalEntry["RPM"] = rpm;     // Store RPM as an integer
-
-    // Read existing JSON data from file
-    json entries = json::array();
-    std::ifstream in_file("flexray_protocol_receiver.json");
-    std::string file_content;
-    if (in_file.is_open()) {
-        std::stringstream buffer;
-        buffer << in_file.rdbuf();
-        file_content = buffer.str();
-        in_file.close();
-        if (!file_content.empty()) {
-            try {
-                entries = json::parse(file_content);
-                if (!entries.is_array()) {
-                    qWarning() << "flexray_protocol_receiver.json is not an array. Resetting to empty array.";
-                    entries = json::array();
-                }
-            } catch (const json::exception &e) {
-                qWarning() << "Failed to parse flexray_protocol_receiver.json:" << e.what();
-                qWarning() << "File content:" << QString::fromStdString(file_content);
-                entries = json::array();
-            }
-        }
-    } else {
-        qWarning() << "Failed to open flexray_protocol_receiver.json for reading";
+// Drains and processes all pending FlexRay packets
+void FlexRayReceiver::readflexrayPacket()
+{
+    // A new capture epoch is a new test iteration: the sender restarts its sequence
+    if (m_ring && m_ring->epoch() != m_epoch)
+    {
+        logWireStats("FlexRay", m_sequence.stats());
+        m_sequence = wire::SequenceTracker();
+        m_epoch = m_ring->epoch();
     }
 
-    // Append the new signal entry to the JSON array
-    entries.push_back(signalEntry);
-    // Save the updated JSON array to the file
-    saveJsonFile("flexray_protocol_receiver.json", entries);
+    quint64 dropsBefore = m_batchReader->kernelDrops();
+    quint64 truncatedBefore = m_batchReader->truncatedCount();
+    int handled = m_batchReader->drain([this](const uint8_t *data, size_t length, uint64_t timestampNs) {
+        processPacket(data, length, timestampNs);
+    });
+    if (handled < 0)
+    {
+        qWarning() << "Error reading flexray packet:" << strerror(errno);
+        return;
+    }
+
+    m_drops->add(DropCounters::ShortReads, m_batchReader->truncatedCount() - truncatedBefore);
+    quint64 drops = m_batchReader->kernelDrops();
+    if (drops != dropsBefore)
+    {
+        m_drops->add(DropCounters::KernelDrops, drops - dropsBefore);
+        qWarning() << "FlexRay socket dropped" << (drops - dropsBefore) << "packets, total" << drops;
+    }
 }
 
-// Reads and processes incoming FlexRay packets
-void FlexRayReceiver::readflexrayPacket()
+// Decodes one FlexRay packet
+void FlexRayReceiver::processPacket(const uint8_t *buffer, size_t nbytes, uint64_t timestampNs)
 {
-    uint8_t buffer[8];
-    struct sockaddr_in clientAddr;
-    socklen_t clientLen = sizeof(clientAddr);
-    // Receive a FlexRay packet via UDP
-    ssize_t nbytes = recvfrom(socketFd, buffer, sizeof(buffer), 0,
-                              (struct sockaddr *)&clientAddr, &clientLen);
-    if (nbytes < 0) {
-        qWarning() << "Error reading flexray packet:" << strerror(errno);
+    // Fast path for binary frames; the ASCII decoding below is the legacy fallback
+    if (wire::isBinary(buffer, nbytes)) {
+        if (!processBinaryPacket(buffer, nbytes, timestampNs)) {
+            m_drops->add(DropCounters::DecodeFailures);
+            qWarning() << "Invalid binary flexray frame:" << nbytes << "bytes";
+        }
         return;
     }
-    if (nbytes != sizeof(buffer)) {
-        qWarning() << "Received incomplete flexray packet:" << nbytes << "bytes, expected" << sizeof(buffer);
+
+    if (nbytes != kPayloadSize) {
+        m_drops->add(DropCounters::ShortReads);
+        qWarning() << "Received incomplete flexray packet:" << nbytes << "bytes, expected" << kPayloadSize;
         return;
     }
 
-    // Convert packet data to a QByteArray (8 bytes)
-    QByteArray data(reinterpret_cast<const char *>(buffer), 8);
-    // Extract speed and RPM as strings from the ASCII data
-    QString dataStr = QString::fromLatin1(data);
-    QString speedStr = dataStr.left(4); // First 4 characters for speed
-    QString rpmStr = dataStr.mid(4, 4); // Next 4 characters for RPM
-
-    // Convert strings to numerical values
-    bool ok1 = false, ok2 = false;
-    float speed_raw = speedStr.toFloat(&ok1);
-    int rpm_raw = rpmStr.toInt(&ok2);
-
-    if (ok1 && ok2) {
-        // Convert speed from m/s to km/h
-        float speed_converted = speed_raw * 3.6f;
-        int rpm_converted = rpm_raw; // RPM is already in the correct unit
-
-        // Log the raw and converted values
-        qDebug().noquote() << QString("flexray Speed raw: %1, converted: %2 km/h; RPM: %3")
-                                .arg(speed_raw, 0, 'f', 2)
-                                .arg(speed_converted, 0, 'f', 2)
-                                .arg(rpm_raw);
-
-        // Emit signals with converted values
-        emit speedDataReceived(speed_converted);
-        emit rpmDataReceived(rpm_converted);
-
-        // Log the raw data to JSON
-        logSignalToJson(speed_raw, rpm_raw);
+    // Decode speed (first 4 characters) and RPM (last 4 characters) from the ASCII data
+    float speed_raw = 0.0f;
+    int rpm_raw = 0;
+
+    if (payload::decodeSpeedRpm(buffer, speed_raw, rpm_raw)) {
+        // Publish the raw data to the GUI and the signal log
+        publishSample(0, buffer, speed_raw, static_cast<float>(rpm_raw), timestampNs);
     } else {
+        m_drops->add(DropCounters::DecodeFailures);
         qWarning() << "Failed to convert ASCII flexray data to float/int.";
     }
-}
\ No newline at end of file
+}
+
+// Decodes a binary speed/RPM frame
+bool FlexRayReceiver::processBinaryPacket(const uint8_t *buffer, size_t nbytes, uint64_t timestampNs)
+{
+    wire::Frame frame;
+    if (!wire::decode(buffer, nbytes, frame)) {
+        return false;
+    }
+
+    publishSample(0, buffer, frame.speed, frame.rpm, timestampNs, &frame);
+    return true;
+}
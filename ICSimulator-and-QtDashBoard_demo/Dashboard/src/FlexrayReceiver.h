@@ -4,12 +4,16 @@
 #include <QObject>
 #include <QSocketNotifier>
 #include <QString>
-#include <nlohmann/json.hpp>
-#include <mutex>
+#include "SampleRing.h"
+#include "DatagramBatchReader.h"
+#include "DropCounters.h"
+#include "WireFormat.hpp"
+
+class IoReactor;
 
 // Class: FlexRayReceiver
 // Description: Manages the reception and processing of FlexRay packets over UDP, parsing speed and RPM data,
-//              and logging it to a JSON file. Inherits from QObject for signal-slot functionality.
+//              and publishing it to a SampleRing. Inherits from QObject for signal-slot functionality.
 class FlexRayReceiver : public QObject
 {
     Q_OBJECT
@@ -19,49 +23,60 @@ public:
     // Parameters:
     //   - ip: IP address to bind the UDP socket to.
     //   - port: Port number for UDP communication.
+    //   - ring: Sample ring decoded frames are pushed to; the GUI and the signal log consume it (not owned).
+    //   - drops: Loss counters of the bus (not owned; must outlive the receiver).
+    //   - batchConfig: recvmmsg batch size and per-wakeup drain budget.
+    //   - multicastGroup: Multicast group to join on the interface with address ip; empty to receive
+    //                     unicast on ip. The socket is shared (SO_REUSEPORT), so several Dashboards on one
+    //                     host can join the same group.
     //   - parent: Optional parent QObject for memory management.
-    explicit FlexRayReceiver(const QString &ip, quint16 port, QObject *parent = nullptr);
+    explicit FlexRayReceiver(const QString &ip, quint16 port, SampleRing *ring, DropCounters *drops,
+                             const BatchConfig &batchConfig = BatchConfig(),
+                             const QString &multicastGroup = QString(), QObject *parent = nullptr);
 
     // Destructor: Cleans up resources, including closing the UDP socket and deleting the notifier.
     ~FlexRayReceiver();
 
-signals:
-    // Signal: Emitted when speed data is received from a FlexRay packet.
+    // Function: Hands the FlexRay socket to an I/O reactor instead of the socket notifier: reads, decoding and
+    //           ring pushes then run on the reactor thread. Call while the reactor is stopped.
     // Parameters:
-    //   - speed: Vehicle speed in km/h.
-    void speedDataReceived(float speed);
+    //   - reactor: Reactor serving all bus receivers (not owned; must be cleared before this is deleted).
+    void attachToReactor(IoReactor *reactor);
 
-    // Signal: Emitted when RPM data is received from a FlexRay packet.
-    // Parameters:
-    //   - rpm: Engine RPM as a float.
-    void rpmDataReceived(float rpm);
+    // Function: Cumulative packets dropped by the kernel because the socket buffer was full.
+    quint64 kernelDropCount() const { return m_batchReader->kernelDrops(); }
 
-    // Signal: Emitted when fuel data is received from a FlexRay packet.
-    // Parameters:
-    //   - fuel: Fuel level or consumption data.
-    void fuelDataReceived(float fuel);
-
-    // Signal: Emitted when temperature data is received from a FlexRay packet.
-    // Parameters:
-    //   - temp: Temperature reading (e.g., engine or coolant temperature).
-    void tempDataReceived(float temp);
+    // Function: Loss, duplication, reordering and latency of the binary frames received in the current
+    //           capture epoch.
+    const wire::StreamStats &wireStats() const { return m_sequence.stats(); }
 
 private slots:
-    // Slot: Reads and processes incoming FlexRay packets from the UDP socket.
+    // Slot: Drains and processes all pending FlexRay packets from the UDP socket.
     void readflexrayPacket();
 
 private:
-    // Function: Logs speed and RPM data to a JSON file.
+    // Function: Pushes the raw frame with its decoded speed and RPM to the sample ring.
     // Parameters:
+    //   - id: Frame identifier (0 when the transport has none).
+    //   - payload: Raw frame payload; its first 8 bytes are kept.
     //   - speed: Raw speed value in meters per second.
-    //   - rpm: Raw RPM value as an integer.
-    void logSignalToJson(float speed, int rpm);
+    //   - rpm: Raw RPM value.
+    //   - timestampNs: Kernel receive time in CLOCK_REALTIME nanoseconds.
+    //   - frame: Binary frame the values came from, whose sequence is tracked and whose stamp is kept for
+    //            the latency histograms; null for ASCII payloads.
+    void publishSample(uint32_t id, const uint8_t *payload, float speed, float rpm, uint64_t timestampNs,
+                       const wire::Frame *frame = nullptr);
 
-    // Function: Saves JSON data to the specified file.
+    // Function: Decodes a binary frame (WireFormat.hpp) without any text parsing and tracks its sequence.
+    // Returns: false if the packet is not a valid binary frame.
+    bool processBinaryPacket(const uint8_t *buffer, size_t nbytes, uint64_t timestampNs);
+
+    // Function: Decodes one received packet and publishes its values.
     // Parameters:
-    //   - filename: Path to the JSON file.
-    //   - json_data: JSON data to be written.
-    void saveJsonFile(const std::string &filename, const nlohmann::json &json_data);
+    //   - buffer: Packet payload.
+    //   - nbytes: Payload length in bytes.
+    //   - timestampNs: Kernel receive time in CLOCK_REALTIME nanoseconds.
+    void processPacket(const uint8_t *buffer, size_t nbytes, uint64_t timestampNs);
 
     // Member: File descriptor for the UDP socket.
     int socketFd;
@@ -69,8 +84,20 @@ private:
     // Member: QSocketNotifier for asynchronous monitoring of UDP socket events.
     QSocketNotifier *notifier;
 
-    // Member: Mutex for thread-safe access to the JSON file.
-    std::mutex m_mutex;
+    // Member: Batched recvmmsg reader for the socket.
+    DatagramBatchReader *m_batchReader;
+
+    // Member: Sequence and latency tracking of the binary frames.
+    wire::SequenceTracker m_sequence;
+
+    // Member: Ring of decoded samples shared by the GUI and the signal log (not owned).
+    SampleRing *m_ring;
+
+    // Member: Loss counters of the bus (not owned).
+    DropCounters *m_drops;
+
+    // Member: Capture epoch of the ring when m_sequence was started.
+    uint32_t m_epoch;
 };
 
 #endif // FLEXRAYRECEIVER_H
\ No newline at end of file
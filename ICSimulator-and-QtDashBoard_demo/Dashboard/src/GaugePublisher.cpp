@@ -0,0 +1,164 @@
+#include "GaugePublisher.h"
+#include <QDebug>
+#include <QMetaObject>
+#include <QQuickWindow>
+#include <algorithm>
+
+// QML property names, indexed by Field
+static const char *const kFieldProperties[GaugePublisher::FieldCount] = {"kph", "rpm", "fuel", "temperature"};
+
+// SampleField bits are laid out in Field order
+static_assert(SpeedField == 1 << GaugePublisher::Kph && RpmField == 1 << GaugePublisher::Rpm &&
+              FuelField == 1 << GaugePublisher::Fuel && TemperatureField == 1 << GaugePublisher::Temperature,
+              "SampleField bits must match GaugePublisher::Field");
+
+// Samples read from a ring per read() call
+static constexpr size_t kReadBatch = 256;
+
+// Constructor: Publishes new samples on every frame of the window
+GaugePublisher::GaugePublisher(QQuickWindow *window, LatencyRecorder *latency, QObject *parent)
+    : QObject(parent), m_window(window), m_latency(latency), m_samples(kReadBatch), m_framePending(false),
+      m_received(0), m_published(0)
+{
+    if (m_window)
+    {
+        connect(m_window, &QQuickWindow::afterAnimating, this, &GaugePublisher::publish);
+        if (m_latency)
+        {
+            // frameSwapped is emitted on the render thread; record there, right after the swap
+            LatencyRecorder *recorder = m_latency;
+            connect(m_window, &QQuickWindow::frameSwapped, this, [recorder] { recorder->recordFrameSwap(); },
+                    Qt::DirectConnection);
+        }
+    }
+    else
+    {
+        qWarning() << "No dashboard window, gauge updates are not frame-paced";
+    }
+}
+
+// Registers as a DropOldest consumer of the ring: the gauges only need the newest values
+bool GaugePublisher::attach(SampleRing *ring, QObject *valueSource, const QString &bus)
+{
+    int consumer = ring->addConsumer(SampleRing::DropOldest, [this] { requestFrame(); });
+    if (consumer < 0)
+    {
+        qWarning() << "No free consumer slot on the sample ring for" << (valueSource ? valueSource->objectName() : QString());
+        return false;
+    }
+    int latencyStream = m_latency ? m_latency->addStream(bus) : -1;
+    m_sources.push_back(Source{ring, consumer, valueSource, latencyStream});
+    return true;
+}
+
+// Sums the GUI overruns of all rings
+quint64 GaugePublisher::overrunSamples() const
+{
+    quint64 overruns = 0;
+    for (const Source &source : m_sources)
+    {
+        overruns += source.ring->overrunCount(source.consumer);
+    }
+    return overruns;
+}
+
+// Asks the window for one frame, or the event loop for one publish if there is no window
+void GaugePublisher::requestFrame()
+{
+    if (m_framePending.exchange(true, std::memory_order_acq_rel))
+    {
+        return;
+    }
+    if (m_window)
+    {
+        QMetaObject::invokeMethod(m_window, "update", Qt::QueuedConnection);
+    }
+    else
+    {
+        QMetaObject::invokeMethod(this, "publish", Qt::QueuedConnection);
+    }
+}
+
+// Pushes the latest changed values of every ring to QML
+void GaugePublisher::publish()
+{
+    // Clear first: a sample pushed after this point requests the next frame
+    m_framePending.store(false, std::memory_order_release);
+
+    quint64 published = 0;
+    for (Source &source : m_sources)
+    {
+        published += publishSource(source);
+    }
+    m_published.store(m_published.load(std::memory_order_relaxed) + published, std::memory_order_relaxed);
+}
+
+// Reads at most one ring's worth of samples, keeps the newest value per gauge and pushes those
+quint64 GaugePublisher::publishSource(Source &source)
+{
+    float latest[FieldCount] = {};
+    unsigned changed = 0;
+    quint64 received = 0;
+    uint64_t newestSentNs = 0;
+    size_t budget = source.ring->capacity();
+    size_t count;
+    while (budget > 0 && (count = source.ring->read(source.consumer, m_samples.data(), std::min(budget, m_samples.size()))) > 0)
+    {
+        budget -= count;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const SignalSample &sample = m_samples[i];
+            if (sample.fields & SpeedField)
+            {
+                latest[Kph] = sample.speed * 3.6f; // m/s to km/h
+                ++received;
+            }
+            if (sample.fields & RpmField)
+            {
+                latest[Rpm] = sample.rpm;
+                ++received;
+            }
+            if (sample.fields & FuelField)
+            {
+                latest[Fuel] = sample.fuel;
+                ++received;
+            }
+            if (sample.fields & TemperatureField)
+            {
+                latest[Temperature] = sample.temperature;
+                ++received;
+            }
+            changed |= sample.fields & ((1u << FieldCount) - 1);
+            if (sample.sentNs && m_latency)
+            {
+                m_latency->recordSample(source.latencyStream, sample);
+                newestSentNs = sample.sentNs;
+            }
+        }
+    }
+    m_received.store(m_received.load(std::memory_order_relaxed) + received, std::memory_order_relaxed);
+
+    quint64 published = 0;
+    if (source.target)
+    {
+        for (int field = 0; field < FieldCount; ++field)
+        {
+            if (changed & (1u << field))
+            {
+                source.target->setProperty(kFieldProperties[field], latest[field]);
+                ++published;
+            }
+        }
+        if (published && m_latency)
+        {
+            m_latency->recordPublish(source.latencyStream, newestSentNs);
+        }
+    }
+
+    // Samples left over (budget exhausted or pushed meanwhile) go into the next frame
+    if (source.ring->arm(source.consumer) || budget == 0)
+    {
+        requestFrame();
+    }
+    return published;
+}
@@ -0,0 +1,100 @@
+#ifndef GAUGEPUBLISHER_H
+#define GAUGEPUBLISHER_H
+
+#include <QObject>
+#include <QPointer>
+#include <atomic>
+#include <vector>
+#include "LatencyRecorder.h"
+#include "SampleRing.h"
+
+class QQuickWindow;
+
+// Class: GaugePublisher
+// Description: Coalesces receiver updates into the QML ValueSource objects. The publisher is a DropOldest
+//              consumer of every bus SampleRing; once per rendered frame (QQuickWindow::afterAnimating,
+//              which runs on the GUI thread right before the scene graph synchronizes) it reads all new
+//              samples and pushes only the latest value of each changed gauge to QML. GUI cost follows
+//              the display rate instead of the bus rate.
+class GaugePublisher : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Gauge properties of a ValueSource object
+    enum Field
+    {
+        Kph = 0,
+        Rpm,
+        Fuel,
+        Temperature,
+        FieldCount
+    };
+
+    // Constructor: Publishes on every frame of the given window.
+    // Parameters:
+    //   - window: Dashboard window; if null, updates are published from the event loop instead.
+    //   - latency: Histograms fed with the receive, decode, publish and frame-swap latency of sender-stamped
+    //              samples (not owned; must outlive the publisher); null disables latency recording.
+    //   - parent: Optional parent QObject for memory management.
+    explicit GaugePublisher(QQuickWindow *window, LatencyRecorder *latency = nullptr, QObject *parent = nullptr);
+
+    // Function: Feeds a ValueSource object from a bus ring. Call from the GUI thread, once per bus.
+    // Parameters:
+    //   - ring: Sample ring of the bus receiver (not owned; must outlive the publisher).
+    //   - valueSource: QML object with kph/rpm/fuel/temperature properties (may be null).
+    //   - bus: Bus name of the ring's latency histograms (e.g., "CAN").
+    // Returns: false if the ring has no free consumer slot.
+    bool attach(SampleRing *ring, QObject *valueSource, const QString &bus = QString());
+
+    // Function: Gauge values read from the rings, values pushed to QML, and the difference (updates that
+    //           were superseded before the next frame).
+    quint64 receivedUpdates() const { return m_received.load(std::memory_order_relaxed); }
+    quint64 publishedUpdates() const { return m_published.load(std::memory_order_relaxed); }
+    quint64 mergedUpdates() const { return receivedUpdates() - publishedUpdates(); }
+
+    // Function: Samples the GUI never saw because the rings overwrote them first.
+    quint64 overrunSamples() const;
+
+public slots:
+    // Slot: Pushes every changed value to its ValueSource object. Runs on the GUI thread.
+    void publish();
+
+private:
+    // Function: Schedules one frame; called from receiver threads through the ring wake hook.
+    void requestFrame();
+
+    // Struct: One ring feeding one ValueSource object.
+    struct Source
+    {
+        SampleRing *ring;
+        int consumer;
+        QPointer<QObject> target;
+        int latencyStream;
+    };
+
+    // Function: Reads every new sample of a source and pushes the latest changed values to QML.
+    // Returns: Number of gauge values pushed.
+    quint64 publishSource(Source &source);
+
+    // Member: Window whose frames pace publishing (not owned; outlives the receivers).
+    QQuickWindow *m_window;
+
+    // Member: Latency histograms (not owned; may be null).
+    LatencyRecorder *m_latency;
+
+    // Member: Attached rings.
+    std::vector<Source> m_sources;
+
+    // Member: Scratch buffer for samples read from a ring.
+    std::vector<SignalSample> m_samples;
+
+    // Member: Set while a frame has been requested but not yet published.
+    std::atomic<bool> m_framePending;
+
+    // Member: Coalescing statistics (written on the GUI thread only).
+    std::atomic<quint64> m_received;
+    std::atomic<quint64> m_published;
+};
+
+#endif // GAUGEPUBLISHER_H
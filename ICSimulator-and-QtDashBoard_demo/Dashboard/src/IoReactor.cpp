@@ -0,0 +1,227 @@
+#include "IoReactor.h"
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+// Readiness events fetched per epoll_wait call
+static constexpr int kMaxEvents = 32;
+
+// Constructor: Creates the epoll instance and the stop eventfd
+IoReactor::IoReactor()
+    : m_epollFd(-1), m_wakeFd(-1), m_wakeups(0), m_dispatches(0), m_voluntarySwitches(0), m_involuntarySwitches(0)
+{
+    m_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epollFd < 0)
+    {
+        qWarning() << "Failed to create epoll instance:" << strerror(errno);
+        return;
+    }
+
+    // The eventfd is level-triggered with a null data pointer, which tells the loop to exit
+    m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.ptr = nullptr;
+    if (m_wakeFd < 0 || epoll_ctl(m_epollFd, EPOLL_CTL_ADD, m_wakeFd, &event) < 0)
+    {
+        qWarning() << "Failed to set up the reactor wakeup:" << strerror(errno);
+    }
+}
+
+// Destructor: Stops the thread and closes the descriptors it owns
+IoReactor::~IoReactor()
+{
+    stop();
+    if (m_wakeFd >= 0)
+    {
+        close(m_wakeFd);
+    }
+    if (m_epollFd >= 0)
+    {
+        close(m_epollFd);
+    }
+}
+
+// Registers a descriptor edge-triggered
+bool IoReactor::add(int fd, const QString &name, Handler handler)
+{
+    if (isRunning() || m_epollFd < 0 || fd < 0)
+    {
+        qWarning() << "Cannot add" << name << "to the I/O reactor";
+        return false;
+    }
+
+    std::unique_ptr<Source> source(new Source{fd, name, std::move(handler), false});
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLET;
+    event.data.ptr = source.get();
+    if (epoll_ctl(m_epollFd, EPOLL_CTL_ADD, fd, &event) < 0)
+    {
+        qWarning() << "Failed to add" << name << "to the I/O reactor:" << strerror(errno);
+        return false;
+    }
+    m_sources.push_back(std::move(source));
+    return true;
+}
+
+// Unregisters every descriptor
+void IoReactor::clear()
+{
+    if (isRunning())
+    {
+        qWarning() << "Cannot clear the I/O reactor while it is running";
+        return;
+    }
+    for (const std::unique_ptr<Source> &source : m_sources)
+    {
+        epoll_ctl(m_epollFd, EPOLL_CTL_DEL, source->fd, nullptr);
+    }
+    m_sources.clear();
+}
+
+// Starts the reactor thread
+bool IoReactor::start()
+{
+    if (isRunning())
+    {
+        return true;
+    }
+    if (m_epollFd < 0 || m_wakeFd < 0)
+    {
+        return false;
+    }
+
+    // Data that arrived while stopped raised no new edge, so every source is served once on start
+    for (const std::unique_ptr<Source> &source : m_sources)
+    {
+        source->queued = false;
+    }
+    m_thread = std::thread(&IoReactor::run, this);
+    return true;
+}
+
+// Wakes the loop through the eventfd and joins the thread
+void IoReactor::stop()
+{
+    if (!isRunning())
+    {
+        return;
+    }
+    uint64_t one = 1;
+    if (write(m_wakeFd, &one, sizeof(one)) < 0)
+    {
+        qWarning() << "Failed to wake the I/O reactor:" << strerror(errno);
+    }
+    m_thread.join();
+
+    uint64_t value;
+    while (read(m_wakeFd, &value, sizeof(value)) > 0)
+    {
+    }
+}
+
+// Counters since construction
+IoReactor::Stats IoReactor::stats() const
+{
+    return Stats{m_wakeups.load(std::memory_order_relaxed), m_dispatches.load(std::memory_order_relaxed),
+                 m_voluntarySwitches.load(std::memory_order_relaxed),
+                 m_involuntarySwitches.load(std::memory_order_relaxed)};
+}
+
+// Logs the counters
+void IoReactor::logStats() const
+{
+    Stats counters = stats();
+    qInfo() << "I/O reactor:" << m_sources.size() << "sources," << counters.wakeups << "wakeups,"
+            << counters.dispatches << "dispatches," << counters.voluntarySwitches << "voluntary and"
+            << counters.involuntarySwitches << "involuntary context switches";
+}
+
+// Waits for readiness and serves the ready sources round-robin until stopped
+void IoReactor::run()
+{
+    if (m_threadSetup)
+    {
+        m_threadSetup();
+    }
+
+    struct rusage usageBefore;
+    getrusage(RUSAGE_THREAD, &usageBefore);
+
+    std::vector<Source *> ready(m_sources.size());
+    ready.clear();
+    for (const std::unique_ptr<Source> &source : m_sources)
+    {
+        source->queued = true;
+        ready.push_back(source.get());
+    }
+
+    struct epoll_event events[kMaxEvents];
+    bool stopping = false;
+    while (!stopping)
+    {
+        // Sources left at their budget are pending already: poll without blocking then
+        int count = epoll_wait(m_epollFd, events, kMaxEvents, ready.empty() ? -1 : 0);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            qWarning() << "epoll_wait failed, I/O reactor stopped:" << strerror(errno);
+            break;
+        }
+        if (count > 0)
+        {
+            m_wakeups.store(m_wakeups.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+        for (int i = 0; i < count; ++i)
+        {
+            Source *source = static_cast<Source *>(events[i].data.ptr);
+            if (!source)
+            {
+                stopping = true;
+                break;
+            }
+            if (!source->queued)
+            {
+                source->queued = true;
+                ready.push_back(source);
+            }
+        }
+        if (stopping)
+        {
+            break;
+        }
+
+        // One handler call per ready source; those that hit their budget stay queued for the next round
+        size_t kept = 0;
+        for (Source *source : ready)
+        {
+            bool more = source->handler();
+            if (more)
+            {
+                ready[kept++] = source;
+            }
+            else
+            {
+                source->queued = false;
+            }
+        }
+        m_dispatches.store(m_dispatches.load(std::memory_order_relaxed) + ready.size(), std::memory_order_relaxed);
+        ready.resize(kept);
+    }
+
+    struct rusage usageAfter;
+    getrusage(RUSAGE_THREAD, &usageAfter);
+    m_voluntarySwitches.fetch_add(static_cast<uint64_t>(usageAfter.ru_nvcsw - usageBefore.ru_nvcsw),
+                                  std::memory_order_relaxed);
+    m_involuntarySwitches.fetch_add(static_cast<uint64_t>(usageAfter.ru_nivcsw - usageBefore.ru_nivcsw),
+                                    std::memory_order_relaxed);
+}
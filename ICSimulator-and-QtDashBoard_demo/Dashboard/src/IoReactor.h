@@ -0,0 +1,110 @@
+#ifndef IOREACTOR_H
+#define IOREACTOR_H
+
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Class: IoReactor
+// Description: One thread serving the file descriptors of every bus receiver with a single epoll loop,
+//              instead of a QThread with its own event loop and QSocketNotifier per bus. Descriptors are
+//              registered edge-triggered; on each readiness edge the reactor calls the receiver's handler,
+//              which drains, decodes and publishes into the bus SampleRing on the reactor thread. A handler
+//              that stops at its drain budget is called again after the other ready descriptors have been
+//              served, without another epoll_wait, so one busy bus cannot starve the others and no edge
+//              is lost. The Qt event loop is left to the GUI.
+class IoReactor
+{
+public:
+    // Handler: Drains its descriptor. Returns true if it stopped at its budget with data possibly left,
+    //          false once the descriptor would block.
+    using Handler = std::function<bool()>;
+
+    // Struct: Reactor thread counters, for comparison with the thread-per-bus receivers.
+    //   - wakeups: epoll_wait calls that returned ready descriptors.
+    //   - dispatches: Handler calls.
+    //   - voluntarySwitches/involuntarySwitches: Context switches of the reactor thread (getrusage), as of
+    //                                            its last stop().
+    struct Stats
+    {
+        uint64_t wakeups;
+        uint64_t dispatches;
+        uint64_t voluntarySwitches;
+        uint64_t involuntarySwitches;
+    };
+
+    // Constructor: Creates the epoll instance; the thread starts with start().
+    IoReactor();
+
+    // Destructor: Stops the thread.
+    ~IoReactor();
+
+    IoReactor(const IoReactor &) = delete;
+    IoReactor &operator=(const IoReactor &) = delete;
+
+    // Function: Registers a descriptor. Only while the reactor is stopped.
+    // Parameters:
+    //   - fd: Non-blocking descriptor to watch for input (not owned; must stay open until clear()).
+    //   - name: Bus name used in the logs.
+    //   - handler: Called on the reactor thread whenever fd becomes readable.
+    // Returns: false if the reactor is running or epoll refuses the descriptor.
+    bool add(int fd, const QString &name, Handler handler);
+
+    // Function: Unregisters every descriptor. Only while the reactor is stopped.
+    void clear();
+
+    // Function: Sets a function the reactor thread runs before entering its loop, e.g. to apply its
+    //           scheduling settings. Only while the reactor is stopped.
+    void setThreadSetup(std::function<void()> setup) { m_threadSetup = std::move(setup); }
+
+    // Function: Starts the reactor thread.
+    // Returns: false if it could not be started.
+    bool start();
+
+    // Function: Stops the reactor thread and waits for it; handlers are not called afterwards.
+    void stop();
+
+    bool isRunning() const { return m_thread.joinable(); }
+
+    // Function: Counters since construction.
+    Stats stats() const;
+
+    // Function: Logs the counters with qInfo.
+    void logStats() const;
+
+private:
+    // Struct: One registered descriptor.
+    struct Source
+    {
+        int fd;
+        QString name;
+        Handler handler;
+        bool queued;
+    };
+
+    // Function: Reactor thread body.
+    void run();
+
+    // Member: epoll instance, and the eventfd that wakes the loop to stop it.
+    int m_epollFd;
+    int m_wakeFd;
+
+    // Member: Registered descriptors; epoll events point at them.
+    std::vector<std::unique_ptr<Source>> m_sources;
+
+    // Member: Reactor thread, and what it runs first.
+    std::thread m_thread;
+    std::function<void()> m_threadSetup;
+
+    // Member: Counters, written by the reactor thread.
+    std::atomic<uint64_t> m_wakeups;
+    std::atomic<uint64_t> m_dispatches;
+    std::atomic<uint64_t> m_voluntarySwitches;
+    std::atomic<uint64_t> m_involuntarySwitches;
+};
+
+#endif // IOREACTOR_H
@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "DatagramBatchReader.h"
+#include "SignalCapture.hpp"
+#include "ThreadProfile.h"
+
+// Receive-to-decode latency of a bus receiver thread under a synthetic rendering load, with the default
+// scheduling and with a ThreadProfile. A paced sender feeds a UDP loopback socket; the receiver thread
+// waits in poll() like a QThread event loop, drains with DatagramBatchReader and measures, per frame, the
+// time from the kernel receive stamp to decoding. Meanwhile render threads alternate busy frames and
+// sleeps at 60 Hz, the way the QML render loop and the compositor load the CPUs. With the profile, the
+// receiver applies its role (default "udp") and the render threads the "gui" role, as in the Dashboard.
+
+// Struct: BenchOptions
+// Description: Command-line settings.
+//   - profilePath: Thread profile applied in the "profile" mode.
+//   - role: Profile role of the receiver thread.
+//   - rate: Frames per second.
+//   - duration: Seconds per mode.
+//   - renderThreads: Threads of the rendering load (default: one per CPU).
+//   - busyFraction: Share of each 16.7 ms frame a render thread computes.
+//   - mode: "default", "profile" or "both".
+struct BenchOptions
+{
+    std::string profilePath = "thread_profile.json";
+    std::string role = "udp";
+    double rate = 1000.0;
+    double duration = 5.0;
+    int renderThreads = 0;
+    double busyFraction = 0.75;
+    std::string mode = "both";
+};
+
+// Frame period of the rendering load
+static constexpr int64_t kRenderPeriodNs = 16666667;
+
+static int64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Function: Sleeps until an absolute CLOCK_MONOTONIC time.
+static void sleepUntil(int64_t deadlineNs)
+{
+    struct timespec deadline;
+    deadline.tv_sec = deadlineNs / 1000000000;
+    deadline.tv_nsec = deadlineNs % 1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+    {
+    }
+}
+
+// Function: One render thread: computes for busyFraction of every frame, then sleeps to the next one.
+static void renderLoad(const std::atomic<bool> &running, double busyFraction, const ThreadProfile *profile)
+{
+    if (profile)
+    {
+        profile->applyToCurrentThread("gui");
+    }
+    volatile double sink = 1.0;
+    int64_t frameStart = monotonicNs();
+    while (running.load(std::memory_order_relaxed))
+    {
+        int64_t busyUntil = frameStart + static_cast<int64_t>(kRenderPeriodNs * busyFraction);
+        while (monotonicNs() < busyUntil)
+        {
+            for (int i = 0; i < 1000; ++i)
+            {
+                sink = sink * 1.0000001 + 1e-9;
+            }
+        }
+        frameStart += kRenderPeriodNs;
+        sleepUntil(frameStart);
+    }
+}
+
+// Function: Sends one 8-byte frame every 1/rate seconds until running is cleared.
+static void sendFrames(const std::atomic<bool> &running, const struct sockaddr_in &destination, double rate)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    uint8_t frame[8] = {'0', '0', '0', '0', '0', '0', '0', '0'};
+    int64_t periodNs = static_cast<int64_t>(1e9 / rate);
+    int64_t deadline = monotonicNs();
+    while (running.load(std::memory_order_relaxed))
+    {
+        sendto(fd, frame, sizeof(frame), 0, reinterpret_cast<const struct sockaddr *>(&destination),
+               sizeof(destination));
+        deadline += periodNs;
+        sleepUntil(deadline);
+    }
+    close(fd);
+}
+
+// Function: Receiver thread: waits in poll() and records the receive-to-decode latency of every frame.
+static void receiveFrames(const std::atomic<bool> &running, int fd, const ThreadProfile *profile,
+                          const std::string &role, std::vector<int64_t> &latencies, uint64_t &drops)
+{
+    if (profile)
+    {
+        profile->applyToCurrentThread(role);
+    }
+    DatagramBatchReader reader(fd, 64);
+    struct pollfd poller = {fd, POLLIN, 0};
+    while (running.load(std::memory_order_relaxed))
+    {
+        if (poll(&poller, 1, 100) <= 0)
+        {
+            continue;
+        }
+        reader.drain([&latencies](const uint8_t *, size_t, uint64_t timestampNs) {
+            latencies.push_back(static_cast<int64_t>(sigcap::realtimeNs() - timestampNs));
+        });
+    }
+    drops = reader.kernelDrops();
+}
+
+// Function: Runs one mode and prints its line.
+static void runMode(const char *mode, const BenchOptions &options, const ThreadProfile *profile)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (fd < 0 || bind(fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0 ||
+        getsockname(fd, reinterpret_cast<struct sockaddr *>(&address), &length) < 0)
+    {
+        perror("Bench socket");
+        exit(1);
+    }
+
+    std::atomic<bool> receiving(true);
+    std::atomic<bool> running(true);
+    std::vector<int64_t> latencies;
+    latencies.reserve(static_cast<size_t>(options.rate * options.duration * 1.1));
+    uint64_t drops = 0;
+    std::thread receiver(receiveFrames, std::cref(receiving), fd, profile, std::cref(options.role),
+                         std::ref(latencies), std::ref(drops));
+    std::vector<std::thread> render;
+    for (int i = 0; i < options.renderThreads; ++i)
+    {
+        render.emplace_back(renderLoad, std::cref(running), options.busyFraction, profile);
+    }
+    std::thread sender(sendFrames, std::cref(running), std::cref(address), options.rate);
+
+    sleepUntil(monotonicNs() + static_cast<int64_t>(options.duration * 1e9));
+    running = false;
+    sender.join();
+    for (std::thread &thread : render)
+    {
+        thread.join();
+    }
+    receiving = false;
+    receiver.join();
+    close(fd);
+
+    if (latencies.empty())
+    {
+        printf("%-8s no frames received\n", mode);
+        return;
+    }
+    double sum = 0.0, squares = 0.0;
+    for (int64_t latency : latencies)
+    {
+        sum += static_cast<double>(latency);
+        squares += static_cast<double>(latency) * static_cast<double>(latency);
+    }
+    double mean = sum / latencies.size();
+    double deviation = std::sqrt(std::max(0.0, squares / latencies.size() - mean * mean));
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&latencies](double fraction) {
+        size_t index = static_cast<size_t>(fraction * (latencies.size() - 1));
+        return latencies[index] / 1000.0;
+    };
+    printf("%-8s %9zu %6llu %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f\n", mode, latencies.size(),
+           static_cast<unsigned long long>(drops), mean / 1000.0, percentile(0.5), percentile(0.99),
+           percentile(0.999), latencies.back() / 1000.0, deviation / 1000.0);
+}
+
+// Function: Prints the command-line usage.
+static void printUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --profile FILE   thread profile of the profile mode (default thread_profile.json)\n"
+            "  --role NAME      profile role of the receiver thread (default udp)\n"
+            "  --rate HZ        frames per second (default 1000)\n"
+            "  --duration S     seconds per mode (default 5)\n"
+            "  --render N       render load threads (default: one per CPU)\n"
+            "  --busy F         busy share of each 60 Hz render frame (default 0.75)\n"
+            "  --mode M         default, profile or both (default both)\n",
+            program);
+}
+
+int main(int argc, char *argv[])
+{
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            printUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--profile")
+        {
+            options.profilePath = value;
+        }
+        else if (arg == "--role")
+        {
+            options.role = value;
+        }
+        else if (arg == "--rate" && atof(value.c_str()) > 0.0)
+        {
+            options.rate = atof(value.c_str());
+        }
+        else if (arg == "--duration" && atof(value.c_str()) > 0.0)
+        {
+            options.duration = atof(value.c_str());
+        }
+        else if (arg == "--render" && atoi(value.c_str()) >= 0)
+        {
+            options.renderThreads = atoi(value.c_str());
+        }
+        else if (arg == "--busy" && atof(value.c_str()) >= 0.0 && atof(value.c_str()) <= 1.0)
+        {
+            options.busyFraction = atof(value.c_str());
+        }
+        else if (arg == "--mode" && (value == "default" || value == "profile" || value == "both"))
+        {
+            options.mode = value;
+        }
+        else
+        {
+            fprintf(stderr, "Invalid option %s %s\n", arg.c_str(), value.c_str());
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.renderThreads == 0)
+    {
+        options.renderThreads = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+    }
+
+    ThreadProfile profile;
+    if (options.mode != "default")
+    {
+        std::string error;
+        if (!profile.load(options.profilePath, &error))
+        {
+            fprintf(stderr, "Thread profile not loaded: %s\n", error.c_str());
+            return 1;
+        }
+    }
+
+    printf("%.0f Hz for %.1f s, %d render threads %.0f%% busy at 60 Hz; receive-to-decode latency in us\n",
+           options.rate, options.duration, options.renderThreads, options.busyFraction * 100.0);
+    printf("%-8s %9s %6s %9s %9s %9s %9s %9s %9s\n", "mode", "frames", "drops", "mean", "p50", "p99", "p99.9",
+           "max", "jitter");
+    if (options.mode != "profile")
+    {
+        runMode("default", options, nullptr);
+    }
+    if (options.mode != "default")
+    {
+        runMode("profile", options, &profile);
+    }
+    return 0;
+}
@@ -0,0 +1,220 @@
+#include "LatencyRecorder.h"
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include <cmath>
+
+// Stage names used in the dumps, indexed by Stage
+static const char *const kStageNames[LatencyRecorder::StageCount] = {"receive", "decode", "publish", "swap"};
+
+// Constructor: Allocates the zeroed buckets
+LatencyHistogram::LatencyHistogram()
+    : m_buckets(new std::atomic<uint64_t>[kBucketCount]), m_count(0), m_sumNs(0), m_maxNs(0)
+{
+    reset();
+}
+
+// Mean of the recorded values
+double LatencyHistogram::meanNs() const
+{
+    uint64_t values = count();
+    return values ? static_cast<double>(m_sumNs.load(std::memory_order_relaxed)) / values : 0.0;
+}
+
+// Walks the buckets up to the requested rank
+uint64_t LatencyHistogram::percentileNs(double percentile) const
+{
+    uint64_t values = count();
+    if (values == 0)
+    {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * values));
+    rank = rank < 1 ? 1 : rank;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i)
+    {
+        seen += bucketCount(i);
+        if (seen >= rank)
+        {
+            uint64_t upper = bucketUpperNs(i);
+            return upper < maxNs() ? upper : maxNs();
+        }
+    }
+    return maxNs();
+}
+
+// Inverse of bucketIndex(): the largest value that maps to the bucket
+uint64_t LatencyHistogram::bucketUpperNs(size_t index)
+{
+    const size_t subBuckets = size_t(1) << kSubBucketBits;
+    if (index < subBuckets)
+    {
+        return index;
+    }
+    size_t offset = index - subBuckets;
+    int shift = static_cast<int>(offset / (subBuckets / 2)) + 1;
+    uint64_t subBucket = offset % (subBuckets / 2) + subBuckets / 2;
+    return ((subBucket + 1) << shift) - 1;
+}
+
+// Zeroes every counter
+void LatencyHistogram::reset()
+{
+    for (size_t i = 0; i < kBucketCount; ++i)
+    {
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sumNs.store(0, std::memory_order_relaxed);
+    m_maxNs.store(0, std::memory_order_relaxed);
+}
+
+// Constructor: No streams yet
+LatencyRecorder::LatencyRecorder()
+    : m_streamCount(0)
+{
+}
+
+// Allocates the histograms of one bus and publishes them to the render thread
+int LatencyRecorder::addStream(const QString &name)
+{
+    int index = m_streamCount.load(std::memory_order_relaxed);
+    if (index >= kMaxStreams)
+    {
+        qWarning() << "No free latency stream for" << name;
+        return -1;
+    }
+    m_streams[index].reset(new Stream);
+    m_streams[index]->name = name;
+    m_streams[index]->swapPendingNs.store(0, std::memory_order_relaxed);
+    m_streamCount.store(index + 1, std::memory_order_release);
+    return index;
+}
+
+// Receive and decode stages of one sample read from a ring
+void LatencyRecorder::recordSample(int stream, const SignalSample &sample)
+{
+    if (stream < 0 || sample.sentNs == 0)
+    {
+        return;
+    }
+    Stream &histograms = *m_streams[stream];
+    if (sample.receivedNs >= sample.sentNs)
+    {
+        histograms.stages[Receive].record(sample.receivedNs - sample.sentNs);
+    }
+    if (sample.decodedNs >= sample.sentNs)
+    {
+        histograms.stages[Decode].record(sample.decodedNs - sample.sentNs);
+    }
+}
+
+// Publish stage; the value becomes visible with the next swap
+void LatencyRecorder::recordPublish(int stream, uint64_t sentNs)
+{
+    if (stream < 0 || sentNs == 0)
+    {
+        return;
+    }
+    Stream &histograms = *m_streams[stream];
+    uint64_t nowNs = wire::monotonicNs();
+    if (nowNs >= sentNs)
+    {
+        histograms.stages[Publish].record(nowNs - sentNs);
+    }
+    histograms.swapPendingNs.store(sentNs, std::memory_order_release);
+}
+
+// Swap stage of every stream that published since the last swap
+void LatencyRecorder::recordFrameSwap()
+{
+    uint64_t nowNs = wire::monotonicNs();
+    int streams = m_streamCount.load(std::memory_order_acquire);
+    for (int i = 0; i < streams; ++i)
+    {
+        uint64_t sentNs = m_streams[i]->swapPendingNs.exchange(0, std::memory_order_acq_rel);
+        if (sentNs != 0 && nowNs >= sentNs)
+        {
+            m_streams[i]->stages[Swap].record(nowNs - sentNs);
+        }
+    }
+}
+
+// Logs one line per non-empty histogram
+void LatencyRecorder::dump() const
+{
+    int streams = m_streamCount.load(std::memory_order_acquire);
+    bool empty = true;
+    for (int i = 0; i < streams; ++i)
+    {
+        for (int stage = 0; stage < StageCount; ++stage)
+        {
+            const LatencyHistogram &histogram = m_streams[i]->stages[stage];
+            if (histogram.count() == 0)
+            {
+                continue;
+            }
+            empty = false;
+            qInfo().noquote() << QString("Latency %1 sender->%2: %3 samples, mean %4 us, p50 %5 us, p99 %6 us, "
+                                         "p99.9 %7 us, max %8 us")
+                                     .arg(m_streams[i]->name)
+                                     .arg(kStageNames[stage])
+                                     .arg(histogram.count())
+                                     .arg(histogram.meanNs() / 1000.0, 0, 'f', 1)
+                                     .arg(histogram.percentileNs(50.0) / 1000.0, 0, 'f', 1)
+                                     .arg(histogram.percentileNs(99.0) / 1000.0, 0, 'f', 1)
+                                     .arg(histogram.percentileNs(99.9) / 1000.0, 0, 'f', 1)
+                                     .arg(histogram.maxNs() / 1000.0, 0, 'f', 1);
+        }
+    }
+    if (empty)
+    {
+        qInfo() << "Latency histograms are empty (the senders stamp frames with --wire binary only)";
+    }
+}
+
+// Writes the raw buckets so reports can merge runs or recompute any percentile
+bool LatencyRecorder::writeCsv(const QString &path) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        qWarning() << "Failed to write latency histograms to" << path << ":" << file.errorString();
+        return false;
+    }
+    QTextStream out(&file);
+    out << "bus,stage,upper_ns,count\n";
+    int streams = m_streamCount.load(std::memory_order_acquire);
+    for (int i = 0; i < streams; ++i)
+    {
+        for (int stage = 0; stage < StageCount; ++stage)
+        {
+            const LatencyHistogram &histogram = m_streams[i]->stages[stage];
+            for (size_t bucket = 0; bucket < LatencyHistogram::kBucketCount; ++bucket)
+            {
+                uint64_t hits = histogram.bucketCount(bucket);
+                if (hits)
+                {
+                    out << m_streams[i]->name << ',' << kStageNames[stage] << ','
+                        << LatencyHistogram::bucketUpperNs(bucket) << ',' << hits << '\n';
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// Clears every histogram of every stream
+void LatencyRecorder::reset()
+{
+    int streams = m_streamCount.load(std::memory_order_acquire);
+    for (int i = 0; i < streams; ++i)
+    {
+        for (LatencyHistogram &histogram : m_streams[i]->stages)
+        {
+            histogram.reset();
+        }
+        m_streams[i]->swapPendingNs.store(0, std::memory_order_relaxed);
+    }
+}
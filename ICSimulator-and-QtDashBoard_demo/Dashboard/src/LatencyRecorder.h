@@ -0,0 +1,171 @@
+#ifndef LATENCYRECORDER_H
+#define LATENCYRECORDER_H
+
+#include <QString>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "SampleRing.h"
+#include "SignalCapture.hpp"
+#include "WireFormat.hpp"
+
+// Class: LatencyHistogram
+// Description: HDR-style histogram of latencies in nanoseconds. Values below 128 ns get one bucket each;
+//              above that every power of two is split into 64 buckets, so any recorded value is known to
+//              within 1/64 (about two significant digits) up to kMaxValueNs. Larger values are clamped.
+//              One thread records; any thread may read concurrently (counters are relaxed atomics).
+class LatencyHistogram
+{
+public:
+    static constexpr int kSubBucketBits = 7;
+    static constexpr int kMaxValueBits = 36;
+    static constexpr uint64_t kMaxValueNs = (uint64_t(1) << kMaxValueBits) - 1;
+    static constexpr size_t kBucketCount = (size_t(1) << kSubBucketBits) +
+                                           (kMaxValueBits - kSubBucketBits) * (size_t(1) << (kSubBucketBits - 1));
+
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    // Function: Adds one value. Recording thread only.
+    void record(uint64_t valueNs)
+    {
+        valueNs = valueNs > kMaxValueNs ? kMaxValueNs : valueNs;
+        std::atomic<uint64_t> &bucket = m_buckets[bucketIndex(valueNs)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_sumNs.store(m_sumNs.load(std::memory_order_relaxed) + valueNs, std::memory_order_relaxed);
+        if (valueNs > m_maxNs.load(std::memory_order_relaxed))
+        {
+            m_maxNs.store(valueNs, std::memory_order_relaxed);
+        }
+    }
+
+    // Function: Number of recorded values, their mean and their maximum.
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    double meanNs() const;
+    uint64_t maxNs() const { return m_maxNs.load(std::memory_order_relaxed); }
+
+    // Function: Smallest bucket bound at or below which the given share of the values lies.
+    // Parameters:
+    //   - percentile: 0 to 100 (e.g., 99.9).
+    // Returns: Upper bound of that bucket in nanoseconds, capped at maxNs(); 0 if nothing was recorded.
+    uint64_t percentileNs(double percentile) const;
+
+    // Function: Values recorded in a bucket and the largest value the bucket holds.
+    uint64_t bucketCount(size_t index) const { return m_buckets[index].load(std::memory_order_relaxed); }
+    static uint64_t bucketUpperNs(size_t index);
+
+    // Function: Clears all counters. Values recorded concurrently may be lost.
+    void reset();
+
+private:
+    // Function: Bucket of a value of at most kMaxValueNs.
+    static size_t bucketIndex(uint64_t valueNs)
+    {
+        const uint64_t subBuckets = uint64_t(1) << kSubBucketBits;
+        if (valueNs < subBuckets)
+        {
+            return static_cast<size_t>(valueNs);
+        }
+        // Shift that brings the value into [subBuckets / 2, subBuckets)
+        int shift = (63 - __builtin_clzll(valueNs)) - (kSubBucketBits - 1);
+        return static_cast<size_t>(subBuckets + (shift - 1) * (subBuckets / 2) + ((valueNs >> shift) - subBuckets / 2));
+    }
+
+    std::unique_ptr<std::atomic<uint64_t>[]> m_buckets;
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sumNs;
+    std::atomic<uint64_t> m_maxNs;
+};
+
+// Class: LatencyRecorder
+// Description: End-to-end latency of sender-stamped (binary wire format) samples, one set of histograms
+//              per bus. Every stage is measured from the sender's CLOCK_MONOTONIC stamp:
+//   - Receive: the frame reached the socket (kernel receive time).
+//   - Decode: the receiver thread decoded it and pushed the sample to the ring.
+//   - Publish: the GaugePublisher pushed its value to the QML gauge (GUI thread).
+//   - Swap: the first frame showing that value was swapped to the screen (render thread).
+//              The stage-to-stage differences show where the time is spent. Sender and Dashboard must
+//              share CLOCK_MONOTONIC (same host) for the absolute numbers to be meaningful.
+class LatencyRecorder
+{
+public:
+    enum Stage
+    {
+        Receive = 0,
+        Decode,
+        Publish,
+        Swap,
+        StageCount
+    };
+
+    static constexpr int kMaxStreams = 8;
+
+    LatencyRecorder();
+
+    LatencyRecorder(const LatencyRecorder &) = delete;
+    LatencyRecorder &operator=(const LatencyRecorder &) = delete;
+
+    // Function: Adds the histograms of one bus. Call from the GUI thread before recording starts.
+    // Parameters:
+    //   - name: Bus name used in the dumps (e.g., "CAN").
+    // Returns: Stream index, or -1 if kMaxStreams are already registered.
+    int addStream(const QString &name);
+
+    // Function: Records the receive and decode stages of a stamped sample; unstamped samples are ignored.
+    //           GUI thread only.
+    void recordSample(int stream, const SignalSample &sample);
+
+    // Function: Records the publish stage of the newest stamped sample pushed to QML and holds it for the
+    //           next frame swap. GUI thread only.
+    void recordPublish(int stream, uint64_t sentNs);
+
+    // Function: Records the swap stage of every value published since the previous swap. Connected to
+    //           QQuickWindow::frameSwapped, so it runs on the render thread.
+    void recordFrameSwap();
+
+    // Function: Logs count, p50, p99, p99.9 and max of every non-empty histogram.
+    void dump() const;
+
+    // Function: Writes the non-empty buckets of every histogram as CSV (bus,stage,upper_ns,count).
+    // Returns: true on success.
+    bool writeCsv(const QString &path) const;
+
+    // Function: Clears every histogram.
+    void reset();
+
+private:
+    // Struct: Histograms and pending swap of one bus.
+    struct Stream
+    {
+        QString name;
+        LatencyHistogram stages[StageCount];
+        std::atomic<uint64_t> swapPendingNs;
+    };
+
+    // Member: Registered streams; entries below m_streamCount are immutable once published.
+    std::unique_ptr<Stream> m_streams[kMaxStreams];
+    std::atomic<int> m_streamCount;
+};
+
+// Function: Stamps a sample decoded from a binary frame with the sender time and the CLOCK_MONOTONIC
+//           receive and decode times that LatencyRecorder measures. Called on the receiver thread.
+// Parameters:
+//   - sample: Sample about to be pushed to the ring.
+//   - frame: Decoded binary frame.
+//   - receiveRealtimeNs: Kernel receive time in CLOCK_REALTIME nanoseconds.
+// Returns: The decode time, for the sequence tracker.
+inline uint64_t stampLatency(SignalSample &sample, const wire::Frame &frame, uint64_t receiveRealtimeNs)
+{
+    uint64_t nowNs = wire::monotonicNs();
+    uint64_t sinceReceiveNs = sigcap::realtimeNs() - receiveRealtimeNs;
+    sample.sentNs = wire::senderTimeNs(frame, nowNs);
+    sample.receivedNs = sinceReceiveNs < nowNs ? nowNs - sinceReceiveNs : nowNs;
+    sample.decodedNs = nowNs;
+    return nowNs;
+}
+
+#endif // LATENCYRECORDER_H
@@ -1,4 +1,9 @@
 #include "LinReceiver.h"
+#include "PayloadCodec.hpp"
+#include "SignalCapture.hpp"
+#include "LatencyRecorder.h"
+#include "WireStats.h"
+#include "IoReactor.h"
 
 #include <QDebug>
 #include <fcntl.h>
@@ -7,13 +12,14 @@
 #include <signal.h>
 #include <errno.h>
 #include <cstring>
-#include <fstream>
-#include <sstream>
 
-using json = nlohmann::json;
+// LIN frames read per reactor dispatch before the other buses get their turn
+static constexpr int kReactorFrameBudget = 64;
 
 // Constructor: Initializes LIN receiver for the specified device
-LinReceiver::LinReceiver(QObject *parent) : QObject(parent), linFd(-1)
+LinReceiver::LinReceiver(SampleRing *ring, DropCounters *drops, QObject *parent)
+    : QObject(parent), linFd(-1), m_ring(ring), m_drops(drops),
+      m_epoch(ring ? ring->epoch() : 0)
 {
     // Open the LIN device file in read-only mode
     linFd = open("/dev/plin0", O_RDONLY);
@@ -26,56 +32,13 @@ LinReceiver::LinReceiver(QObject *parent) : QObject(parent), linFd(-1)
     notifier = new QSocketNotifier(linFd, QSocketNotifier::Read, this);
     connect(notifier, &QSocketNotifier::activated, this, &LinReceiver::readLinFrame);
     qDebug() << "LinReceiver Constructor is called";
-
-    // Check if lin_protocol_receiver.json exists and is valid
-    std::ifstream check_file("lin_protocol_receiver.json");
-    bool needs_init = true;
-    if (check_file.is_open())
-    {
-        // Read the content of the JSON file
-        std::stringstream buffer;
-        buffer << check_file.rdbuf();
-        std::string content = buffer.str();
-        check_file.close();
-
-        if (!content.empty())
-        {
-            try
-            {
-                json temp = json::parse(content);
-                if (temp.is_array())
-                {
-                    needs_init = false; // Valid JSON array found, no initialization needed
-                }
-            }
-            catch (const nlohmann::json::exception &e)
-            {
-                qWarning() << "Existing lin_protocol_receiver.json is invalid:" << e.what();
-                qWarning() << "File content:" << QString::fromStdString(content);
-            }
-        }
-    }
-
-    // Initialize lin_protocol_receiver.json with an empty array if invalid or missing
-    if (needs_init)
-    {
-        std::ofstream json_file("lin_protocol_receiver.json");
-        if (json_file.is_open())
-        {
-            json_file << "[]";
-            json_file.close();
-            qDebug() << "Initialized lin_protocol_receiver.json as empty array";
-        }
-        else
-        {
-            qWarning() << "Failed to initialize lin_protocol_receiver.json";
-        }
-    }
 }
 
 // Destructor: Cleans up resources
 LinReceiver::~LinReceiver()
 {
+    logWireStats("LIN", m_sequence.stats());
+
     // Close the LIN device file if it was opened
     if (linFd >= 0)
     {
@@ -85,132 +48,112 @@ LinReceiver::~LinReceiver()
     delete notifier;
 }
 
-// Logs speed and RPM data to lin_protocol_receiver.json
-void LinReceiver::logSignalToJson(float speed, int rpm) // Changed from float to int for rpm
+// Replaces the socket notifier by the I/O reactor
+void LinReceiver::attachToReactor(IoReactor *reactor)
 {
-    std::lock_guard<std::mutex> lock(m_mutex); // Ensure thread-safe access to the JSON file
-
-    // Create a JSON entry for the signal data
-    json signalEntry;
-    signalEntry["Speed"] = speed; // Store speed in meters per second
-    signalEntry["RPM"] = rpm;     // Store RPM as an integer
-
-    // Read existing JSON data from file
-    json entries = json::array(); // Default to empty array if file is invalid
-    std::ifstream in_file("lin_protocol_receiver.json");
-    std::string file_content;
-    if (in_file.is_open())
+    delete notifier;
+    notifier = nullptr;
+    int flags = fcntl(linFd, F_GETFL, 0);
+    if (flags < 0 || fcntl(linFd, F_SETFL, flags | O_NONBLOCK) < 0)
     {
-        std::stringstream buffer;
-        buffer << in_file.rdbuf();
-        file_content = buffer.str();
-        in_file.close();
-
-        if (!file_content.empty())
+        qWarning() << "Failed to make the LIN device non-blocking:" << strerror(errno);
+    }
+    reactor->add(linFd, "LIN", [this]() {
+        for (int i = 0; i < kReactorFrameBudget; ++i)
         {
-            try
-            {
-                entries = json::parse(file_content);
-                if (!entries.is_array())
-                {
-                    qWarning() << "lin_protocol_receiver.json is not an array. Resetting to empty array.";
-                    entries = json::array();
-                }
-            }
-            catch (const nlohmann::json::exception &e)
+            if (!readLinFrame())
             {
-                qWarning() << "Failed to parse lin_protocol_receiver.json:" << e.what();
-                qWarning() << "File content:" << QString::fromStdString(file_content);
-                entries = json::array();
+                return false;
             }
         }
-    }
-    else
-    {
-        qWarning() << "Failed to open lin_protocol_receiver.json for reading";
-    }
-
-    // Append the new signal entry to the JSON array
-    entries.push_back(signalEntry);
-
-    // Save the updated JSON array to the file
-    saveJsonFile("lin_protocol_receiver.json", entries);
+        return true;
+    });
 }
-// Saves JSON data to a specified file
-void LinReceiver::saveJsonFile(const std::string &filename, const nlohmann::json &json_data)
+
+// Pushes the raw frame and decoded values to the LIN sample ring
+void LinReceiver::publishSample(uint32_t id, const uint8_t *payload, float speed, int rpm, const wire::Frame *frame)
 {
-    std::ofstream file(filename);
-    if (!file.is_open())
+    SignalSample sample = {};
+    sample.timestampNs = sigcap::realtimeNs();
+    sample.id = id;
+    sample.length = 8;
+    sample.fields = SpeedField | RpmField;
+    memcpy(sample.payload, payload, sizeof(sample.payload));
+    sample.speed = speed;
+    sample.rpm = static_cast<float>(rpm);
+    if (frame)
     {
-        qWarning() << "Failed to save JSON file:" << QString::fromStdString(filename);
-        return;
+        // No kernel timestamp on the plin device: the read time stands in for it
+        m_drops->updateSequence(m_sequence, *frame, stampLatency(sample, *frame, sample.timestampNs));
+    }
+    if (m_ring && !m_ring->push(sample))
+    {
+        m_drops->addQueueOverflow();
     }
-
-    // Write JSON data with 2-space indentation
-    file << json_data.dump(2);
-    file.close();
-    qDebug() << "Saved JSON file:" << QString::fromStdString(filename);
 }
 
 // Reads and processes incoming LIN frames
-void LinReceiver::readLinFrame()
+bool LinReceiver::readLinFrame()
 {
+    // A new capture epoch is a new test iteration: the sender restarts its sequence
+    if (m_ring && m_ring->epoch() != m_epoch)
+    {
+        logWireStats("LIN", m_sequence.stats());
+        m_sequence = wire::SequenceTracker();
+        m_epoch = m_ring->epoch();
+    }
+
     struct plin_msg msg;
     // Read a LIN frame from the device
     ssize_t nbytes = read(linFd, &msg, sizeof(msg));
     if (nbytes < 0)
     {
-        qWarning() << "Error reading LIN frame:" << strerror(errno);
-        return;
+        // Only in reactor mode: the device is drained
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            qWarning() << "Error reading LIN frame:" << strerror(errno);
+        }
+        return false;
     }
     // Check for incomplete frame (Note: 'buffer' is undefined, likely meant to be 'msg')
     if (nbytes != sizeof(msg)) {
+        m_drops->add(DropCounters::ShortReads);
         qWarning() << "Received incomplete LIN packet:" << nbytes << "bytes, expected" << sizeof(msg);
-        return;
+        return true;
     }
 
     // Process LIN frame based on message type
     if (msg.type == PLIN_MSG_FRAME)
     {
-        qDebug() << "Received LIN frame with ID:" << msg.id;
-
         // Handle frames with ID 0x04 (speed and RPM data)
-        if (msg.id == 0x04)
+        if (msg.id == 0x04 && wire::isBinary(msg.data, sizeof(msg.data)))
         {
-            // Convert frame data to a QByteArray (8 bytes)
-            QByteArray data(reinterpret_cast<const char *>(msg.data), 8);
-            QString dataStr = QString::fromLatin1(data);
-
-            // Extract speed and RPM as strings from the ASCII data
-            QString speedStr = dataStr.left(4); // First 4 characters for speed
-            QString rpmStr = dataStr.mid(4, 4); // Last 4 characters for RPM
-
-            // Convert strings to numerical values
-            bool ok1 = false, ok2 = false;
-            float speed_raw = speedStr.toFloat(&ok1);
-            int rpm_raw = rpmStr.toInt(&ok2);
-
-            if (ok1 && ok2)
+            // Compact binary frame; the ASCII decoding below is the legacy fallback
+            wire::Frame binary;
+            if (wire::decode(msg.data, wire::kCompactSize, binary))
             {
-                // Convert speed from m/s to km/h
-                float speed_converted = speed_raw * 3.6f;
-                int rpm_converted = rpm_raw; // RPM is already in the correct unit
-
-                // Log the raw and converted values
-                qDebug().noquote() << QString("LIN Speed raw: %1, converted: %2 km/h; RPM: %3")
-                                        .arg(speed_raw, 0, 'f', 2)
-                                        .arg(speed_converted, 0, 'f', 2)
-                                        .arg(rpm_raw);
-
-                // Emit signals with converted values
-                emit speedDataReceived(speed_converted);
-                emit rpmDataReceived(rpm_converted);
+                publishSample(msg.id, msg.data, binary.speed, static_cast<int>(binary.rpm), &binary);
+            }
+            else
+            {
+                m_drops->add(DropCounters::DecodeFailures);
+                qWarning() << "Invalid binary LIN speed/RPM frame";
+            }
+        }
+        else if (msg.id == 0x04)
+        {
+            // Decode speed (first 4 characters) and RPM (last 4 characters) from the ASCII data
+            float speed_raw = 0.0f;
+            int rpm_raw = 0;
 
-                // Log raw values to JSON
-                logSignalToJson(speed_raw, rpm_raw);
+            if (payload::decodeSpeedRpm(msg.data, speed_raw, rpm_raw))
+            {
+                // Publish raw values to the GUI and the signal log
+                publishSample(msg.id, msg.data, speed_raw, rpm_raw);
             }
             else
             {
+                m_drops->add(DropCounters::DecodeFailures);
                 qWarning() << "Failed to convert ASCII LIN data to float/int.";
             }
         }
@@ -218,6 +161,7 @@ void LinReceiver::readLinFrame()
     }
     else if (msg.type == PLIN_MSG_OVERRUN)
     {
+        m_drops->add(DropCounters::KernelDrops);
         qWarning() << "LIN message overrun detected!";
     }
     else if (msg.type == PLIN_MSG_WAKEUP)
@@ -228,4 +172,5 @@ void LinReceiver::readLinFrame()
     {
         qWarning() << "Unsupported LIN message type:" << msg.type;
     }
+    return true;
 }
\ No newline at end of file
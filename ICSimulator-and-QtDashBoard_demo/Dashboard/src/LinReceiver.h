@@ -3,13 +3,16 @@
 
 #include <QObject>
 #include <QSocketNotifier>
-#include <nlohmann/json.hpp>
-#include <mutex>
+#include "SampleRing.h"
+#include "DropCounters.h"
+#include "WireFormat.hpp"
 #include "plin.h"
 
+class IoReactor;
+
 // Class: LinReceiver
 // Description: Manages the reception and processing of LIN bus frames, parsing speed and RPM data,
-//              and logging it to a JSON file. Inherits from QObject for signal-slot functionality.
+//              and publishing it to a SampleRing. Inherits from QObject for signal-slot functionality.
 class LinReceiver : public QObject
 {
     Q_OBJECT
@@ -17,36 +20,29 @@ class LinReceiver : public QObject
 public:
     // Constructor: Initializes the LIN receiver for the specified device.
     // Parameters:
+    //   - ring: Sample ring decoded frames are pushed to; the GUI and the signal log consume it (not owned).
+    //   - drops: Loss counters of the bus (not owned; must outlive the receiver).
     //   - parent: Optional parent QObject for memory management.
-    explicit LinReceiver(QObject *parent = nullptr);
+    explicit LinReceiver(SampleRing *ring, DropCounters *drops, QObject *parent = nullptr);
 
     // Destructor: Cleans up resources, including closing the LIN device file and deleting the notifier.
     ~LinReceiver();
 
-signals:
-    // Signal: Emitted when speed data is received from a LIN frame.
-    // Parameters:
-    //   - speed: Vehicle speed in km/h.
-    void speedDataReceived(float speed);
-
-    // Signal: Emitted when RPM data is received from a LIN frame.
+    // Function: Hands the LIN device to an I/O reactor instead of the socket notifier. The device is switched
+    //           to non-blocking reads so the reactor can drain it on each edge. Call while the reactor is
+    //           stopped, and again after the reactor was cleared.
     // Parameters:
-    //   - rpm: Engine RPM as a float.
-    void rpmDataReceived(float rpm);
+    //   - reactor: Reactor serving all bus receivers (not owned; must be cleared before this is deleted).
+    void attachToReactor(IoReactor *reactor);
 
-    // Signal: Emitted when fuel data is received from a LIN frame.
-    // Parameters:
-    //   - fuel: Fuel level or consumption data.
-    void fuelDataReceived(float fuel);
-
-    // Signal: Emitted when temperature data is received from a LIN frame.
-    // Parameters:
-    //   - temp: Temperature reading (e.g., engine or coolant temperature).
-    void tempDataReceived(float temp);
+    // Function: Loss, duplication, reordering and latency of the binary speed/RPM frames received in the current
+    //           capture epoch.
+    const wire::StreamStats &wireStats() const { return m_sequence.stats(); }
 
 private slots:
-    // Slot: Reads and processes incoming LIN frames from the device.
-    void readLinFrame();
+    // Slot: Reads and processes one incoming LIN frame from the device.
+    // Returns: false if no frame could be read (none pending on a non-blocking device, or a read error).
+    bool readLinFrame();
 
 private:
     // Member: File descriptor for the LIN device.
@@ -55,20 +51,27 @@ private:
     // Member: QSocketNotifier for asynchronous monitoring of LIN device events.
     QSocketNotifier *notifier;
 
-    // Member: Mutex for thread-safe access to the JSON file.
-    std::mutex m_mutex;
+    // Member: Ring of decoded samples shared by the GUI and the signal log (not owned).
+    SampleRing *m_ring;
 
-    // Function: Logs speed and RPM data to a JSON file.
+    // Member: Loss counters of the bus (not owned).
+    DropCounters *m_drops;
+
+    // Member: Sequence and latency tracking of the binary speed/RPM frames.
+    wire::SequenceTracker m_sequence;
+
+    // Member: Capture epoch of the ring when m_sequence was started.
+    uint32_t m_epoch;
+
+    // Function: Pushes the raw frame with its decoded speed and RPM to the sample ring.
     // Parameters:
+    //   - id: Frame identifier (0 when the transport has none).
+    //   - payload: Raw 8-byte frame payload.
     //   - speed: Raw speed value in meters per second.
     //   - rpm: Raw RPM value as an integer.
-    void logSignalToJson(float speed, int rpm);
-
-    // Function: Saves JSON data to the specified file.
-    // Parameters:
-    //   - filename: Path to the JSON file.
-    //   - json_data: JSON data to be written.
-    void saveJsonFile(const std::string &filename, const nlohmann::json &json_data);
+    //   - frame: Binary frame the values came from, whose sequence is tracked and whose stamp is kept for
+    //            the latency histograms; null for ASCII payloads.
+    void publishSample(uint32_t id, const uint8_t *payload, float speed, int rpm, const wire::Frame *frame = nullptr);
 };
 
 #endif // LINRECEIVER_H
\ No newline at end of file
@@ -0,0 +1,354 @@
+#include <QCoreApplication>
+#include <QSocketNotifier>
+#include <QThread>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <netinet/in.h>
+#include <string>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "DatagramBatchReader.h"
+#include "IoReactor.h"
+#include "WireFormat.hpp"
+
+// Compares the two ways the Dashboard serves its bus sockets, on UDP loopback:
+//   - threads: one QThread with its own event loop and QSocketNotifier per bus (ENABLE_IO_REACTOR 0)
+//   - reactor: one IoReactor thread with an edge-triggered epoll loop over all buses (ENABLE_IO_REACTOR 1)
+// A paced sender thread sends one binary wire frame per bus and tick; both modes drain the sockets with
+// the receivers' DatagramBatchReader and decode every frame. Printed per mode: receiving threads, frames,
+// kernel drops, context switches and CPU time of the receiving side per frame, and the send-to-decode
+// latency.
+
+// Struct: BenchOptions
+// Description: Command-line settings.
+//   - buses: Bus sockets served at once.
+//   - rate: Frames per second and bus.
+//   - duration: Seconds sent per mode.
+//   - mode: "threads", "reactor" or "both".
+struct BenchOptions
+{
+    int buses = 4;
+    double rate = 1000.0;
+    double duration = 5.0;
+    std::string mode = "both";
+};
+
+// Struct: Usage
+// Description: Context switches and CPU time of a thread or of the process.
+struct Usage
+{
+    int64_t voluntary;
+    int64_t involuntary;
+    int64_t cpuNs;
+};
+
+// Function: Resource usage of the calling thread (RUSAGE_THREAD) or the process (RUSAGE_SELF).
+static Usage currentUsage(int who)
+{
+    struct rusage usage;
+    getrusage(who, &usage);
+    return Usage{usage.ru_nvcsw, usage.ru_nivcsw,
+                 (static_cast<int64_t>(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000000 +
+                     (static_cast<int64_t>(usage.ru_utime.tv_usec) + usage.ru_stime.tv_usec) * 1000};
+}
+
+static Usage operator-(const Usage &a, const Usage &b)
+{
+    return Usage{a.voluntary - b.voluntary, a.involuntary - b.involuntary, a.cpuNs - b.cpuNs};
+}
+
+// Class: Bus
+// Description: One bus socket and what was decoded from it. Only the thread serving the bus touches it
+//              while a run is in progress.
+class Bus
+{
+public:
+    // Constructor: Binds a UDP socket to an ephemeral loopback port.
+    Bus()
+        : m_fd(-1), m_frames(0), m_invalid(0), m_latencySumNs(0), m_latencyMaxNs(0)
+    {
+        m_fd = socket(AF_INET, SOCK_DGRAM, 0);
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (m_fd < 0 || bind(m_fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0 ||
+            getsockname(m_fd, reinterpret_cast<struct sockaddr *>(&m_address), &length) < 0)
+        {
+            perror("Bus socket");
+            exit(1);
+        }
+        m_reader.reset(new DatagramBatchReader(m_fd, 64));
+    }
+
+    ~Bus()
+    {
+        m_reader.reset();
+        close(m_fd);
+    }
+
+    Bus(const Bus &) = delete;
+    Bus &operator=(const Bus &) = delete;
+
+    // Function: Drains and decodes the pending frames, as the receivers do on a wakeup.
+    // Returns: true if the drain stopped at its budget.
+    bool drain()
+    {
+        m_reader->drain([this](const uint8_t *data, size_t length, uint64_t) {
+            wire::Frame frame;
+            if (!wire::decode(data, length, frame))
+            {
+                ++m_invalid;
+                return;
+            }
+            uint64_t latencyNs = wire::monotonicNs() - frame.timestampNs;
+            m_latencySumNs += latencyNs;
+            if (latencyNs > m_latencyMaxNs)
+            {
+                m_latencyMaxNs = latencyNs;
+            }
+            ++m_frames;
+        });
+        return m_reader->pending();
+    }
+
+    int fd() const { return m_fd; }
+    const struct sockaddr_in &address() const { return m_address; }
+    uint64_t frames() const { return m_frames; }
+    uint64_t invalid() const { return m_invalid; }
+    uint64_t latencySumNs() const { return m_latencySumNs; }
+    uint64_t latencyMaxNs() const { return m_latencyMaxNs; }
+    uint64_t kernelDrops() const { return m_reader->kernelDrops(); }
+
+private:
+    int m_fd;
+    struct sockaddr_in m_address;
+    std::unique_ptr<DatagramBatchReader> m_reader;
+    uint64_t m_frames;
+    uint64_t m_invalid;
+    uint64_t m_latencySumNs;
+    uint64_t m_latencyMaxNs;
+};
+
+// Function: Sends one frame per bus every 1/rate seconds for the duration, on absolute deadlines.
+// Parameters:
+//   - buses: Destinations.
+//   - options: Rate and duration.
+//   - sent: Frames sent successfully.
+//   - usage: Resource usage of the sender thread, to be taken out of the process totals.
+static void sendFrames(const std::vector<std::unique_ptr<Bus>> &buses, const BenchOptions &options, uint64_t &sent,
+                       Usage &usage)
+{
+    Usage before = currentUsage(RUSAGE_THREAD);
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    wire::Encoder encoder;
+    uint8_t frame[wire::kFullSize];
+    int64_t periodNs = static_cast<int64_t>(1e9 / options.rate);
+    uint64_t ticks = static_cast<uint64_t>(options.duration * options.rate);
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    sent = 0;
+    for (uint64_t tick = 0; tick < ticks; ++tick)
+    {
+        for (const std::unique_ptr<Bus> &bus : buses)
+        {
+            size_t length = encoder.encodeFull(static_cast<float>(tick % 80), static_cast<float>(tick % 8000), frame);
+            if (sendto(fd, frame, length, 0, reinterpret_cast<const struct sockaddr *>(&bus->address()),
+                       sizeof(struct sockaddr_in)) == static_cast<ssize_t>(length))
+            {
+                ++sent;
+            }
+        }
+        deadline.tv_nsec += periodNs;
+        while (deadline.tv_nsec >= 1000000000)
+        {
+            deadline.tv_nsec -= 1000000000;
+            ++deadline.tv_sec;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+        {
+        }
+    }
+    close(fd);
+    usage = currentUsage(RUSAGE_THREAD) - before;
+}
+
+// Function: Runs the sender against buses already being served, and returns the resource usage of the
+//           receiving threads: the process total minus the sender and the calling thread.
+static Usage runSender(const std::vector<std::unique_ptr<Bus>> &buses, const BenchOptions &options, uint64_t &sent)
+{
+    Usage processBefore = currentUsage(RUSAGE_SELF);
+    Usage mainBefore = currentUsage(RUSAGE_THREAD);
+    Usage senderUsage = {0, 0, 0};
+    std::thread sender(sendFrames, std::cref(buses), std::cref(options), std::ref(sent), std::ref(senderUsage));
+    sender.join();
+    // Let the receivers catch up with the last frames
+    QThread::msleep(100);
+    Usage mainUsage = currentUsage(RUSAGE_THREAD) - mainBefore;
+    return currentUsage(RUSAGE_SELF) - processBefore - senderUsage - mainUsage;
+}
+
+// Function: Thread per bus: a QThread and QSocketNotifier each, as in the Dashboard without the reactor.
+static Usage runThreads(const std::vector<std::unique_ptr<Bus>> &buses, const BenchOptions &options, uint64_t &sent)
+{
+    std::vector<QThread *> threads;
+    std::vector<QSocketNotifier *> notifiers;
+    for (const std::unique_ptr<Bus> &bus : buses)
+    {
+        Bus *target = bus.get();
+        QThread *thread = new QThread;
+        QSocketNotifier *notifier = new QSocketNotifier(target->fd(), QSocketNotifier::Read);
+        QObject::connect(notifier, &QSocketNotifier::activated, notifier, [target]() { target->drain(); });
+        notifier->moveToThread(thread);
+        thread->start();
+        threads.push_back(thread);
+        notifiers.push_back(notifier);
+    }
+
+    Usage usage = runSender(buses, options, sent);
+
+    for (size_t i = 0; i < threads.size(); ++i)
+    {
+        threads[i]->quit();
+        threads[i]->wait();
+        delete notifiers[i];
+        delete threads[i];
+    }
+    return usage;
+}
+
+// Function: One IoReactor thread for all buses, as in the Dashboard with ENABLE_IO_REACTOR.
+static Usage runReactor(const std::vector<std::unique_ptr<Bus>> &buses, const BenchOptions &options, uint64_t &sent,
+                        IoReactor::Stats &stats)
+{
+    IoReactor reactor;
+    for (const std::unique_ptr<Bus> &bus : buses)
+    {
+        Bus *target = bus.get();
+        reactor.add(target->fd(), "bench", [target]() { return target->drain(); });
+    }
+    if (!reactor.start())
+    {
+        fprintf(stderr, "Failed to start the I/O reactor\n");
+        exit(1);
+    }
+
+    Usage usage = runSender(buses, options, sent);
+
+    reactor.stop();
+    stats = reactor.stats();
+    return usage;
+}
+
+// Function: Runs one mode on fresh sockets and prints its line.
+static void runMode(const std::string &mode, const BenchOptions &options)
+{
+    std::vector<std::unique_ptr<Bus>> buses;
+    for (int i = 0; i < options.buses; ++i)
+    {
+        buses.emplace_back(new Bus);
+    }
+
+    uint64_t sent = 0;
+    IoReactor::Stats stats = {0, 0, 0, 0};
+    bool reactor = mode == "reactor";
+    Usage usage = reactor ? runReactor(buses, options, sent, stats) : runThreads(buses, options, sent);
+
+    uint64_t frames = 0, invalid = 0, drops = 0, latencySumNs = 0, latencyMaxNs = 0;
+    for (const std::unique_ptr<Bus> &bus : buses)
+    {
+        frames += bus->frames();
+        invalid += bus->invalid();
+        drops += bus->kernelDrops();
+        latencySumNs += bus->latencySumNs();
+        latencyMaxNs = bus->latencyMaxNs() > latencyMaxNs ? bus->latencyMaxNs() : latencyMaxNs;
+    }
+    double perFrame = frames > 0 ? 1.0 / static_cast<double>(frames) : 0.0;
+
+    printf("%-8s %7d %10llu %10llu %7llu %9.3f %9.3f %10.0f %10.1f %10.1f\n", mode.c_str(),
+           reactor ? 1 : options.buses, static_cast<unsigned long long>(sent),
+           static_cast<unsigned long long>(frames), static_cast<unsigned long long>(drops + invalid),
+           usage.voluntary * perFrame, usage.involuntary * perFrame, usage.cpuNs * perFrame,
+           latencySumNs * perFrame / 1000.0, latencyMaxNs / 1000.0);
+    if (reactor && frames > 0)
+    {
+        printf("         reactor: %.3f frames per wakeup, %.3f frames per dispatch\n",
+               stats.wakeups > 0 ? static_cast<double>(frames) / stats.wakeups : 0.0,
+               stats.dispatches > 0 ? static_cast<double>(frames) / stats.dispatches : 0.0);
+    }
+}
+
+// Function: Prints the command-line usage.
+static void printUsage(const char *program)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --buses N       bus sockets served at once (default 4)\n"
+            "  --rate HZ       frames per second and bus (default 1000)\n"
+            "  --duration S    seconds per mode (default 5)\n"
+            "  --mode M        threads, reactor or both (default both)\n",
+            program);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    BenchOptions options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            printUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        }
+        std::string value = argv[++i];
+        if (arg == "--buses" && atoi(value.c_str()) > 0)
+        {
+            options.buses = atoi(value.c_str());
+        }
+        else if (arg == "--rate" && atof(value.c_str()) > 0.0)
+        {
+            options.rate = atof(value.c_str());
+        }
+        else if (arg == "--duration" && atof(value.c_str()) > 0.0)
+        {
+            options.duration = atof(value.c_str());
+        }
+        else if (arg == "--mode" && (value == "threads" || value == "reactor" || value == "both"))
+        {
+            options.mode = value;
+        }
+        else
+        {
+            fprintf(stderr, "Invalid option %s %s\n", arg.c_str(), value.c_str());
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    printf("%d buses at %.0f Hz for %.1f s (receiving side only; switches and CPU per received frame)\n",
+           options.buses, options.rate, options.duration);
+    printf("%-8s %7s %10s %10s %7s %9s %9s %10s %10s %10s\n", "mode", "threads", "sent", "received", "drops",
+           "vol cs", "invol cs", "cpu ns", "lat us", "max us");
+    if (options.mode != "reactor")
+    {
+        runMode("threads", options);
+    }
+    if (options.mode != "threads")
+    {
+        runMode("reactor", options);
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include "SampleRing.h"
+
+// Rounds n up to the next power of two (minimum 2)
+static size_t roundUpPow2(size_t n)
+{
+    size_t capacity = 2;
+    while (capacity < n)
+    {
+        capacity <<= 1;
+    }
+    return capacity;
+}
+
+// Constructor: Allocates the slots; no consumers yet
+SampleRing::SampleRing(size_t capacity)
+    : m_capacity(roundUpPow2(capacity)), m_mask(m_capacity - 1), m_slots(new Slot[m_capacity]),
+      m_head(0), m_gateLimit(0), m_rejected(0), m_epoch(0), m_consumerCount(0), m_hasWakeHooks(false)
+{
+    for (size_t i = 0; i < m_capacity; ++i)
+    {
+        m_slots[i].sequence.store(0, std::memory_order_relaxed);
+    }
+}
+
+// Registers a consumer starting at the current write position. DropNewest consumers should be added
+// before the producer starts, otherwise the producer may overwrite a few samples they have not read yet.
+int SampleRing::addConsumer(OverflowPolicy policy, std::function<void()> wakeHook)
+{
+    int index = m_consumerCount.load(std::memory_order_relaxed);
+    if (index >= kMaxConsumers)
+    {
+        return -1;
+    }
+
+    std::unique_ptr<Cursor> cursor(new Cursor);
+    cursor->position.store(m_head.load(std::memory_order_acquire), std::memory_order_relaxed);
+    cursor->overruns.store(0, std::memory_order_relaxed);
+    cursor->armed.store(true, std::memory_order_relaxed);
+    cursor->policy = policy;
+    cursor->wakeHook = std::move(wakeHook);
+    bool hasHook = static_cast<bool>(cursor->wakeHook);
+    m_cursors[index] = std::move(cursor);
+
+    m_consumerCount.store(index + 1, std::memory_order_release);
+    if (hasHook)
+    {
+        m_hasWakeHooks.store(true, std::memory_order_release);
+    }
+    return index;
+}
+
+// Arms the wake hook; reports samples that slipped in before the hook was armed
+bool SampleRing::arm(int consumer)
+{
+    Cursor &cursor = *m_cursors[consumer];
+    cursor.armed.store(true, std::memory_order_seq_cst);
+    if (m_head.load(std::memory_order_seq_cst) != cursor.position.load(std::memory_order_relaxed))
+    {
+        // If the producer already took the arming, its hook call will wake us instead
+        return cursor.armed.exchange(false, std::memory_order_acq_rel);
+    }
+    return false;
+}
+
+// Moves the consumer's cursor to the current write position
+void SampleRing::skipToEnd(int consumer)
+{
+    m_cursors[consumer]->position.store(m_head.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+// Computes the write position limit imposed by DropNewest consumers. Without any, the limit is one ring
+// ahead so it is re-evaluated periodically and picks up newly added consumers.
+uint64_t SampleRing::gateLimit(uint64_t head) const
+{
+    uint64_t slowest = head;
+    int count = m_consumerCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i)
+    {
+        const Cursor &cursor = *m_cursors[i];
+        if (cursor.policy == DropNewest)
+        {
+            uint64_t position = cursor.position.load(std::memory_order_acquire);
+            if (position < slowest)
+            {
+                slowest = position;
+            }
+        }
+    }
+    return slowest + m_capacity;
+}
+
+// Calls the hook of every consumer that re-armed it since its last wake
+void SampleRing::wakeConsumers()
+{
+    int count = m_consumerCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i)
+    {
+        Cursor &cursor = *m_cursors[i];
+        if (cursor.wakeHook && cursor.armed.load(std::memory_order_seq_cst) &&
+            cursor.armed.exchange(false, std::memory_order_acq_rel))
+        {
+            cursor.wakeHook();
+        }
+    }
+}
@@ -0,0 +1,237 @@
+#ifndef SAMPLERING_H
+#define SAMPLERING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+// Struct: SignalSample
+// Description: One decoded bus frame as passed from a receiver thread to its consumers.
+//   - timestampNs: CLOCK_REALTIME receive time.
+//   - id: CAN ID, LIN ID or FlexRay slot; 0 for plain UDP.
+//   - length/payload: Raw frame payload (at most 8 bytes).
+//   - fields: SampleField bits telling which values below are valid.
+//   - epoch: Low 16 bits of the ring's capture epoch when the sample was pushed; set by SampleRing::push().
+//   - speed: Raw speed in meters per second; rpm, fuel, temperature in their bus units.
+//   - sentNs/receivedNs/decodedNs: CLOCK_MONOTONIC sender stamp, kernel receive time and decode time of
+//     binary wire format frames (see LatencyRecorder); all 0 for frames without a sender stamp.
+struct SignalSample
+{
+    uint64_t timestampNs;
+    uint32_t id;
+    uint8_t length;
+    uint8_t fields;
+    uint16_t epoch;
+    uint8_t payload[8];
+    float speed;
+    float rpm;
+    float fuel;
+    float temperature;
+    uint64_t sentNs;
+    uint64_t receivedNs;
+    uint64_t decodedNs;
+};
+
+// Valid-value bits of SignalSample::fields
+enum SampleField : uint8_t
+{
+    SpeedField = 1 << 0,
+    RpmField = 1 << 1,
+    FuelField = 1 << 2,
+    TemperatureField = 1 << 3,
+};
+
+// Class: SampleRing
+// Description: Lock-free ring of SignalSample records with one producer (the receiver thread) and a small,
+//              fixed set of consumers, each with its own read cursor. Every consumer sees every sample
+//              unless it falls a full ring behind, which is handled by that consumer's overflow policy:
+//   - DropNewest: the producer rejects new samples while this consumer's cursor is a full ring behind.
+//   - DropOldest: the producer overwrites unread samples; the consumer skips ahead and counts the loss.
+//              Slots carry a sequence number, so a DropOldest consumer detects a slot overwritten while it
+//              was being copied. push() and read() never allocate or take a lock.
+//              The ring also carries the capture epoch: advanceEpoch() starts a new test iteration without
+//              stopping the producer, and push() stamps the current epoch into every sample, so consumers
+//              split the stream exactly at the first sample pushed after the bump.
+class SampleRing
+{
+public:
+    enum OverflowPolicy
+    {
+        DropOldest,
+        DropNewest
+    };
+
+    static constexpr int kMaxConsumers = 4;
+
+    // Constructor: Allocates the ring.
+    // Parameters:
+    //   - capacity: Number of samples; rounded up to a power of two.
+    explicit SampleRing(size_t capacity);
+
+    SampleRing(const SampleRing &) = delete;
+    SampleRing &operator=(const SampleRing &) = delete;
+
+    // Function: Registers a consumer whose cursor starts at the current write position. May be called
+    //           while the producer is running, but only from one thread at a time.
+    // Parameters:
+    //   - policy: Overflow policy for this consumer.
+    //   - wakeHook: Optional callback run on the producer thread when a sample arrives after the
+    //               consumer re-armed it with arm(); it must be thread-safe and must not block.
+    // Returns: Consumer index, or -1 if kMaxConsumers are already registered.
+    int addConsumer(OverflowPolicy policy, std::function<void()> wakeHook = std::function<void()>());
+
+    // Function: Appends one sample. Producer thread only.
+    // Returns: false if a DropNewest consumer is a full ring behind and the sample was dropped.
+    bool push(const SignalSample &sample)
+    {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (head >= m_gateLimit)
+        {
+            m_gateLimit = gateLimit(head);
+            if (head >= m_gateLimit)
+            {
+                m_rejected.store(m_rejected.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        // Per-slot seqlock: 0 while the slot is being written, position + 1 once it is complete
+        Slot &slot = m_slots[head & m_mask];
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.sample = sample;
+        slot.sample.epoch = static_cast<uint16_t>(m_epoch.load(std::memory_order_relaxed));
+        slot.sequence.store(head + 1, std::memory_order_release);
+
+        if (m_hasWakeHooks.load(std::memory_order_relaxed))
+        {
+            // Pairs with the fence in arm(): either the consumer sees the new head or we see it armed
+            m_head.store(head + 1, std::memory_order_seq_cst);
+            wakeConsumers();
+        }
+        else
+        {
+            m_head.store(head + 1, std::memory_order_release);
+        }
+        return true;
+    }
+
+    // Function: Copies up to maxCount unread samples for a consumer, oldest first. Consumer thread only.
+    // Returns: Number of samples copied; 0 when the consumer is up to date.
+    size_t read(int consumer, SignalSample *out, size_t maxCount)
+    {
+        Cursor &cursor = *m_cursors[consumer];
+        uint64_t position = cursor.position.load(std::memory_order_relaxed);
+        uint64_t lost = 0;
+        size_t count = 0;
+        while (count < maxCount)
+        {
+            uint64_t head = m_head.load(std::memory_order_acquire);
+            if (position == head)
+            {
+                break;
+            }
+            if (head - position > m_capacity)
+            {
+                // Lapped by the producer: the oldest unread samples are gone
+                lost += head - m_capacity - position;
+                position = head - m_capacity;
+            }
+
+            const Slot &slot = m_slots[position & m_mask];
+            uint64_t before = slot.sequence.load(std::memory_order_acquire);
+            out[count] = slot.sample;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t after = slot.sequence.load(std::memory_order_relaxed);
+            ++position;
+            if (before != position || after != before)
+            {
+                // Overwritten while copying
+                ++lost;
+                continue;
+            }
+            ++count;
+        }
+        cursor.position.store(position, std::memory_order_release);
+        if (lost)
+        {
+            cursor.overruns.store(cursor.overruns.load(std::memory_order_relaxed) + lost, std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+    // Function: Re-arms the consumer's wake hook after it has read everything. Consumer thread only.
+    // Returns: true if samples arrived in the meantime and the consumer should read again.
+    bool arm(int consumer);
+
+    // Function: Discards all unread samples of a consumer. Consumer thread only.
+    void skipToEnd(int consumer);
+
+    // Function: Starts a new capture epoch; samples pushed from now on carry it. Any thread.
+    // Returns: The new epoch.
+    uint32_t advanceEpoch() { return m_epoch.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+    // Function: Current capture epoch. Any thread.
+    uint32_t epoch() const { return m_epoch.load(std::memory_order_relaxed); }
+
+    // Function: Number of slots.
+    size_t capacity() const { return m_capacity; }
+
+    // Function: Samples accepted by push().
+    uint64_t pushedCount() const { return m_head.load(std::memory_order_relaxed); }
+
+    // Function: Samples rejected by push() because a DropNewest consumer was a full ring behind.
+    uint64_t rejectedCount() const { return m_rejected.load(std::memory_order_relaxed); }
+
+    // Function: Samples a DropOldest consumer lost because they were overwritten before it read them.
+    uint64_t overrunCount(int consumer) const { return m_cursors[consumer]->overruns.load(std::memory_order_relaxed); }
+
+    // Function: Samples a consumer never received (rejected plus overrun).
+    uint64_t droppedCount(int consumer) const { return rejectedCount() + overrunCount(consumer); }
+
+private:
+    // Struct: One ring entry; sequence is position + 1 when sample is complete, 0 while it is written.
+    struct Slot
+    {
+        std::atomic<uint64_t> sequence;
+        SignalSample sample;
+    };
+
+    // Struct: Read state of one consumer, on its own cache line.
+    struct alignas(64) Cursor
+    {
+        std::atomic<uint64_t> position;
+        std::atomic<uint64_t> overruns;
+        std::atomic<bool> armed;
+        OverflowPolicy policy;
+        std::function<void()> wakeHook;
+    };
+
+    // Function: First write position at which the slowest DropNewest consumer would be overwritten.
+    uint64_t gateLimit(uint64_t head) const;
+
+    // Function: Runs the wake hook of every armed consumer.
+    void wakeConsumers();
+
+    // Member: Ring storage; m_capacity is a power of two and m_mask = m_capacity - 1.
+    size_t m_capacity;
+    uint64_t m_mask;
+    std::unique_ptr<Slot[]> m_slots;
+
+    // Member: Producer state: next write position, cached gate and rejected samples.
+    alignas(64) std::atomic<uint64_t> m_head;
+    uint64_t m_gateLimit;
+    std::atomic<uint64_t> m_rejected;
+
+    // Member: Capture epoch; written once per reset, read on every push.
+    alignas(64) std::atomic<uint32_t> m_epoch;
+
+    // Member: Registered consumers.
+    alignas(64) std::atomic<int> m_consumerCount;
+    std::atomic<bool> m_hasWakeHooks;
+    std::unique_ptr<Cursor> m_cursors[kMaxConsumers];
+};
+
+#endif // SAMPLERING_H
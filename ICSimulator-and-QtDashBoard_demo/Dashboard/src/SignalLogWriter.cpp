@@ -0,0 +1,236 @@
+#include "SignalLogWriter.h"
+#include <QDebug>
+#include <QString>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+// Interval at which the writer thread polls the ring
+static constexpr std::chrono::milliseconds kPollInterval(20);
+
+// Samples moved from the ring to the capture per batch
+static constexpr size_t kBatchSize = 1024;
+
+// Constructor: Opens the capture file, registers on the ring and starts the writer thread
+SignalLogWriter::SignalLogWriter(const std::string &baseName, sigcap::Bus bus, SampleRing *ring)
+    : m_baseName(baseName), m_bus(bus), m_ring(ring), m_consumer(-1), m_ticketsIssued(0), m_ticketsDone(0),
+      m_stop(false), m_segmentEpoch(ring->epoch()), m_previousEpoch(0), m_hasPrevious(false)
+{
+    // Preallocate the batch buffers so draining never allocates
+    m_samples.resize(kBatchSize);
+    m_records.resize(kBatchSize);
+
+    // The log must not silently lose samples, so it holds the producer back instead of being overrun
+    m_consumer = m_ring->addConsumer(SampleRing::DropNewest);
+    if (m_consumer < 0)
+    {
+        qWarning() << "No free consumer slot on the sample ring for" << QString::fromStdString(m_baseName);
+    }
+
+    if (!m_capture.open(recordFilename(m_segmentEpoch), m_bus))
+    {
+        qWarning() << "Failed to open" << QString::fromStdString(recordFilename(m_segmentEpoch)) << "for writing";
+    }
+
+    m_thread = std::thread(&SignalLogWriter::run, this);
+}
+
+// Destructor: Drains the ring and stops the writer thread
+SignalLogWriter::~SignalLogWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wakeCv.notify_one();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+    m_capture.close();
+}
+
+// Waits until the writer thread has written every sample pushed so far
+void SignalLogWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    uint64_t ticket = ++m_ticketsIssued;
+    m_wakeCv.notify_one();
+    m_drainedCv.wait(lock, [this, ticket] { return m_ticketsDone >= ticket || m_stop; });
+}
+
+// Writer thread: polls the ring and appends new samples to the record file
+void SignalLogWriter::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_wakeCv.wait_for(lock, kPollInterval, [this] { return m_stop || m_ticketsIssued > m_ticketsDone; });
+        uint64_t tickets = m_ticketsIssued;
+        bool stop = m_stop;
+        lock.unlock();
+
+        // Samples of the previous epoch still in the ring are written to its segment first; then an advanced
+        // epoch starts a new segment even before its first sample, so an export after a reset never returns
+        // the previous iteration
+        uint32_t epoch = m_ring->epoch();
+        if (m_consumer >= 0)
+        {
+            drainRing();
+        }
+        if (static_cast<int32_t>(epoch - m_segmentEpoch) > 0)
+        {
+            rotate(epoch);
+        }
+
+        lock.lock();
+        m_ticketsDone = tickets;
+        m_drainedCv.notify_all();
+        if (stop)
+        {
+            break;
+        }
+    }
+}
+
+// Moves every unread speed/RPM sample of the current epoch from the ring to the capture and publishes the
+// new record count; older samples are skipped, a newer one rotates to its segment first
+void SignalLogWriter::drainRing()
+{
+    size_t count;
+    while ((count = m_ring->read(m_consumer, m_samples.data(), m_samples.size())) > 0)
+    {
+        size_t kept = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const SignalSample &sample = m_samples[i];
+            // Samples carry the low 16 bits of the epoch; the signed distance survives the wrap
+            int16_t age = static_cast<int16_t>(sample.epoch - static_cast<uint16_t>(m_segmentEpoch));
+            if (age < 0)
+            {
+                continue;
+            }
+            if (age > 0)
+            {
+                appendRecords(kept);
+                kept = 0;
+                rotate(m_segmentEpoch + static_cast<uint32_t>(age));
+            }
+            // Database messages without a speed or RPM gauge (EngineStatus, Steering, ...) only feed the
+            // gauges; as records they would export as zero speed/RPM rows
+            if (!(sample.fields & (SpeedField | RpmField)))
+            {
+                continue;
+            }
+
+            sigcap::Record &record = m_records[kept++];
+            memset(&record, 0, sizeof(record));
+            record.timestampNs = sample.timestampNs;
+            record.id = sample.id;
+            record.bus = static_cast<uint8_t>(m_bus);
+            record.length = sample.length;
+            memcpy(record.payload, sample.payload, sizeof(record.payload));
+            record.speed = sample.speed;
+            record.rpm = sample.rpm;
+        }
+        appendRecords(kept);
+    }
+}
+
+// Appends the first count converted records to the capture and commits them
+void SignalLogWriter::appendRecords(size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    if (!m_capture.append(m_records.data(), count) || !m_capture.commit())
+    {
+        qWarning() << "Failed to append" << count << "records to"
+                   << QString::fromStdString(recordFilename(m_segmentEpoch));
+    }
+}
+
+// Closes the current segment and starts the one of an epoch; two segments stay on disk
+void SignalLogWriter::rotate(uint32_t epoch)
+{
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    if (m_hasPrevious)
+    {
+        // A segment still being exported is deleted by its last export instead
+        if (std::find(m_pinned.begin(), m_pinned.end(), m_previousEpoch) != m_pinned.end())
+        {
+            m_retired.push_back(m_previousEpoch);
+        }
+        else
+        {
+            std::remove(recordFilename(m_previousEpoch).c_str());
+        }
+    }
+    m_previousEpoch = m_segmentEpoch;
+    m_hasPrevious = true;
+    m_segmentEpoch = epoch;
+    if (!m_capture.open(recordFilename(epoch), m_bus))
+    {
+        qWarning() << "Failed to open" << QString::fromStdString(recordFilename(epoch)) << "for writing";
+    }
+    qDebug() << "Signal log" << QString::fromStdString(m_baseName) << "rotated to epoch" << epoch;
+}
+
+// Converts the segment of an epoch to a JSON array in jsonFilename()
+bool SignalLogWriter::exportJsonArray(uint32_t epoch)
+{
+    // Each writer pass ends on the ring's epoch, so afterwards the requested epoch is the current segment
+    // or, after a reset, the previous one
+    flush();
+
+    {
+        std::lock_guard<std::mutex> lock(m_fileMutex);
+        if (epoch != m_segmentEpoch && !(m_hasPrevious && epoch == m_previousEpoch))
+        {
+            qWarning() << "Signal log" << QString::fromStdString(m_baseName) << "no longer keeps epoch" << epoch
+                       << ", nothing exported";
+            return false;
+        }
+        // Pinned, the segment survives rotations until the conversion is done
+        m_pinned.push_back(epoch);
+    }
+
+    // The conversion runs unlocked: the reader maps the segment and takes its record count once on open, so
+    // records the writer thread appends meanwhile are simply not part of this export
+    bool exported = sigcap::exportJson(recordFilename(epoch), jsonFilename());
+    unpin(epoch);
+    if (!exported)
+    {
+        qWarning() << "Failed to export" << QString::fromStdString(recordFilename(epoch)) << "to"
+                   << QString::fromStdString(jsonFilename());
+        return false;
+    }
+    qDebug() << "Exported epoch" << epoch << "to" << QString::fromStdString(jsonFilename());
+    return true;
+}
+
+// Drops one pin of an epoch; the last one deletes the segment if it was rotated out
+void SignalLogWriter::unpin(uint32_t epoch)
+{
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    m_pinned.erase(std::find(m_pinned.begin(), m_pinned.end(), epoch));
+    if (std::find(m_pinned.begin(), m_pinned.end(), epoch) != m_pinned.end())
+    {
+        return;
+    }
+    auto retired = std::find(m_retired.begin(), m_retired.end(), epoch);
+    if (retired != m_retired.end())
+    {
+        std::remove(recordFilename(epoch).c_str());
+        m_retired.erase(retired);
+    }
+}
+
+// Returns the number of samples lost to this log
+uint64_t SignalLogWriter::droppedCount() const
+{
+    return m_consumer >= 0 ? m_ring->droppedCount(m_consumer) : 0;
+}
@@ -0,0 +1,126 @@
+#ifndef SIGNALLOGWRITER_H
+#define SIGNALLOGWRITER_H
+
+#include "SignalCapture.hpp"
+#include "SampleRing.h"
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Class: SignalLogWriter
+// Description: Append-only signal log of one bus. A background thread consumes the receiver's SampleRing
+//              (as a DropNewest consumer, so the log never has gaps it did not count) and appends the
+//              samples carrying speed or RPM as fixed-size records to a binary capture; other signal
+//              database messages only drive the gauges. The JSON array expected by Autoware is only
+//              produced on export.
+//              Every epoch of the ring is written to its own segment file "<baseName>.<epoch>.sigcap": when
+//              the writer thread meets the first sample of a newer epoch (or sees the ring's epoch advance),
+//              it closes the segment and continues in a new one, and samples still tagged with an older epoch
+//              are skipped. The previous segment is kept until the next rotation, so an export requested
+//              before a reset still finds its records after it; a segment being exported is only deleted once
+//              the export is done. Exports convert without holding the file lock, so they never stall the
+//              writer thread (and through it the ring). A reset therefore only bumps the ring's
+//              epoch; the receivers keep pushing throughout.
+class SignalLogWriter
+{
+public:
+    // Constructor: Opens (and truncates) the segment file of the ring's epoch, registers as a consumer of the
+    //              ring and starts the writer thread. Create it before the receiver starts pushing into the ring.
+    // Parameters:
+    //   - baseName: File name without extension (e.g., "can_protocol_receiver").
+    //   - bus: Bus recorded in the capture header and in every record.
+    //   - ring: Sample ring of the bus receiver (not owned; must outlive the writer).
+    SignalLogWriter(const std::string &baseName, sigcap::Bus bus, SampleRing *ring);
+
+    // Destructor: Writes the samples still in the ring, stops the writer thread and closes the record file.
+    ~SignalLogWriter();
+
+    SignalLogWriter(const SignalLogWriter &) = delete;
+    SignalLogWriter &operator=(const SignalLogWriter &) = delete;
+
+    // Function: Waits until every sample pushed to the ring so far has been written to the record file.
+    void flush();
+
+    // Function: Flushes the log and converts the segment of an epoch to a JSON array in jsonFilename().
+    // Parameters:
+    //   - epoch: Epoch of the segment, as returned by epoch() when the export was requested; the current
+    //            or the previous segment.
+    // Returns: true on success; false if the segment is no longer kept or the export failed.
+    bool exportJsonArray(uint32_t epoch);
+
+    // Function: Current epoch of the ring, whose samples go to the segment being written. Any thread.
+    uint32_t epoch() const { return m_ring->epoch(); }
+
+    // Function: Name of the JSON array file produced by exportJsonArray() (e.g., "can_protocol_receiver.json").
+    std::string jsonFilename() const { return m_baseName + ".json"; }
+
+    // Function: Name of the capture segment of an epoch (e.g., "can_protocol_receiver.3.sigcap").
+    std::string recordFilename(uint32_t epoch) const { return m_baseName + "." + std::to_string(epoch) + ".sigcap"; }
+
+    // Function: File name without extension (e.g., "can_protocol_receiver").
+    const std::string &baseName() const { return m_baseName; }
+
+    // Function: Number of samples lost to this log because the ring was full.
+    uint64_t droppedCount() const;
+
+private:
+    // Function: Writer thread body; drains the ring into the record file.
+    void run();
+
+    // Function: Copies every unread sample of the current epoch from the ring into the record file,
+    //           rotating to a new segment at the first sample of a newer epoch.
+    void drainRing();
+
+    // Function: Starts the segment of an epoch, keeping the current one as the previous segment and
+    //           deleting the one before. Writer thread only.
+    void rotate(uint32_t epoch);
+
+    // Function: Appends the first count entries of m_records to the capture.
+    void appendRecords(size_t count);
+
+    // Function: Releases one export pin of an epoch and deletes its segment if it was rotated out meanwhile.
+    void unpin(uint32_t epoch);
+
+    // Member: File name without extension.
+    std::string m_baseName;
+
+    // Member: Bus tag for the capture.
+    sigcap::Bus m_bus;
+
+    // Member: Ring consumed by the writer thread, and this writer's consumer index.
+    SampleRing *m_ring;
+    int m_consumer;
+
+    // Member: Preallocated batch of samples read from the ring and their converted records.
+    std::vector<SignalSample> m_samples;
+    std::vector<sigcap::Record> m_records;
+
+    // Member: Request state, guarded by m_mutex. Each flush takes a ticket; the writer thread completes
+    //         every ticket issued before its current pass started.
+    std::mutex m_mutex;
+    std::condition_variable m_wakeCv;
+    std::condition_variable m_drainedCv;
+    uint64_t m_ticketsIssued;
+    uint64_t m_ticketsDone;
+    bool m_stop;
+
+    // Member: Capture writer of the current segment, its epoch and the epoch of the previous segment kept
+    //         for export, guarded by m_fileMutex (the writer thread reads the epochs without it).
+    std::mutex m_fileMutex;
+    sigcap::Writer m_capture;
+    uint32_t m_segmentEpoch;
+    uint32_t m_previousEpoch;
+    bool m_hasPrevious;
+    // Member: Epochs of the segments being exported (one entry per export) and segments rotated out while
+    //         pinned, whose deletion waits for the last export; guarded by m_fileMutex.
+    std::vector<uint32_t> m_pinned;
+    std::vector<uint32_t> m_retired;
+
+    // Member: Background writer thread.
+    std::thread m_thread;
+};
+
+#endif // SIGNALLOGWRITER_H
@@ -20,6 +20,11 @@ TcpSignalReceiver::~TcpSignalReceiver() {
     server->close();
 }
 
+// Sets the drop counters DUMP_DROPS and RESET_DROPS act on
+void TcpSignalReceiver::setDropCounters(const QList<DropCounters *> &dropCounters) {
+    dropCounters_ = dropCounters;
+}
+
 // Handles new TCP connections
 void TcpSignalReceiver::handleNewConnection() {
     while (server->hasPendingConnections()) {
@@ -42,6 +47,17 @@ void TcpSignalReceiver::readClientData() {
     } else if (signal == "RECEIVED_JSON") {
         qDebug() << "Received RECEIVED_JSON from" << client->peerAddress().toString();
         emit receivedJsonSignal();
+    } else if (signal == "DUMP_LATENCY") {
+        qDebug() << "Received DUMP_LATENCY from" << client->peerAddress().toString();
+        emit latencyDumpRequested();
+    } else if (signal == "DUMP_DROPS") {
+        qDebug() << "Received DUMP_DROPS from" << client->peerAddress().toString();
+        client->write(DropCounters::toJson(dropCounters_));
+    } else if (signal == "RESET_DROPS") {
+        qDebug() << "Received RESET_DROPS from" << client->peerAddress().toString();
+        for (DropCounters *counters : dropCounters_) {
+            counters->reset();
+        }
     } else {
         qWarning() << "Received invalid signal from" << client->peerAddress().toString() << ":" << signal;
     }
@@ -7,10 +7,14 @@
 #include <QString>
 #include <QDebug>
 #include <QtGlobal>
+#include <QList>
+#include "DropCounters.h"
 
 /**
  * TcpSignalReceiver manages a TCP server to listen for the SEND_JSON signal from Autoware.
  * Emits a signal to trigger JSON file transfer when SEND_JSON is received.
+ * Answers DUMP_DROPS on the same connection with the drop counters of every bus, and zeroes them on
+ * RESET_DROPS.
  */
 class TcpSignalReceiver : public QObject {
     Q_OBJECT
@@ -19,11 +23,15 @@ public:
     explicit TcpSignalReceiver(const QString &ip, quint16 port, QObject *parent = nullptr);
     // Destructor: Cleans up server resources
     ~TcpSignalReceiver();
+    // Sets the drop counters DUMP_DROPS and RESET_DROPS act on; call before moving to the TCP thread
+    void setDropCounters(const QList<DropCounters *> &dropCounters);
 
 signals:
     // Signal emitted when SEND_JSON is received
     void sendJsonFilesRequested();
     void receivedJsonSignal();
+    // Signal emitted when DUMP_LATENCY is received
+    void latencyDumpRequested();
 
 private slots:
     // Handles new incoming connections
@@ -35,6 +43,7 @@ private:
     QTcpServer *server; // TCP server instance
     QString ip_; // Server IP address
     quint16 port_; // Server port
+    QList<DropCounters *> dropCounters_; // Drop counters of every bus (not owned)
 };
 
 #endif // TCPSIGNALRECEIVER_H
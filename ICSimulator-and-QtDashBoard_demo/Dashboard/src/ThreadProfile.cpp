@@ -0,0 +1,245 @@
+#include "ThreadProfile.h"
+#include <QDebug>
+#include <QString>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <pthread.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+
+// Stores reason in error, if given, and fails
+static bool fail(std::string *error, const std::string &reason)
+{
+    if (error)
+    {
+        *error = reason;
+    }
+    return false;
+}
+
+// Name of a scheduling policy in the logs
+static const char *policyName(int policy)
+{
+    switch (policy)
+    {
+    case SCHED_FIFO:
+        return "SCHED_FIFO";
+    case SCHED_RR:
+        return "SCHED_RR";
+    default:
+        return "SCHED_OTHER";
+    }
+}
+
+// Parses the settings of one role
+static bool parseSettings(const std::string &role, const nlohmann::json &entry, ThreadSettings &settings,
+                          std::string *error)
+{
+    std::string policy = entry.value("policy", std::string("other"));
+    if (policy == "fifo")
+    {
+        settings.policy = SCHED_FIFO;
+    }
+    else if (policy == "rr")
+    {
+        settings.policy = SCHED_RR;
+    }
+    else if (policy == "other")
+    {
+        settings.policy = SCHED_OTHER;
+    }
+    else
+    {
+        return fail(error, role + ": policy must be fifo, rr or other");
+    }
+
+    settings.priority = entry.value("priority", settings.policy == SCHED_OTHER ? 0 : 1);
+    settings.nice = entry.value("nice", 0);
+    if (settings.policy != SCHED_OTHER && (settings.priority < 1 || settings.priority > 99))
+    {
+        return fail(error, role + ": priority must be 1 to 99");
+    }
+    if (settings.nice < -20 || settings.nice > 19)
+    {
+        return fail(error, role + ": nice must be -20 to 19");
+    }
+    if (entry.contains("cpus"))
+    {
+        for (const nlohmann::json &cpu : entry.at("cpus"))
+        {
+            int index = cpu.get<int>();
+            if (index < 0)
+            {
+                return fail(error, role + ": negative CPU index");
+            }
+            settings.cpus.push_back(index);
+        }
+    }
+    return true;
+}
+
+// Loads a profile file
+bool ThreadProfile::load(const std::string &path, std::string *error)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        m_loaded = false;
+        return fail(error, "cannot open " + path);
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    return loadFromString(text.str(), error);
+}
+
+// Parses a profile, replacing the previous one; on failure the profile is left unloaded
+bool ThreadProfile::loadFromString(const std::string &text, std::string *error)
+{
+    m_loaded = false;
+    m_lockMemory = false;
+    m_roles.clear();
+    std::map<std::string, ThreadSettings> roles;
+    bool lockMemory = false;
+    try
+    {
+        nlohmann::json root = nlohmann::json::parse(text);
+        lockMemory = root.value("lockMemory", false);
+        if (root.contains("threads"))
+        {
+            for (auto it = root.at("threads").begin(); it != root.at("threads").end(); ++it)
+            {
+                ThreadSettings settings;
+                if (!parseSettings(it.key(), it.value(), settings, error))
+                {
+                    return false;
+                }
+                roles[it.key()] = settings;
+            }
+        }
+    }
+    catch (const nlohmann::json::exception &e)
+    {
+        return fail(error, e.what());
+    }
+    m_roles = std::move(roles);
+    m_lockMemory = lockMemory;
+    m_loaded = true;
+    return true;
+}
+
+// Settings of a role, or the defaults
+ThreadSettings ThreadProfile::settings(const std::string &role) const
+{
+    auto it = m_roles.find(role);
+    return it != m_roles.end() ? it->second : ThreadSettings();
+}
+
+// Applies a role to the calling thread
+bool ThreadProfile::applyToCurrentThread(const std::string &role) const
+{
+    if (!m_loaded)
+    {
+        return true;
+    }
+    return apply(settings(role), role);
+}
+
+// Locks the process memory if asked for and allowed
+bool ThreadProfile::applyMemoryLock() const
+{
+    if (!m_loaded || !m_lockMemory)
+    {
+        return true;
+    }
+
+    // MCL_FUTURE over a finite lock limit would make later allocations fail once the limit is reached,
+    // so an unprivileged process with a limit does not lock at all
+    struct rlimit limit;
+    if (geteuid() != 0 && getrlimit(RLIMIT_MEMLOCK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY)
+    {
+        qWarning() << "Memory not locked: RLIMIT_MEMLOCK is" << static_cast<qulonglong>(limit.rlim_cur)
+                   << "bytes; raise it to unlimited (ulimit -l) or run with CAP_IPC_LOCK";
+        return false;
+    }
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) < 0)
+    {
+        qWarning() << "Memory not locked:" << strerror(errno);
+        return false;
+    }
+    qInfo() << "Process memory locked";
+    return true;
+}
+
+// Applies settings to the calling thread
+bool ThreadProfile::apply(const ThreadSettings &settings, const std::string &name)
+{
+    QString thread = QString::fromStdString(name);
+    bool applied = true;
+
+    // CPU pinning, restricted to the CPUs the host has
+    long cpuCount = sysconf(_SC_NPROCESSORS_CONF);
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    int pinned = 0;
+    for (long cpu = 0; cpu < cpuCount && cpu < CPU_SETSIZE; ++cpu)
+    {
+        bool listed = settings.cpus.empty();
+        for (int index : settings.cpus)
+        {
+            listed = listed || index == cpu;
+        }
+        if (listed)
+        {
+            CPU_SET(cpu, &cpus);
+            ++pinned;
+        }
+    }
+    int rc = pinned > 0 ? pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus) : EINVAL;
+    bool affinitySet = rc == 0;
+    if (!affinitySet)
+    {
+        qWarning() << "Thread" << thread << "keeps its CPU affinity:" << (pinned > 0 ? strerror(rc) : "no listed CPU exists");
+        applied = false;
+    }
+
+    // Real-time policy, falling back to SCHED_OTHER and the nice value when refused
+    int policy = settings.policy;
+    if (policy != SCHED_OTHER)
+    {
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = settings.priority;
+        rc = pthread_setschedparam(pthread_self(), policy, &param);
+        if (rc != 0)
+        {
+            qWarning() << "Thread" << thread << "cannot use" << policyName(policy) << "priority" << settings.priority
+                       << "(" << strerror(rc) << "), falling back to SCHED_OTHER nice" << settings.nice;
+            policy = SCHED_OTHER;
+            applied = false;
+        }
+    }
+    if (policy == SCHED_OTHER)
+    {
+        // Leaves a real-time policy inherited from the creating thread, which is always allowed
+        struct sched_param param;
+        memset(&param, 0, sizeof(param));
+        pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+
+        // The nice value is per thread on Linux, addressed by thread ID
+        if (setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), settings.nice) < 0)
+        {
+            qWarning() << "Thread" << thread << "cannot use nice" << settings.nice << ":" << strerror(errno);
+            applied = false;
+        }
+    }
+
+    int level = policy == SCHED_OTHER ? getpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid))) : settings.priority;
+    qInfo() << "Thread" << thread << "runs" << policyName(policy) << (policy == SCHED_OTHER ? "nice" : "priority")
+            << level << "on" << (affinitySet ? QString::number(pinned) : QString("inherited")) << "CPUs";
+    return applied;
+}
@@ -0,0 +1,76 @@
+#ifndef THREADPROFILE_H
+#define THREADPROFILE_H
+
+#include <map>
+#include <sched.h>
+#include <string>
+#include <vector>
+
+// Struct: ThreadSettings
+// Description: Scheduling of one Dashboard thread.
+//   - policy: SCHED_OTHER, SCHED_FIFO or SCHED_RR.
+//   - priority: Real-time priority (1-99) under SCHED_FIFO/SCHED_RR; ignored under SCHED_OTHER.
+//   - nice: Nice value (-20 to 19) under SCHED_OTHER, and the fallback when a real-time policy is refused.
+//   - cpus: CPUs the thread may run on; empty for every CPU. CPUs the host does not have are ignored.
+struct ThreadSettings
+{
+    int policy = SCHED_OTHER;
+    int priority = 0;
+    int nice = 0;
+    std::vector<int> cpus;
+};
+
+// Class: ThreadProfile
+// Description: Per-thread scheduling policy, priority and CPU pinning of the Dashboard, plus optional
+//              memory locking, loaded from a JSON file (see Dashboard/thread_profile.json):
+//
+//                {"lockMemory": false,
+//                 "threads": {"can": {"policy": "fifo", "priority": 70, "nice": -5, "cpus": [2, 3]},
+//                             "gui": {"policy": "other", "cpus": [0, 1]}}}
+//
+//              Roles are "can", "udp", "flexray", "lin", "reactor" (the IoReactor thread), "tcp" and "gui"
+//              (the Qt main thread, whose settings the Qt Quick render thread inherits). Each thread applies
+//              its role to itself as it starts; roles the file does not list get SCHED_OTHER, nice 0 and
+//              every CPU, so no thread keeps settings inherited from the thread that created it.
+//
+//              Nothing here is fatal: without CAP_SYS_NICE a real-time policy falls back to SCHED_OTHER
+//              with the role's nice value, a nice value below the current one may be refused as well, a
+//              CPU list naming no CPU of the host leaves the affinity alone, and memory is only locked
+//              when the lock limit allows it. Every fallback is logged with qWarning.
+class ThreadProfile
+{
+public:
+    // Function: Loads a profile file; on failure the profile is left unloaded and error says why.
+    bool load(const std::string &path, std::string *error = nullptr);
+
+    bool loadFromString(const std::string &text, std::string *error = nullptr);
+
+    // Function: Whether a profile was loaded; an unloaded profile leaves every thread alone.
+    bool isLoaded() const { return m_loaded; }
+
+    // Function: Settings of a role, the defaults for a role the profile does not list.
+    ThreadSettings settings(const std::string &role) const;
+
+    // Function: Applies the settings of a role to the calling thread. Does nothing if no profile is loaded.
+    // Returns: false if any setting had to fall back.
+    bool applyToCurrentThread(const std::string &role) const;
+
+    // Function: Locks the current and future pages of the process (mlockall) if the profile asks for it.
+    // Returns: false if locking was asked for and refused.
+    bool applyMemoryLock() const;
+
+    // Function: Applies settings to the calling thread, logging every fallback.
+    // Parameters:
+    //   - settings: Policy, priority, nice value and CPUs.
+    //   - name: Thread name used in the logs.
+    // Returns: false if any setting had to fall back.
+    static bool apply(const ThreadSettings &settings, const std::string &name);
+
+private:
+    // Member: Whether load() succeeded, and the settings by role.
+    bool m_loaded = false;
+    bool m_lockMemory = false;
+    std::map<std::string, ThreadSettings> m_roles;
+};
+
+#endif // THREADPROFILE_H
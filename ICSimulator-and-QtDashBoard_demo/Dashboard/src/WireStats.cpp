@@ -0,0 +1,21 @@
+#include "WireStats.h"
+#include <QDebug>
+
+// Logs the counters of a binary frame stream
+void logWireStats(const char *bus, const wire::StreamStats &stats)
+{
+    if (stats.received == 0)
+    {
+        return;
+    }
+    double averageUs = stats.latencyCount ? stats.latencySumNs / 1000.0 / stats.latencyCount : 0.0;
+    qInfo().noquote() << QString("%1 binary frames received: %2, lost: %3, duplicates: %4, reordered: %5, "
+                                 "latency avg %6 us, max %7 us")
+                             .arg(bus)
+                             .arg(stats.received)
+                             .arg(stats.lost)
+                             .arg(stats.duplicates)
+                             .arg(stats.reordered)
+                             .arg(averageUs, 0, 'f', 1)
+                             .arg(stats.latencyMaxNs / 1000.0, 0, 'f', 1);
+}
@@ -0,0 +1,12 @@
+#ifndef WIRESTATS_H
+#define WIRESTATS_H
+
+#include "WireFormat.hpp"
+
+// Function: Logs the loss, duplication, reordering and latency counters of one binary frame stream.
+// Parameters:
+//   - bus: Bus name used as the log prefix (e.g. "UDP").
+//   - stats: Counters of the stream; nothing is logged if no binary frame arrived.
+void logWireStats(const char *bus, const wire::StreamStats &stats);
+
+#endif // WIRESTATS_H
@@ -1,18 +1,24 @@
 #include <QtGui/QGuiApplication>
 #include <QtQml/QQmlApplicationEngine>
+#include <QQuickWindow>
 #include <QFont>
 #include <QFontDatabase>
 #include <QThread>
 #include <QDebug>
 #include <QHostAddress>
 #include <QDateTime>
-#include <QTcpSocket>
 #include <QFile>
-#include <QFileInfo>
-#include <arpa/inet.h>
 #include "UdpReceiver.h"
 #include "CanReceiver.h"
 #include "TcpSignalReceiver.h"
+#include "SignalLogWriter.h"
+#include "GaugePublisher.h"
+#include "LatencyRecorder.h"
+#include "DropCounters.h"
+#include "ExportService.h"
+#include "SampleRing.h"
+#include "IoReactor.h"
+#include "ThreadProfile.h"
 
 // Define ENABLE_FLEXRAY and ENABLE_LIN (0 = disabled, 1 = enabled)
 #define ENABLE_FLEXRAY 1
@@ -24,6 +30,39 @@
 #include "LinReceiver.h"
 #endif
 
+// Batched datagram ingestion: datagrams per recvmmsg call and per notifier wakeup
+#define RECV_BATCH_SIZE   64
+#define RECV_DRAIN_BUDGET 1024
+
+// Bus receivers served by one epoll thread (IoReactor) instead of one QThread and event loop per bus
+// (0 = thread per bus, 1 = reactor). The TCP control receiver keeps its own thread either way.
+#define ENABLE_IO_REACTOR 0
+
+// Scheduling policy, priority, CPU pinning and memory locking per thread (copied next to the binary by
+// CMake); "" leaves every thread at the defaults. Settings the process may not use fall back with a warning.
+#define THREAD_PROFILE_PATH "thread_profile.json"
+
+// Multicast group the UDP (port argv[3]) and FlexRay (5002) receivers join on the interface with the own IP,
+// matching Sender --host GROUP; "" receives unicast on the own IP. Dashboards on one host can share a group.
+#define MULTICAST_GROUP ""
+
+// Samples buffered per bus between its receiver thread and the GUI/log consumers (power of two)
+#define SAMPLE_RING_CAPACITY 16384
+
+// CAN signal database decoded in addition to the speed/RPM frame (copied next to the binary by CMake)
+#define SIGNAL_DATABASE_PATH "vehicle_signals.json"
+
+// End-to-end latency histograms of sender-stamped frames (Sender --wire binary), per bus and stage.
+// Logged and written to LATENCY_HISTOGRAM_PATH on DUMP_LATENCY (TCP port 5001) and on exit.
+#define ENABLE_LATENCY_HISTOGRAMS 1
+#define LATENCY_HISTOGRAM_PATH "latency_histograms.csv"
+
+// Per-bus drop counters, written on SEND_JSON and sent to Autoware after the JSON logs
+#define DROP_COUNTERS_PATH "drop_counters.json"
+
+// Offer compressed export codecs to the receiver (1) or always send the files as they are (0)
+#define ENABLE_EXPORT_COMPRESSION 1
+
 // Logging configuration macros
 #define ENABLE_DEBUG_LOGGING    1
 #define ENABLE_INFO_LOGGING     1
@@ -43,62 +82,6 @@
 #define qCritical() QT_NO_QDEBUG_MACRO()
 #endif
 
-void sendJsonFileOverTcp(const QString& filename, const QString& host, quint16 port, int attempt = 1, const int maxRetries = 3, const int retryDelayMs = 500) {
-    QTcpSocket socket;
-    socket.connectToHost(host, port, QIODevice::WriteOnly);
-    if (!socket.waitForConnected(2000)) {
-        qWarning() << QString("Attempt %1: Failed to connect to %2:%3 for %4").arg(attempt).arg(host).arg(port).arg(filename);
-        if (attempt < maxRetries) {
-            QThread::msleep(retryDelayMs);
-            sendJsonFileOverTcp(filename, host, port, attempt + 1, maxRetries, retryDelayMs);
-        } else {
-            qWarning() << QString("Failed to connect to %1:%2 for %3 after %4 attempts").arg(host).arg(port).arg(filename).arg(maxRetries);
-        }
-        return;
-    }
-
-    // Open and read the JSON file
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly)) {
-        qWarning() << QString("Failed to open %1: %2").arg(filename).arg(file.errorString());
-        socket.close();
-        return;
-    }
-    QByteArray fileData = file.readAll();
-    file.close();
-
-    if (fileData.isEmpty()) {
-        qWarning() << QString("JSON file is empty: %1").arg(filename);
-        socket.close();
-        return;
-    }
-
-    QString baseFilename = QFileInfo(filename).fileName();
-    QByteArray filenameBytes = baseFilename.toUtf8();
-    uint32_t filenameLength = htonl(filenameBytes.size());
-    QByteArray header;
-    header.append(reinterpret_cast<const char*>(&filenameLength), sizeof(filenameLength));
-    header.append(filenameBytes);
-
-    // Combine header and file data
-    QByteArray dataToSend = header + fileData;
-    qint64 bytesWritten = socket.write(dataToSend);
-    socket.waitForBytesWritten(2000);
-    if (bytesWritten != dataToSend.size()) {
-        qWarning() << QString("Attempt %1: Failed to send %2: %3 bytes written").arg(attempt).arg(filename).arg(bytesWritten);
-        if (attempt < maxRetries) {
-            QThread::msleep(retryDelayMs);
-            socket.close();
-            sendJsonFileOverTcp(filename, host, port, attempt + 1, maxRetries, retryDelayMs);
-        } else {
-            qWarning() << QString("Failed to send %1 after %2 attempts").arg(filename).arg(maxRetries);
-        }
-    } else {
-        qInfo() << QString("Successfully sent %1 to %2:%3 (%4 bytes)").arg(filename).arg(host).arg(port).arg(bytesWritten);
-    }
-    socket.close();
-}
-
 void clearJsonFiles(const QStringList& jsonFiles) {
     for (const QString& file : jsonFiles) {
         QFile qfile(file);
@@ -157,13 +140,95 @@ int main(int argc, char *argv[]) {
         return -1;
     }
 
+    // Threads apply their profile role as they start; the GUI thread applies its own before the QML engine
+    // creates the render thread
+    ThreadProfile threadProfile;
+    if (*THREAD_PROFILE_PATH) {
+        std::string threadProfileError;
+        if (!threadProfile.load(THREAD_PROFILE_PATH, &threadProfileError)) {
+            qWarning() << "Thread profile not loaded:" << QString::fromStdString(threadProfileError);
+        }
+    }
+    threadProfile.applyMemoryLock();
+    auto startThread = [&threadProfile](QThread *thread, const char *role) {
+        // Without a context object the slot runs directly on the thread emitting started()
+        QObject::connect(thread, &QThread::started, [&threadProfile, role]() {
+            threadProfile.applyToCurrentThread(role);
+        });
+        thread->start();
+    };
+
+    // Sample rings, one per bus: the receiver thread produces, the GUI and the signal log consume.
+    // Each carries the capture epoch that RECEIVED_JSON advances.
+    SampleRing *canRing = new SampleRing(SAMPLE_RING_CAPACITY);
+    SampleRing *udpRing = new SampleRing(SAMPLE_RING_CAPACITY);
+#if ENABLE_FLEXRAY
+    SampleRing *flexrayRing = new SampleRing(SAMPLE_RING_CAPACITY);
+#endif
+#if ENABLE_LIN
+    SampleRing *linRing = new SampleRing(SAMPLE_RING_CAPACITY);
+#endif
+
+    // Drop counters, one per bus
+    DropCounters *canDrops = new DropCounters("CAN");
+    DropCounters *udpDrops = new DropCounters("UDP");
+#if ENABLE_FLEXRAY
+    DropCounters *flexrayDrops = new DropCounters("FlexRay");
+#endif
+#if ENABLE_LIN
+    DropCounters *linDrops = new DropCounters("LIN");
+#endif
+    QList<DropCounters *> dropCounters = {
+        canDrops,
+        udpDrops
+#if ENABLE_FLEXRAY
+        ,flexrayDrops
+#endif
+#if ENABLE_LIN
+        ,linDrops
+#endif
+    };
+
+    // Append-only signal logs, one per bus; each starts a new capture segment file when its ring's epoch advances
+    SignalLogWriter *canLog = new SignalLogWriter("can_protocol_receiver", sigcap::Bus::Can, canRing);
+    SignalLogWriter *udpLog = new SignalLogWriter("udp_protocol_receiver", sigcap::Bus::Udp, udpRing);
+#if ENABLE_FLEXRAY
+    SignalLogWriter *flexrayLog = new SignalLogWriter("flexray_protocol_receiver", sigcap::Bus::FlexRay, flexrayRing);
+#endif
+#if ENABLE_LIN
+    SignalLogWriter *linLog = new SignalLogWriter("lin_protocol_receiver", sigcap::Bus::Lin, linRing);
+#endif
+    QList<SignalLogWriter *> logWriters = {
+        canLog,
+        udpLog
+#if ENABLE_FLEXRAY
+        ,flexrayLog
+#endif
+#if ENABLE_LIN
+        ,linLog
+#endif
+    };
+
+    // Loaded once; every CanReceiver compiles its decode plans from it
+    signaldb::Database signalDatabase;
+    std::string signalDatabaseError;
+    if (!signalDatabase.load(SIGNAL_DATABASE_PATH, &signalDatabaseError)) {
+        qWarning() << "Signal database not loaded:" << QString::fromStdString(signalDatabaseError);
+    }
+
+    BatchConfig batchConfig;
+    batchConfig.batchSize = RECV_BATCH_SIZE;
+    batchConfig.drainBudget = RECV_DRAIN_BUDGET;
+
     // Initialize threads for receivers
+#if !ENABLE_IO_REACTOR
     QThread *canThread = new QThread;
     QThread *udpThread = new QThread;
+#endif
     QThread *tcpThread = new QThread;
 
     // Set up CAN receiver (no IP/port, uses vcan0 interface)
-    CanReceiver *canReceiver = new CanReceiver("can2");
+    CanReceiver *canReceiver = new CanReceiver("can2", canRing, canDrops, &signalDatabase, batchConfig);
 
     // Set up UDP receiver
     // IP: Binds to Qt’s own IP (ipAddress, e.g., 192.168.0.48 or 127.0.0.1)
@@ -171,7 +236,7 @@ int main(int argc, char *argv[]) {
     // Single IP/port for receiving UDP data from vehicle signals
     // For testing with 192.168.x.x IPs:
     // - Ensure port 5000 is open on Qt’s firewall
-    UdpReceiver *udpReceiver = new UdpReceiver(ipAddress, port);
+    UdpReceiver *udpReceiver = new UdpReceiver(ipAddress, port, udpRing, udpDrops, batchConfig, MULTICAST_GROUP);
 
     // Set up TCP signal receiver for SEND_JSON signal
     // IP: Binds to Qt’s own IP (ipAddress, e.g., 192.168.0.48 or 127.0.0.1)
@@ -181,6 +246,7 @@ int main(int argc, char *argv[]) {
     // - Ensure port 5001 is open on Qt’s firewall
     // - Autoware sends to 192.168.0.48:5001
     TcpSignalReceiver *tcpReceiver = new TcpSignalReceiver(ipAddress, 5001);
+    tcpReceiver->setDropCounters(dropCounters);
 
 #if ENABLE_FLEXRAY
     // Set up FlexRay receiver
@@ -189,39 +255,61 @@ int main(int argc, char *argv[]) {
     // Single IP/port for receiving FlexRay data
     // For testing with 192.168.x.x IPs:
     // - Ensure port 5002 is open on Qt’s firewall
+    FlexRayReceiver *flexrayReceiver = new FlexRayReceiver(ipAddress, 5002, flexrayRing, flexrayDrops, batchConfig, MULTICAST_GROUP);
+#endif
+#if ENABLE_LIN
+    // Set up LIN receiver (no IP/port, not implemented)
+    LinReceiver *linReceiver = new LinReceiver(linRing, linDrops);
+#endif
+
+#if ENABLE_IO_REACTOR
+    // The bus receivers stay on the GUI thread without notifiers; the reactor thread does all their reading,
+    // decoding and ring pushes; the gauges are fed only through the sample rings and GaugePublisher
+    IoReactor *reactor = new IoReactor;
+    reactor->setThreadSetup([&threadProfile]() {
+        threadProfile.applyToCurrentThread("reactor");
+    });
+    canReceiver->attachToReactor(reactor);
+    udpReceiver->attachToReactor(reactor);
+#if ENABLE_FLEXRAY
+    flexrayReceiver->attachToReactor(reactor);
+#endif
+#if ENABLE_LIN
+    linReceiver->attachToReactor(reactor);
+#endif
+    if (!reactor->start()) {
+        qFatal("Failed to start the I/O reactor");
+    }
+#else
+    // Move receivers to their respective threads
+#if ENABLE_FLEXRAY
     QThread *flexrayThread = new QThread;
-    FlexRayReceiver *flexrayReceiver = new FlexRayReceiver(ipAddress, 5002);
     flexrayReceiver->moveToThread(flexrayThread);
-    flexrayThread->start();
+    startThread(flexrayThread, "flexray");
 #endif
 #if ENABLE_LIN
-    // Set up LIN receiver (no IP/port, not implemented)
     QThread *linThread = new QThread;
-    LinReceiver *linReceiver = new LinReceiver;
     linReceiver->moveToThread(linThread);
-    linThread->start();
+    startThread(linThread, "lin");
 #endif
-
-    // Move receivers to their respective threads
     canReceiver->moveToThread(canThread);
     udpReceiver->moveToThread(udpThread);
+    startThread(canThread, "can");
+    startThread(udpThread, "udp");
+#endif
     tcpReceiver->moveToThread(tcpThread);
-    canThread->start();
-    udpThread->start();
-    tcpThread->start();
+    startThread(tcpThread, "tcp");
 
-    QStringList jsonFiles = {
-        "can_protocol_receiver.json",
-        "udp_protocol_receiver.json"
-#if ENABLE_FLEXRAY
-        ,"flexray_protocol_receiver.json"
-#endif
-#if ENABLE_LIN
-        ,"lin_protocol_receiver.json"
-#endif
-    };
+    QStringList jsonFiles;
+    for (SignalLogWriter *writer : logWriters) {
+        jsonFiles << QString::fromStdString(writer->jsonFilename());
+    }
     clearJsonFiles(jsonFiles);
 
+    // Sends the exported logs from its own thread over one persistent connection
+    ExportService *exportService = new ExportService(autowareIp, port, ENABLE_EXPORT_COMPRESSION);
+
+    threadProfile.applyToCurrentThread("gui");
     QFontDatabase::addApplicationFont(":/resources/fonts/DejaVuSans.ttf");
     app.setFont(QFont("DejaVu Sans"));
     QQmlApplicationEngine engine(QUrl("qrc:/resources/qml/dashboard.qml"));
@@ -255,6 +343,16 @@ int main(int argc, char *argv[]) {
 #endif
         }
     }
+
+#if ENABLE_LATENCY_HISTOGRAMS
+    LatencyRecorder *latencyRecorder = new LatencyRecorder;
+#else
+    LatencyRecorder *latencyRecorder = nullptr;
+#endif
+
+    // Publish the latest ring samples to QML once per rendered frame
+    GaugePublisher *gaugePublisher = new GaugePublisher(qobject_cast<QQuickWindow *>(rootObject), latencyRecorder);
+
     if (receiver1 && receiver2
 #if ENABLE_LIN
         && receiver3
@@ -263,47 +361,14 @@ int main(int argc, char *argv[]) {
         && receiver4
 #endif
     ) {
-        // Connect UDP receiver signals to receiver1 (QML)
-        QObject::connect(udpReceiver, &UdpReceiver::speedDataReceived, receiver1,
-            [&receiver1](float speed) { receiver1->setProperty("kph", speed); });
-        QObject::connect(udpReceiver, &UdpReceiver::rpmDataReceived, receiver1,
-            [&receiver1](float rpm) { receiver1->setProperty("rpm", rpm); });
-        QObject::connect(udpReceiver, &UdpReceiver::fuelDataReceived, receiver1,
-            [&receiver1](float fuel) { receiver1->setProperty("fuel", fuel); });
-        QObject::connect(udpReceiver, &UdpReceiver::tempDataReceived, receiver1,
-            [&receiver1](float temp) { receiver1->setProperty("temperature", temp); });
-
-        // Connect CAN receiver signals to receiver2 (QML)
-        QObject::connect(canReceiver, &CanReceiver::speedDataReceived, receiver2,
-            [&receiver2](float speed) { receiver2->setProperty("kph", speed); });
-        QObject::connect(canReceiver, &CanReceiver::rpmDataReceived, receiver2,
-            [&receiver2](float rpm) { receiver2->setProperty("rpm", rpm); });
-        QObject::connect(canReceiver, &CanReceiver::fuelDataReceived, receiver2,
-            [&receiver2](float fuel) { receiver2->setProperty("fuel", fuel); });
-        QObject::connect(canReceiver, &CanReceiver::tempDataReceived, receiver2,
-            [&receiver2](float temp) { receiver2->setProperty("temperature", temp); });
-
+        // Feed each ValueSource from its bus ring; QML sees at most one update per frame
+        gaugePublisher->attach(udpRing, receiver1, "UDP");
+        gaugePublisher->attach(canRing, receiver2, "CAN");
 #if ENABLE_LIN
-        // Connect LIN receiver signals to receiver3 (QML)
-        QObject::connect(linReceiver, &LinReceiver::speedDataReceived, receiver3,
-            [&receiver3](float speed) { receiver3->setProperty("kph", speed); });
-        QObject::connect(linReceiver, &LinReceiver::rpmDataReceived, receiver3,
-            [&receiver3](float rpm) { receiver3->setProperty("rpm", rpm); });
-        QObject::connect(linReceiver, &LinReceiver::fuelDataReceived, receiver3,
-            [&receiver3](float fuel) { receiver3->setProperty("fuel", fuel); });
-        QObject::connect(linReceiver, &LinReceiver::tempDataReceived, receiver3,
-            [&receiver3](float temp) { receiver3->setProperty("temperature", temp); });
+        gaugePublisher->attach(linRing, receiver3, "LIN");
 #endif
 #if ENABLE_FLEXRAY
-        // Connect FlexRay receiver signals to receiver4 (QML)
-        QObject::connect(flexrayReceiver, &FlexRayReceiver::speedDataReceived, receiver4,
-            [&receiver4](float speed) { receiver4->setProperty("kph", speed); });
-        QObject::connect(flexrayReceiver, &FlexRayReceiver::rpmDataReceived, receiver4,
-            [&receiver4](float rpm) { receiver4->setProperty("rpm", rpm); });
-        QObject::connect(flexrayReceiver, &FlexRayReceiver::fuelDataReceived, receiver4,
-            [&receiver4](float fuel) { receiver4->setProperty("fuel", fuel); });
-        QObject::connect(flexrayReceiver, &FlexRayReceiver::tempDataReceived, receiver4,
-            [&receiver4](float temp) { receiver4->setProperty("temperature", temp); });
+        gaugePublisher->attach(flexrayRing, receiver4, "FlexRay");
 #endif
     } else {
         qWarning() << "Not all required ValueSource objects found!";
@@ -317,95 +382,92 @@ int main(int argc, char *argv[]) {
 #endif
     }
 
-    auto resetReceivers = [&]() {
-        canThread->quit();
-        canThread->wait();
-        delete canReceiver;
-        canThread->deleteLater();
-        canThread = new QThread;
-        canReceiver = new CanReceiver("can2");
-        canReceiver->moveToThread(canThread);
-        canThread->start();
-
-        udpThread->quit();
-        udpThread->wait();
-        delete udpReceiver;
-        udpThread->deleteLater();
-        udpThread = new QThread;
-        udpReceiver = new UdpReceiver(ipAddress, port);
-        udpReceiver->moveToThread(udpThread);
-        udpThread->start();
-
-#if ENABLE_FLEXRAY
-        flexrayThread->quit();
-        flexrayThread->wait();
-        delete flexrayReceiver;
-        flexrayThread->deleteLater();
-        flexrayThread = new QThread;
-        flexrayReceiver = new FlexRayReceiver(ipAddress, 5002);
-        flexrayReceiver->moveToThread(flexrayThread);
-        flexrayThread->start();
-#endif
-
-        // Reconnect signals for new receiver instances
-        if (receiver1) {
-            QObject::connect(udpReceiver, &UdpReceiver::speedDataReceived, receiver1,
-                [&receiver1](float speed) { receiver1->setProperty("kph", speed); });
-            QObject::connect(udpReceiver, &UdpReceiver::rpmDataReceived, receiver1,
-                [&receiver1](float rpm) { receiver1->setProperty("rpm", rpm); });
-            QObject::connect(udpReceiver, &UdpReceiver::fuelDataReceived, receiver1,
-                [&receiver1](float fuel) { receiver1->setProperty("fuel", fuel); });
-            QObject::connect(udpReceiver, &UdpReceiver::tempDataReceived, receiver1,
-                [&receiver1](float temp) { receiver1->setProperty("temperature", temp); });
-        }
-        if (receiver2) {
-            QObject::connect(canReceiver, &CanReceiver::speedDataReceived, receiver2,
-                [&receiver2](float speed) { receiver2->setProperty("kph", speed); });
-            QObject::connect(canReceiver, &CanReceiver::rpmDataReceived, receiver2,
-                [&receiver2](float rpm) { receiver2->setProperty("rpm", rpm); });
-            QObject::connect(canReceiver, &CanReceiver::fuelDataReceived, receiver2,
-                [&receiver2](float fuel) { receiver2->setProperty("fuel", fuel); });
-            QObject::connect(canReceiver, &CanReceiver::tempDataReceived, receiver2,
-                [&receiver2](float temp) { receiver2->setProperty("temperature", temp); });
-        }
+    QList<SampleRing *> rings = {
+        canRing,
+        udpRing
 #if ENABLE_FLEXRAY
-        if (receiver4) {
-            QObject::connect(flexrayReceiver, &FlexRayReceiver::speedDataReceived, receiver4,
-                [&receiver4](float speed) { receiver4->setProperty("kph", speed); });
-            QObject::connect(flexrayReceiver, &FlexRayReceiver::rpmDataReceived, receiver4,
-                [&receiver4](float rpm) { receiver4->setProperty("rpm", rpm); });
-            QObject::connect(flexrayReceiver, &FlexRayReceiver::fuelDataReceived, receiver4,
-                [&receiver4](float fuel) { receiver4->setProperty("fuel", fuel); });
-            QObject::connect(flexrayReceiver, &FlexRayReceiver::tempDataReceived, receiver4,
-                [&receiver4](float temp) { receiver4->setProperty("temperature", temp); });
-        }
+        ,flexrayRing
 #endif
-        qInfo() << "Receiver threads reset, ready for new data";
+#if ENABLE_LIN
+        ,linRing
+#endif
+    };
+
+    // Starts the next test iteration in place: the receivers keep their sockets and threads, samples
+    // pushed from now on carry the new epoch, and each signal log continues in a new capture segment file
+    // from the first of them, so nothing received across the reset is lost. The previous segment is kept
+    // for an export requested before the reset
+    auto advanceEpoch = [&]() {
+        uint64_t startNs = wire::monotonicNs();
+        uint32_t epoch = 0;
+        for (SampleRing *ring : rings) {
+            epoch = ring->advanceEpoch();
+        }
+        qInfo() << "Capture epoch" << epoch << "started in" << (wire::monotonicNs() - startNs) / 1000.0 << "us";
     };
 
     QObject::connect(tcpReceiver, &TcpSignalReceiver::sendJsonFilesRequested, [&]() {
-        qInfo() << "Received SEND_JSON, sending JSON files to" << autowareIp << ":" << port;
-        QThread::msleep(100);
-        for (const QString& file : jsonFiles) {
-            if (QFile::exists(file)) {
-                sendJsonFileOverTcp(file, autowareIp, port);
-            } else {
-                qWarning() << QString("JSON file does not exist: %1").arg(file);
+        qInfo() << "Received SEND_JSON, queueing JSON files for" << autowareIp << ":" << port;
+        // The export thread builds the JSON arrays from the append-only logs just before sending them, from
+        // the segments of this iteration even if RECEIVED_JSON has started the next one by then
+        QList<uint32_t> epochs;
+        for (SignalLogWriter *writer : logWriters) {
+            epochs << writer->epoch();
+        }
+        exportService->submit(jsonFiles + QStringList{DROP_COUNTERS_PATH}, [&, epochs]() {
+            for (int i = 0; i < logWriters.size(); ++i) {
+                logWriters[i]->exportJsonArray(epochs[i]);
             }
+            DropCounters::writeJson(dropCounters, DROP_COUNTERS_PATH);
+        });
+    });
+
+    auto dumpLatency = [&]() {
+        if (latencyRecorder) {
+            latencyRecorder->dump();
+            latencyRecorder->writeCsv(LATENCY_HISTOGRAM_PATH);
         }
-        qInfo() << "JSON files sent";
+    };
+
+    QObject::connect(tcpReceiver, &TcpSignalReceiver::latencyDumpRequested, [&]() {
+        qInfo() << "Received DUMP_LATENCY, dumping latency histograms to" << LATENCY_HISTOGRAM_PATH;
+        dumpLatency();
     });
 
     QObject::connect(tcpReceiver, &TcpSignalReceiver::receivedJsonSignal, [&]() {
         qInfo() << "Received RECEIVED_JSON, resetting application state";
-        clearJsonFiles(jsonFiles);
-        resetReceivers();
+        advanceEpoch();
+        // Queued behind any export still streaming the files
+        exportService->submit(QStringList(), [&]() {
+            clearJsonFiles(jsonFiles);
+        });
+        if (latencyRecorder) {
+            latencyRecorder->reset();
+        }
+        DropCounters::log(dropCounters);
+        for (DropCounters *counters : dropCounters) {
+            counters->reset();
+        }
     });
 
     QObject::connect(&app, &QCoreApplication::aboutToQuit, [&]() {
+        tcpThread->quit();
+#if ENABLE_IO_REACTOR
+        reactor->stop();
+        reactor->logStats();
+        reactor->clear();
+        delete reactor;
+        delete canReceiver;
+        delete udpReceiver;
+#if ENABLE_FLEXRAY
+        delete flexrayReceiver;
+#endif
+#if ENABLE_LIN
+        delete linReceiver;
+#endif
+#else
         canThread->quit();
         udpThread->quit();
-        tcpThread->quit();
 #if ENABLE_FLEXRAY
         flexrayThread->quit();
         flexrayThread->wait();
@@ -420,13 +482,37 @@ int main(int argc, char *argv[]) {
 #endif
         canThread->wait();
         udpThread->wait();
-        tcpThread->wait();
         delete canReceiver;
         delete udpReceiver;
-        delete tcpReceiver;
         delete canThread;
         delete udpThread;
+#endif
+        tcpThread->wait();
+        delete tcpReceiver;
         delete tcpThread;
+        delete exportService;
+        for (SignalLogWriter *writer : logWriters) {
+            qInfo() << "Signal log" << QString::fromStdString(writer->baseName())
+                    << "dropped samples:" << writer->droppedCount();
+        }
+        qDeleteAll(logWriters);
+        qInfo() << "Gauge updates received:" << gaugePublisher->receivedUpdates()
+                << "published:" << gaugePublisher->publishedUpdates()
+                << "merged:" << gaugePublisher->mergedUpdates()
+                << "overrun:" << gaugePublisher->overrunSamples();
+        delete gaugePublisher;
+        DropCounters::log(dropCounters);
+        qDeleteAll(dropCounters);
+        dumpLatency();
+        delete latencyRecorder;
+        delete canRing;
+        delete udpRing;
+#if ENABLE_FLEXRAY
+        delete flexrayRing;
+#endif
+#if ENABLE_LIN
+        delete linRing;
+#endif
     });
 
     return app.exec();
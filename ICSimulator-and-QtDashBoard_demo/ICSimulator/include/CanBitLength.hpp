@@ -0,0 +1,18 @@
+#ifndef CANBITLENGTH_HPP
+#define CANBITLENGTH_HPP
+
+#include <cstdint>
+#include <linux/can.h>
+
+// Number of bits a classic CAN data frame occupies on the wire, including the stuff bits inserted
+// after every five equal bits (SOF through CRC), the fixed CRC delimiter/ACK/EOF tail and the 3-bit
+// interframe space. Standard IDs give 47 + 8 * DLC bits before stuffing, extended IDs 67 + 8 * DLC.
+int canFrameBits(const struct can_frame& frame);
+
+// Bus utilisation of bitsPerSecond on a bus running at bitrate, in percent
+inline double busUtilisation(double bitsPerSecond, double bitrate)
+{
+    return bitrate > 0.0 ? 100.0 * bitsPerSecond / bitrate : 0.0;
+}
+
+#endif // CANBITLENGTH_HPP
@@ -0,0 +1,83 @@
+#ifndef CAPTURESINK_HPP
+#define CAPTURESINK_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "SignalCapture.hpp"
+
+// Asynchronous, append-only capture of the frames a sender puts on its buses, shared by all its channels.
+//
+// record() copies one sigcap record (bus, ID, first payload bytes, speed/RPM, CLOCK_REALTIME send time and a
+// per-bus sequence number) into a fixed lock-free single-producer/single-consumer queue and returns; it
+// never blocks, allocates or touches the file. A writer thread appends the queued records to a .sigcap
+// file straight from the queue every flushIntervalMs, or as soon as flushThreshold records are waiting.
+// When the queue is full the record is dropped and counted, so memory stays bounded and the sending
+// thread is never held back by the disk.
+class CaptureSink
+{
+public:
+    // capacity: queued records, rounded up to a power of two (32 bytes each)
+    explicit CaptureSink(size_t capacity = 65536, int64_t flushIntervalMs = 100, size_t flushThreshold = 4096);
+    ~CaptureSink();
+
+    CaptureSink(const CaptureSink&) = delete;
+    CaptureSink& operator=(const CaptureSink&) = delete;
+
+    // Creates (or truncates) the capture file and starts the writer thread
+    bool open(const std::string& path);
+
+    // Queues one sent frame; length 0 records values that were sent inside another frame. Called from
+    // one sending thread only. Returns false if the queue was full and the record was dropped.
+    bool record(sigcap::Bus bus, uint32_t id, const void* payload, size_t length, float speed, float rpm);
+
+    // Writes every queued record, stops the writer thread and closes the file
+    void close();
+
+    // Converts the closed capture to the legacy JSON array ([{"Speed":x,"RPM":y}, ...])
+    bool exportJson(const std::string& jsonPath) const;
+
+    uint64_t recordedCount() const { return m_head.load(std::memory_order_relaxed); }
+    uint64_t droppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+    uint64_t writtenCount() const { return m_written.load(std::memory_order_relaxed); }
+
+    // Prints recorded, dropped and written records and the number of file appends
+    void report(std::ostream& out) const;
+
+private:
+    static constexpr int kBusSlots = 8;
+
+    // Writer thread: waits for the interval or the threshold, then appends the queue
+    void run();
+
+    // Appends every record published so far; returns false on a write error
+    bool drain();
+
+    std::string m_path;
+    sigcap::Writer m_writer;
+    std::vector<sigcap::Record> m_queue;
+    size_t m_mask;
+    int64_t m_flushIntervalMs;
+    size_t m_flushThreshold;
+
+    alignas(64) std::atomic<uint64_t> m_head;       // Written by the sending thread
+    uint16_t m_sequences[kBusSlots];
+    std::atomic<bool> m_wakePending;
+    std::atomic<uint64_t> m_dropped;
+    alignas(64) std::atomic<uint64_t> m_tail;       // Written by the writer thread
+    std::atomic<uint64_t> m_written;
+    uint64_t m_appends;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stop;
+    std::thread m_thread;
+};
+
+#endif // CAPTURESINK_HPP
@@ -0,0 +1,43 @@
+#ifndef CAPTURESOURCE_HPP
+#define CAPTURESOURCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "SignalCapture.hpp"
+
+// One frame of a recorded capture, ready to be replayed
+struct ReplayFrame
+{
+    uint64_t timestampNs;   // Capture time relative to the first frame of its file
+    uint32_t id;            // CAN ID; 0 for UDP/FlexRay
+    sigcap::Bus bus;
+    uint8_t length;
+    uint8_t payload[8];
+};
+
+// Sequential reader of one capture file. Files are memory-mapped and read front to back, so memory use
+// does not depend on the capture length.
+class CaptureSource
+{
+public:
+    virtual ~CaptureSource() = default;
+
+    // Fetches the next frame; returns false at the end of the capture
+    virtual bool next(ReplayFrame& frame) = 0;
+};
+
+// Opens a capture for replay:
+//   - .sigcap files replay their recorded bus, IDs, raw payloads and timing.
+//   - JSON captures ([{"Speed":x,"RPM":y}, ...] arrays or one object per line) carry no timing; their
+//     records are spaced 1/untimedRateHz apart, encoded as speed/RPM payloads and sent on jsonBus
+//     (sigcap::Bus::Unknown: all of CAN, UDP and FlexRay, like the Sender).
+// Returns nullptr and sets error on failure.
+std::unique_ptr<CaptureSource> openCapture(const std::string& path, sigcap::Bus jsonBus, double untimedRateHz,
+                                           std::string& error);
+
+// Bus named by a capture file name ("can_...", "udp_...", "flexray_..."), or Unknown
+sigcap::Bus busFromFileName(const std::string& path);
+
+#endif // CAPTURESOURCE_HPP
@@ -0,0 +1,65 @@
+#ifndef DATABASETRAFFIC_HPP
+#define DATABASETRAFFIC_HPP
+
+#include <linux/can.h>
+#include <string>
+#include <vector>
+#include "PacingEngine.hpp"
+#include "SignalDatabase.hpp"
+#include "Waveform.hpp"
+
+// Periodic CAN traffic for the messages of a signal database. Every message with a cycle time becomes
+// a pacer channel at its native rate. Its signals sweep between their min and max as triangle waves,
+// each with its own phase, so every ID carries changing in-range values. Frames are packed with the
+// precompiled FramePlan of the message.
+//
+// Classic senders skip CAN FD messages. FD senders send them, and skip every classic message whose
+// signals all travel in an FD message too, so the same signal set goes out in fewer, larger frames.
+class DatabaseTraffic
+{
+public:
+    explicit DatabaseTraffic(const signaldb::Database& database, bool canFd = false);
+
+    // Loads path into database; "none" or an empty path disables database traffic
+    static bool load(const std::string& path, signaldb::Database& database);
+
+    // Adds one pacer channel per periodic message, named after the message
+    void addChannels(PacingEngine& pacer);
+
+    // Fills frame with the next values of the message behind a pacer channel; fd tells whether it is
+    // a CAN FD frame (otherwise frame.len <= 8 and the head of frame is a valid struct can_frame)
+    // Returns false if the channel does not belong to this traffic
+    bool nextFrame(int channel, struct canfd_frame& frame, bool& fd);
+
+    // Sends value instead of the sweep for signals bound to gauge, e.g. the simulated speed and RPM
+    void setGaugeValue(signaldb::Gauge gauge, double value);
+
+    // True if a message sent by this traffic carries a signal bound to gauge
+    bool carriesGauge(signaldb::Gauge gauge) const;
+
+    size_t messageCount() const { return m_messages.size(); }
+
+private:
+    static constexpr double kSweepSeconds = 20.0;
+    static constexpr size_t kGaugeCount = static_cast<size_t>(signaldb::Gauge::Temperature) + 1;
+
+    struct Entry
+    {
+        signaldb::FramePlan plan;
+        std::string name;
+        double rateHz;
+        bool fd;
+        bool bitRateSwitch;
+        uint64_t tick;
+        WaveformBank waves;             // One triangle per signal, in field order
+        std::vector<signaldb::Gauge> gauge;
+    };
+
+    std::vector<Entry> m_messages;
+    std::vector<double> m_values;
+    double m_gaugeValues[kGaugeCount];
+    bool m_gaugeSet[kGaugeCount];
+    int m_firstChannel;
+};
+
+#endif // DATABASETRAFFIC_HPP
@@ -0,0 +1,67 @@
+#ifndef FRAMEBATCHER_HPP
+#define FRAMEBATCHER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+class UringSender;
+
+// Queues frames for one datagram socket and sends the whole queue with a single sendmmsg call.
+// Works for UDP sockets (every frame carries its destination) and bound SocketCAN raw sockets,
+// where each message is one struct can_frame. Buffers are preallocated; queue() never allocates.
+class FrameBatcher
+{
+public:
+    // frameSize: largest frame queued; capacity: frames held before queue() flushes by itself
+    explicit FrameBatcher(size_t frameSize, size_t capacity = 64);
+
+    FrameBatcher(const FrameBatcher&) = delete;
+    FrameBatcher& operator=(const FrameBatcher&) = delete;
+
+    // Sets the socket and, for unconnected UDP, the destination of every frame (nullptr for CAN)
+    void attach(int fd, const struct sockaddr* destination = nullptr, socklen_t destinationLength = 0);
+
+    // Copies a frame into the queue, flushing first if the queue is full
+    // Returns false if that flush failed
+    bool queue(const void* frame, size_t length);
+
+    // Sends every queued frame; frames the socket refuses are dropped and counted
+    // Returns false if any frame was dropped
+    bool flush();
+
+    // Sends through an io_uring from now on: flush() only stages the queued frames and
+    // UringSender::submit() sends those of every batcher at once. Call after attach().
+    void useUring(UringSender* uring);
+
+    size_t pending() const { return m_count; }
+    uint64_t sentFrames() const { return m_sent; }
+    uint64_t droppedFrames() const { return m_dropped; }
+    uint64_t flushCalls() const { return m_syscalls; }
+
+private:
+    friend class UringSender;
+
+    int m_fd;
+    size_t m_frameSize;
+    size_t m_capacity;
+    size_t m_count;
+    struct sockaddr_storage m_destination;
+    socklen_t m_destinationLength;
+
+    std::vector<uint8_t> m_buffers;
+    std::vector<struct iovec> m_iovecs;
+    std::vector<struct mmsghdr> m_messages;
+
+    uint64_t m_sent;
+    uint64_t m_dropped;
+    uint64_t m_syscalls;
+
+    UringSender* m_uring;
+    int m_uringBuffer;
+    size_t m_staged;    // Frames staged on the io_uring and not yet completed
+};
+
+#endif // FRAMEBATCHER_HPP
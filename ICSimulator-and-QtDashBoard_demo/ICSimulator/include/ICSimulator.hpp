@@ -9,6 +9,7 @@
 #include <nlohmann/json.hpp>
 #include <fstream>
 #include <string>
+#include "WireFormat.hpp"
 
 class ICSimulator
 {
@@ -17,6 +18,14 @@ public:
     ~ICSimulator();
 
     bool sendCombinedData(float speed, float rpm);
+    bool sendFrame(const struct can_frame& frame);
+
+    // Switches the socket to CAN FD (CAN_RAW_FD_FRAMES); classic frames can still be sent
+    bool enableFd();
+    bool sendFdFrame(const struct canfd_frame& frame);
+
+    // Payload of the speed/RPM frame: ASCII (default) or compact binary frames
+    void setWireFormat(wire::Format format) { m_format = format; }
     // bool sendFuelData(float fuel);
     // bool sendTempData(float temp);
 
@@ -28,6 +37,8 @@ private:
 
     int m_socket;
     std::ofstream protocol_sender_json;
+    wire::Format m_format;
+    wire::Encoder m_encoder;
 };
 
 #endif // ICSIMULATOR_H
\ No newline at end of file
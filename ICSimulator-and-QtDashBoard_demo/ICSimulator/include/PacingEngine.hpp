@@ -0,0 +1,143 @@
+#ifndef PACINGENGINE_HPP
+#define PACINGENGINE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <time.h>
+
+// Command line pacing options of the simulators (sender options are parsed around them, see SenderOptions.hpp):
+//   --rate HZ             default rate of every channel (1 Hz to 10 kHz, default 10 Hz)
+//   --rate-<channel> HZ   rate of one channel, e.g. --rate-can 1000
+//   --duration S          stop after S seconds (default: run until Ctrl+C)
+//   --spin-us US          busy-wait the last US microseconds before each deadline (default 0)
+struct PacingOptions
+{
+    double rateHz = 10.0;
+    double durationSeconds = 0.0;
+    int64_t spinUs = 0;
+    std::map<std::string, double> channelRates;
+
+    // Rate of a channel: its --rate-<channel> value if given, otherwise --rate
+    double rateFor(const std::string& channel) const;
+};
+
+// Outcome of parsePacingOption()
+enum class OptionStatus
+{
+    Unknown,    // Not an option of this parser
+    Parsed,
+    Invalid     // The reason was printed
+};
+
+// Parses one pacing option and its value. channels lists the names --rate-<channel> accepts.
+OptionStatus parsePacingOption(const std::string& name, const char* value, const std::vector<std::string>& channels,
+                               PacingOptions& options);
+
+// Prints the usage lines of the pacing options
+void printPacingUsage(std::ostream& out, const std::vector<std::string>& channels);
+
+// Parses a non-negative number; returns false if text is not one
+bool parseNonNegative(const char* text, double& value);
+
+// Current CLOCK_MONOTONIC time in nanoseconds
+int64_t monotonicNs();
+
+// Sleeps with clock_nanosleep(TIMER_ABSTIME) until a CLOCK_MONOTONIC deadline and busy-waits the last
+// spinNs; returns false as soon as stop is set (signals interrupt the sleep)
+bool sleepUntilNs(int64_t deadlineNs, int64_t spinNs, const std::atomic<bool>& stop);
+
+// Lateness histogram: 1 us buckets below 1 ms, 100 us buckets below 100 ms, then one overflow bucket
+class LatenessHistogram
+{
+public:
+    LatenessHistogram();
+
+    void record(int64_t latenessNs);
+    uint64_t count() const { return m_count; }
+    int64_t maxNs() const { return m_maxNs; }
+
+    // Upper edge of the bucket holding the given fraction of samples, capped by the exact maximum
+    int64_t percentileNs(double fraction) const;
+
+    // Prints "p50 .., p90 .., p99 .., p99.9 .., max .." in microseconds
+    void print(std::ostream& out) const;
+
+private:
+    static constexpr int kFineBuckets = 1000;
+    static constexpr int kCoarseBuckets = 990;
+    static constexpr int kBucketCount = kFineBuckets + kCoarseBuckets + 1;
+
+    static int bucketFor(int64_t latenessNs);
+    static int64_t bucketUpperNs(int bucket);
+
+    std::vector<uint64_t> m_buckets;
+    uint64_t m_count;
+    int64_t m_maxNs;
+};
+
+// Schedules periodic ticks of several channels on one thread using absolute CLOCK_MONOTONIC deadlines.
+// Each deadline is derived from the channel start time and its tick count, so the send cost never
+// accumulates into drift. A tick that wakes more than one period late skips the periods it missed
+// instead of bursting to catch up; skipped periods are reported as missed deadlines.
+class PacingEngine
+{
+public:
+    static constexpr double kMinRateHz = 1.0;
+    static constexpr double kMaxRateHz = 10000.0;
+
+    explicit PacingEngine(int64_t spinUs = 0, double durationSeconds = 0.0);
+
+    // Adds a channel ticking at rateHz (clamped to kMinRateHz..kMaxRateHz); returns its index
+    int addChannel(const std::string& name, double rateHz);
+
+    // Changes the rate of a channel (clamped like addChannel) from its next deadline on
+    void setRate(int channel, double rateHz);
+    double rate(int channel) const { return m_channels[channel].rateHz; }
+
+    // Deadlines skipped by all channels so far
+    uint64_t missedDeadlines() const;
+
+    // Sleeps until the earliest channel deadline and returns that channel, or -1 once the run
+    // duration has elapsed or stop() was called
+    int waitNext();
+
+    // Ends the run; safe to call from a signal handler
+    void stop() { m_stopRequested.store(true, std::memory_order_relaxed); }
+    bool stopped() const { return m_stopRequested.load(std::memory_order_relaxed); }
+
+    // Calls stop() on this engine when SIGINT or SIGTERM arrives
+    void stopOnSignals();
+
+    // Prints achieved rate, lateness percentiles and missed deadlines of every channel
+    void report(std::ostream& out) const;
+
+private:
+    struct Channel
+    {
+        std::string name;
+        double rateHz;
+        int64_t periodNs;
+        int64_t startNs;
+        int64_t nextDeadlineNs;
+        uint64_t nextTick;
+        uint64_t ticks;
+        uint64_t missed;
+        LatenessHistogram lateness;
+    };
+
+    // Records the lateness of a tick and moves the channel to its next future deadline
+    void completeTick(Channel& channel, int64_t wakeNs);
+
+    std::vector<Channel> m_channels;
+    int64_t m_spinNs;
+    int64_t m_durationNs;
+    int64_t m_runStartNs;
+    int64_t m_runEndNs;
+    std::atomic<bool> m_stopRequested;
+};
+
+#endif // PACINGENGINE_HPP
@@ -0,0 +1,101 @@
+#ifndef REPLAYENGINE_HPP
+#define REPLAYENGINE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CaptureSource.hpp"
+#include "FrameBatcher.hpp"
+#include "PacingEngine.hpp"
+
+struct ReplayOptions
+{
+    double speed = 1.0;               // Playback speed factor; 0 sends as fast as the sockets take frames
+    int64_t spinUs = 0;               // Busy-wait tail before each deadline
+    std::string canInterface = "vcan0";
+    std::string host = "127.0.0.1";
+    int udpPort = 5000;
+    int flexRayPort = 5002;
+    size_t queueFrames = 4096;        // Prefetch queue capacity, rounded up to a power of two
+};
+
+// Replays capture files onto the simulator buses with their recorded timing.
+//
+// A prefetch thread merges the sources by timestamp and fills a lock-free single-producer/single-consumer
+// queue, so file reads and JSON parsing never run on the sending thread. The sending thread waits for
+// start + timestamp / speed on CLOCK_MONOTONIC, queues every frame sharing that deadline into the per-bus
+// FrameBatcher and flushes each bus once per deadline. CAN frames go to a raw socket on canInterface,
+// UDP and FlexRay payloads to host:udpPort and host:flexRayPort, the ports the Dashboard listens on.
+class ReplayEngine
+{
+public:
+    explicit ReplayEngine(const ReplayOptions& options);
+    ~ReplayEngine();
+
+    ReplayEngine(const ReplayEngine&) = delete;
+    ReplayEngine& operator=(const ReplayEngine&) = delete;
+
+    void addSource(std::unique_ptr<CaptureSource> source);
+
+    // Opens the bus sockets; a bus that cannot be opened is reported and its frames are counted as dropped
+    void openBuses();
+
+    // Replays all sources; returns when they are exhausted or stop() was called
+    void run();
+
+    // Ends the replay; safe to call from a signal handler
+    void stop() { m_stopRequested.store(true, std::memory_order_relaxed); }
+
+    // Calls stop() on this engine when SIGINT or SIGTERM arrives
+    void stopOnSignals();
+
+    // Prints per-bus frame counts, prefetch underruns and deadline lateness
+    void report(std::ostream& out) const;
+
+private:
+    enum BusIndex { kCan, kUdp, kFlexRay, kBusCount };
+
+    struct BusOutput
+    {
+        const char* name;
+        int socket;
+        FrameBatcher batcher;
+        uint64_t unsent;
+    };
+
+    // Prefetch thread: k-way merge of the sources into the queue
+    void prefetch();
+
+    // Blocks until a frame is available; returns false once the sources are drained or on stop
+    bool pop(ReplayFrame& frame);
+
+    void queueFrame(const ReplayFrame& frame);
+    void queueOn(BusIndex bus, const void* data, size_t length);
+    void flushAll();
+
+    ReplayOptions m_options;
+    std::vector<std::unique_ptr<CaptureSource>> m_sources;
+    BusOutput m_buses[kBusCount];
+
+    std::vector<ReplayFrame> m_queue;
+    size_t m_mask;
+    alignas(64) std::atomic<uint64_t> m_head;    // Written by the prefetch thread
+    alignas(64) std::atomic<uint64_t> m_tail;    // Written by the sending thread
+    std::atomic<bool> m_prefetchDone;
+    std::atomic<bool> m_stopRequested;
+    std::thread m_prefetchThread;
+
+    uint64_t m_frames;
+    uint64_t m_deadlines;
+    uint64_t m_underruns;
+    uint64_t m_unsupported;
+    int64_t m_runStartNs;
+    int64_t m_runEndNs;
+    LatenessHistogram m_lateness;
+};
+
+#endif // REPLAYENGINE_HPP
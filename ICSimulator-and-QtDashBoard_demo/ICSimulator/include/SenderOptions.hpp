@@ -0,0 +1,55 @@
+#ifndef SENDEROPTIONS_HPP
+#define SENDEROPTIONS_HPP
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+#include "Multicast.hpp"
+#include "PacingEngine.hpp"
+#include "WireFormat.hpp"
+
+// Command line options of the speed/RPM senders, on top of the pacing options (PacingEngine.hpp):
+//   --flush-us US         batching senders: hold frames up to US microseconds, then send them in one
+//                         call per bus (default 0: send after every tick)
+//   --dbc FILE            CAN senders: also send every periodic message of this signal database at its
+//                         cycle time (default vehicle_signals.json; "none" disables)
+//   --fd                  CAN senders: use CAN FD frames; speed/RPM and the signals of classic messages
+//                         covered by FD messages of the database are packed into those FD messages
+//   --wire FORMAT         speed/RPM payload of every transport: ascii (default) or binary (WireFormat.hpp)
+//   --wire-<channel> F    payload of one transport, e.g. --wire-udp binary
+//   --io-uring            batching senders: send through io_uring (one submission for all buses per flush)
+//                         instead of sendmmsg; falls back to sendmmsg where io_uring is unavailable
+//   --host ADDR           UDP/FlexRay senders: destination address (default 127.0.0.1); a multicast group
+//                         (224.0.0.0/4) feeds every Dashboard that joined it with one frame
+//   --multicast-ttl N     TTL of multicast frames (default 1: local subnet only)
+//   --multicast-if ADDR   address of the interface multicast frames leave by (default: routing table)
+//   --waveform SHAPE      speed/RPM stimulus, ramp, triangle (default), sine, step, noise or a piecewise-linear
+//                         profile file of "seconds fraction" lines (Waveform.hpp)
+//   --seed N              seed of the noise waveform; a seed reproduces the same stimulus (default 1)
+//   --capture BASE        Sender: capture every speed/RPM frame sent to BASE.sigcap and export BASE.json on
+//                         exit (default original_sender; "none" disables)
+struct SenderOptions : PacingOptions
+{
+    int64_t flushUs = 0;
+    std::string signalDatabase = "vehicle_signals.json";
+    bool canFd = false;
+    bool ioUring = false;
+    std::string capture = "original_sender";
+    std::string waveform = "triangle";
+    uint64_t seed = 1;
+    std::string host = "127.0.0.1";
+    int multicastTtl = mcast::kDefaultTtl;
+    std::string multicastInterface;
+    wire::Format wireFormat = wire::Format::Ascii;
+    std::map<std::string, wire::Format> channelFormats;
+
+    // Payload format of a channel: its --wire-<channel> value if given, otherwise --wire
+    wire::Format wireFor(const std::string& channel) const;
+};
+
+// Parses the pacing and sender options. channels lists the pacer channels of the sender, the only names
+// --rate-<channel> and --wire-<channel> accept. Prints usage and returns false on unknown or invalid arguments.
+bool parseSenderOptions(int argc, char* argv[], const std::vector<std::string>& channels, SenderOptions& options);
+
+#endif // SENDEROPTIONS_HPP
@@ -6,6 +6,7 @@
 #include <netinet/in.h>  // Needed for struct sockaddr_in
 #include <nlohmann/json.hpp>
 #include <thread>  // Needed for std::this_thread::sleep_for    
+#include "WireFormat.hpp"
 
 class UDPSimulator
 {
@@ -16,10 +17,15 @@ public:
     bool sendCombinedData(float speed, float rpm);
     bool sendUDPData(float speed, float rpm);
 
+    // Payload of the speed/RPM packets: ASCII (default) or full binary frames
+    void setWireFormat(wire::Format format) { m_format = format; }
+
 private:
     int m_socket;
     struct sockaddr_in m_serverAddr;
     std::ofstream protocol_sender_json;
+    wire::Format m_format;
+    wire::Encoder m_encoder;
 
     void closeSocket();
    
@@ -0,0 +1,104 @@
+#ifndef URINGSENDER_HPP
+#define URINGSENDER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+#include <sys/uio.h>
+
+class FrameBatcher;
+
+// io_uring backend for FrameBatcher, shared by all buses of a sender.
+//
+// Batchers attached with FrameBatcher::useUring() stage their queued frames as io_uring requests on flush()
+// instead of calling sendmmsg; submit() then hands the requests of every bus to the kernel with one
+// io_uring_enter and waits for their completions. Bound sockets (SocketCAN) write from batcher buffers
+// registered with the ring (IORING_OP_WRITE_FIXED), so the kernel does not map them per request; unconnected
+// UDP sends the batcher's prepared msghdr (IORING_OP_SENDMSG), keeping the fire-and-forget semantics of
+// sendmmsg. Each completion is accounted to its batcher (sent or dropped), and failed completions are
+// counted here with their last error.
+//
+// Uses the raw system calls from <linux/io_uring.h>, so there is no liburing dependency. open() fails
+// where the kernel or a seccomp policy refuses io_uring; callers then keep the sendmmsg path.
+class UringSender
+{
+public:
+    explicit UringSender(unsigned entries = 256);
+    ~UringSender();
+
+    UringSender(const UringSender&) = delete;
+    UringSender& operator=(const UringSender&) = delete;
+
+    // Sets up the ring; returns false (and leaves the sender closed) if io_uring is unavailable
+    bool open();
+    bool isOpen() const { return m_fd >= 0; }
+
+    // Adds a buffer to the set registered by registerBuffers(); returns its index
+    int addBuffer(void* base, size_t length);
+
+    // Registers the buffers added so far. Without registration requests fall back to IORING_OP_WRITE.
+    bool registerBuffers();
+
+    // Stages the first count frames a batcher has queued; submits first if the submission queue is full
+    void stage(FrameBatcher& batcher, size_t count);
+
+    // Submits every staged request and waits for all completions
+    // Returns false if any request failed
+    bool submit();
+
+    size_t pending() const { return m_pending; }
+    size_t inFlight() const { return m_inFlight; }
+    uint64_t submitCalls() const { return m_submitCalls; }
+    uint64_t completions() const { return m_completions; }
+    uint64_t failedCompletions() const { return m_failed; }
+
+    // Prints system calls, requests per call and failed completions
+    void report(std::ostream& out) const;
+
+private:
+    // Enters the kernel; returns the number of requests it took, 0 if it asks to retry, -1 on a fatal error
+    int enter(unsigned toSubmit, unsigned waitFor);
+
+    // Accounts every completion in the completion queue; returns the number reaped
+    unsigned reap();
+
+    // Takes back the requests the kernel has not taken and counts them as failed
+    void dropPending();
+
+    void close();
+
+    unsigned m_entries;
+    int m_fd;
+
+    // Shared ring mappings
+    void* m_sqRing;
+    size_t m_sqRingSize;
+    void* m_cqRing;
+    size_t m_cqRingSize;
+    void* m_sqes;
+    size_t m_sqesSize;
+
+    // Pointers into the mappings
+    unsigned* m_sqHead;
+    unsigned* m_sqTail;
+    unsigned* m_sqMask;
+    unsigned* m_sqArray;
+    unsigned* m_cqHead;
+    unsigned* m_cqTail;
+    unsigned* m_cqMask;
+    void* m_cqes;
+
+    unsigned m_localTail;
+    size_t m_pending;       // Staged, not yet taken by the kernel
+    size_t m_inFlight;      // Taken by the kernel, not yet completed
+    std::vector<struct iovec> m_buffers;
+    bool m_registered;
+
+    uint64_t m_submitCalls;
+    uint64_t m_completions;
+    uint64_t m_failed;
+    int m_lastError;
+};
+
+#endif // URINGSENDER_HPP
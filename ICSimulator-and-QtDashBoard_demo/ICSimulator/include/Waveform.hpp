@@ -0,0 +1,116 @@
+#ifndef WAVEFORM_HPP
+#define WAVEFORM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Stimulus shapes of the simulated signals
+enum class Waveform : uint8_t
+{
+    Ramp,           // minimum to maximum, then jumps back
+    Triangle,       // minimum to maximum and back
+    Sine,           // raised cosine from minimum to maximum and back
+    Step,           // maximum for duty of the period, minimum for the rest
+    Noise,          // uniform pseudo-random value, held for periodTicks
+    Piecewise       // linear between the points of a profile, looped
+};
+
+// Parses ramp, triangle, sine, step or noise (piecewise profiles come from a file, see loadProfile())
+bool parseWaveform(const std::string& name, Waveform& shape);
+
+// One point of a piecewise-linear profile: time (in ticks once given to a WaveformBank) and value as a
+// fraction of the signal range, 0 at minimum and 1 at maximum
+struct WaveformPoint
+{
+    double time;
+    double value;
+};
+
+struct WaveformSpec
+{
+    Waveform shape = Waveform::Triangle;
+    double minimum = 0.0;
+    double maximum = 1.0;
+    double periodTicks = 100.0;     // Period of the shape; hold time of each Noise value
+    double phase = 0.0;             // Fraction of the period the signal is ahead by at tick 0
+    double duty = 0.5;              // Step only
+    std::vector<WaveformPoint> points;  // Piecewise only; looped over its time span
+};
+
+// Generates the values of many signals at once, each a pure function of the tick index: no accumulator
+// drifts and the same tick gives the same value whatever was generated before, so a seed reproduces the
+// exact stimulus of every run and generation can start at any tick.
+//
+// Signals are kept in struct-of-arrays groups, one per shape, and every group is computed by one
+// branch-free loop over contiguous arrays that the compiler vectorizes (SSE/AVX on x86, NEON on the
+// Jetsons); the sine uses a polynomial instead of libm, so results do not depend on the libm version.
+// Noise is a counter-based hash of (seed, signal, hold interval) and is computed per signal, as are
+// piecewise profiles.
+class WaveformBank
+{
+public:
+    explicit WaveformBank(uint64_t seed = 1);
+
+    // Adds a signal; returns its index in values()
+    int add(const WaveformSpec& spec);
+
+    size_t size() const { return m_values.size(); }
+
+    // Computes the value of every signal at tick
+    void generate(uint64_t tick);
+
+    // Values of the last generate(), in the order the signals were added
+    const double* values() const { return m_values.data(); }
+    double value(int signal) const { return m_values[signal]; }
+
+    // Computes ticks firstTick .. firstTick + ticks - 1 into out, one row of size() values per tick
+    void generateBlock(uint64_t firstTick, size_t ticks, double* out);
+
+    // Reads a profile: one "seconds fraction" pair per line, times increasing, '#' starts a comment.
+    // Times are scaled by ticksPerSecond. Returns false (and prints why) if the file is unusable.
+    static bool loadProfile(const std::string& path, double ticksPerSecond, std::vector<WaveformPoint>& points);
+
+private:
+    static constexpr size_t kGroupCount = static_cast<size_t>(Waveform::Noise) + 1;
+
+    // Signals of one periodic shape (or of Noise), struct of arrays
+    struct Group
+    {
+        std::vector<int> slots;         // Index in m_values
+        std::vector<double> minimum;
+        std::vector<double> span;
+        std::vector<double> offset;     // Phase in ticks
+        std::vector<double> invPeriod;
+        std::vector<double> duty;
+        std::vector<uint64_t> key;      // Noise stream of the signal
+        std::vector<double> result;     // Scratch of generate()
+    };
+
+    struct Profile
+    {
+        int slot;
+        double minimum;
+        double span;
+        double offset;
+        std::vector<WaveformPoint> points;
+        size_t cursor;                  // Segment of the last lookup
+    };
+
+    void generateGroup(Waveform shape, Group& group, double tick);
+    double profileValue(Profile& profile, double tick);
+
+    uint64_t m_seed;
+    Group m_groups[kGroupCount];
+    std::vector<Profile> m_profiles;
+    std::vector<double> m_values;
+};
+
+// Speed/RPM stimulus of one sender channel, signals 0 (speed) and 1 (RPM): the waveform shape between 0 and
+// the maxima, with the period of a sweep of the given steps per tick, or the profile file (in seconds) at
+// ticksPerSecond. Returns false (and prints why) if waveform is neither a shape nor a usable profile.
+bool makeSpeedRpmStimulus(const std::string& waveform, uint64_t seed, double ticksPerSecond, double maxSpeed,
+                          double maxRpm, double speedStep, double rpmStep, WaveformBank& stimulus);
+
+#endif // WAVEFORM_HPP
@@ -0,0 +1,93 @@
+#include "CanBitLength.hpp"
+#include <algorithm>
+
+namespace {
+
+constexpr uint16_t kCrc15Polynomial = 0x4599;
+constexpr int kUnstuffedTailBits = 1 + 1 + 1 + 7 + 3;   // CRC delimiter, ACK slot, ACK delimiter, EOF, IFS
+
+// Stuffable part of a frame (SOF through CRC), one bit per entry
+class BitStream
+{
+public:
+    void push(uint32_t value, int bits)
+    {
+        for (int i = bits - 1; i >= 0; --i) {
+            m_bits[m_length++] = static_cast<uint8_t>((value >> i) & 1u);
+        }
+    }
+
+    // CAN CRC-15 over everything pushed so far
+    uint16_t crc15() const
+    {
+        uint16_t crc = 0;
+        for (int i = 0; i < m_length; ++i) {
+            bool feedback = (((crc >> 14) & 1u) ^ m_bits[i]) != 0;
+            crc = static_cast<uint16_t>((crc << 1) & 0x7FFF);
+            if (feedback) {
+                crc ^= kCrc15Polynomial;
+            }
+        }
+        return crc;
+    }
+
+    // Stuff bits the transmitter inserts; a stuff bit starts the next run of equal bits
+    int stuffBits() const
+    {
+        int stuffed = 0;
+        int run = 1;
+        uint8_t last = m_bits[0];
+        for (int i = 1; i < m_length; ++i) {
+            if (m_bits[i] == last) {
+                if (++run == 5) {
+                    ++stuffed;
+                    last = static_cast<uint8_t>(!last);
+                    run = 1;
+                }
+            } else {
+                last = m_bits[i];
+                run = 1;
+            }
+        }
+        return stuffed;
+    }
+
+    int length() const { return m_length; }
+
+private:
+    uint8_t m_bits[160];
+    int m_length = 0;
+};
+
+} // namespace
+
+int canFrameBits(const struct can_frame& frame)
+{
+    int dlc = std::min<int>(frame.can_dlc, CAN_MAX_DLEN);
+    bool remote = (frame.can_id & CAN_RTR_FLAG) != 0;
+
+    BitStream bits;
+    bits.push(0, 1);                                              // SOF
+    if (frame.can_id & CAN_EFF_FLAG) {
+        uint32_t id = frame.can_id & CAN_EFF_MASK;
+        bits.push(id >> 18, 11);                                  // Base ID
+        bits.push(1, 1);                                          // SRR
+        bits.push(1, 1);                                          // IDE
+        bits.push(id & 0x3FFFF, 18);                              // ID extension
+        bits.push(remote ? 1 : 0, 1);                             // RTR
+        bits.push(0, 2);                                          // r1, r0
+    } else {
+        bits.push(frame.can_id & CAN_SFF_MASK, 11);
+        bits.push(remote ? 1 : 0, 1);                             // RTR
+        bits.push(0, 2);                                          // IDE, r0
+    }
+    bits.push(static_cast<uint32_t>(dlc), 4);
+    if (!remote) {
+        for (int i = 0; i < dlc; ++i) {
+            bits.push(frame.data[i], 8);
+        }
+    }
+    bits.push(bits.crc15(), 15);
+
+    return bits.length() + bits.stuffBits() + kUnstuffedTailBits;
+}
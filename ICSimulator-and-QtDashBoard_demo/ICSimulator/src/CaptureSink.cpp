@@ -0,0 +1,148 @@
+#include "CaptureSink.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+size_t roundUpPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+CaptureSink::CaptureSink(size_t capacity, int64_t flushIntervalMs, size_t flushThreshold)
+    : m_queue(roundUpPowerOfTwo(std::max<size_t>(capacity, 2))),
+      m_mask(m_queue.size() - 1),
+      m_flushIntervalMs(std::max<int64_t>(flushIntervalMs, 1)),
+      m_flushThreshold(std::min(std::max<size_t>(flushThreshold, 1), m_queue.size())),
+      m_head(0),
+      m_wakePending(false),
+      m_dropped(0),
+      m_tail(0),
+      m_written(0),
+      m_appends(0),
+      m_stop(false)
+{
+    memset(m_sequences, 0, sizeof(m_sequences));
+}
+
+CaptureSink::~CaptureSink()
+{
+    close();
+}
+
+bool CaptureSink::open(const std::string& path)
+{
+    close();
+    if (!m_writer.open(path, sigcap::Bus::Unknown)) {
+        perror(("Failed to open capture " + path).c_str());
+        return false;
+    }
+    m_path = path;
+    m_stop = false;
+    m_thread = std::thread(&CaptureSink::run, this);
+    return true;
+}
+
+bool CaptureSink::record(sigcap::Bus bus, uint32_t id, const void* payload, size_t length, float speed, float rpm)
+{
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    uint64_t pending = head - m_tail.load(std::memory_order_acquire);
+    if (pending > m_mask) {
+        m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    sigcap::Record& record = m_queue[head & m_mask];
+    memset(&record, 0, sizeof(record));
+    record.timestampNs = sigcap::realtimeNs();
+    record.id = id;
+    record.bus = static_cast<uint8_t>(bus);
+    record.length = static_cast<uint8_t>(std::min(length, sizeof(record.payload)));
+    if (record.length > 0) {
+        memcpy(record.payload, payload, record.length);
+    }
+    record.sequence = m_sequences[record.bus % kBusSlots]++;
+    record.speed = speed;
+    record.rpm = rpm;
+    m_head.store(head + 1, std::memory_order_release);
+
+    // Wake the writer early once the threshold is reached; a wakeup lost to the race with its wait only
+    // delays the append to the next interval
+    if (pending + 1 >= m_flushThreshold && !m_wakePending.exchange(true, std::memory_order_relaxed)) {
+        m_wake.notify_one();
+    }
+    return true;
+}
+
+void CaptureSink::close()
+{
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+    }
+    m_writer.close();
+}
+
+bool CaptureSink::exportJson(const std::string& jsonPath) const
+{
+    return !m_path.empty() && sigcap::exportJson(m_path, jsonPath);
+}
+
+void CaptureSink::report(std::ostream& out) const
+{
+    out << "Capture " << m_path << ": " << recordedCount() << " records, " << droppedCount()
+        << " dropped (queue full), " << writtenCount() << " written in " << m_appends << " appends" << std::endl;
+}
+
+void CaptureSink::run()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    bool stop = false;
+    while (!stop) {
+        m_wake.wait_for(lock, std::chrono::milliseconds(m_flushIntervalMs),
+                        [this] { return m_stop || m_wakePending.load(std::memory_order_relaxed); });
+        stop = m_stop;
+        m_wakePending.store(false, std::memory_order_relaxed);
+        lock.unlock();
+
+        if (!drain()) {
+            std::cerr << "Failed to append to capture " << m_path << std::endl;
+        }
+
+        lock.lock();
+    }
+}
+
+bool CaptureSink::drain()
+{
+    uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    uint64_t head = m_head.load(std::memory_order_acquire);
+    if (head == tail) {
+        return true;
+    }
+
+    // At most two contiguous runs: up to the end of the queue, then from its start
+    bool ok = true;
+    while (tail != head) {
+        size_t start = tail & m_mask;
+        size_t count = std::min<uint64_t>(head - tail, m_queue.size() - start);
+        ok = m_writer.append(&m_queue[start], count) && ok;
+        ++m_appends;
+        tail += count;
+        m_written.store(m_written.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+        m_tail.store(tail, std::memory_order_release);
+    }
+    return m_writer.commit() && ok;
+}
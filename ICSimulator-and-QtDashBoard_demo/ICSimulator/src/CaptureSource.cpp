@@ -0,0 +1,224 @@
+#include "CaptureSource.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <nlohmann/json.hpp>
+#include "PayloadCodec.hpp"
+
+using json = nlohmann::json;
+
+namespace {
+
+constexpr uint32_t kSpeedRpmFrameId = 0x64;
+
+bool endsWith(const std::string& text, const std::string& suffix)
+{
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Replays a .sigcap file straight from its mapping
+class SigcapSource : public CaptureSource
+{
+public:
+    bool open(const std::string& path, std::string& error)
+    {
+        if (!m_reader.open(path)) {
+            error = "not a readable sigcap file";
+            return false;
+        }
+        m_index = 0;
+        m_firstNs = m_reader.size() ? m_reader[0].timestampNs : 0;
+        m_bus = static_cast<sigcap::Bus>(m_reader.header().bus);
+        return true;
+    }
+
+    bool next(ReplayFrame& frame) override
+    {
+        while (m_index < m_reader.size()) {
+            const sigcap::Record& record = m_reader[m_index++];
+            // Sender captures log values sent inside another frame without a payload; nothing to send
+            if (record.length == 0) {
+                continue;
+            }
+            frame.timestampNs = record.timestampNs >= m_firstNs ? record.timestampNs - m_firstNs : 0;
+            frame.bus = record.bus != 0 ? static_cast<sigcap::Bus>(record.bus) : m_bus;
+            frame.id = record.id;
+            frame.length = record.length <= sizeof(frame.payload) ? record.length : sizeof(frame.payload);
+            memcpy(frame.payload, record.payload, sizeof(frame.payload));
+            if (frame.bus == sigcap::Bus::Can && frame.id == 0) {
+                frame.id = kSpeedRpmFrameId;
+            }
+            return true;
+        }
+        return false;
+    }
+
+private:
+    sigcap::Reader m_reader;
+    uint64_t m_index = 0;
+    uint64_t m_firstNs = 0;
+    sigcap::Bus m_bus = sigcap::Bus::Unknown;
+};
+
+// Streams the top-level objects of a JSON capture out of its mapping. Only one small object is parsed
+// at a time; the capture is never loaded as a whole document.
+class JsonCaptureSource : public CaptureSource
+{
+public:
+    JsonCaptureSource(sigcap::Bus bus, double rateHz) : m_bus(bus), m_periodNs(1e9 / rateHz) {}
+
+    ~JsonCaptureSource() override
+    {
+        if (m_data) {
+            munmap(const_cast<char*>(m_data), m_size);
+        }
+    }
+
+    bool open(const std::string& path, std::string& error)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            error = strerror(errno);
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) < 0) {
+            error = strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        m_size = static_cast<size_t>(st.st_size);
+        if (m_size > 0) {
+            void* base = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (base == MAP_FAILED) {
+                error = strerror(errno);
+                ::close(fd);
+                return false;
+            }
+            m_data = static_cast<const char*>(base);
+            madvise(base, m_size, MADV_SEQUENTIAL);
+        }
+        ::close(fd);
+        return true;
+    }
+
+    bool next(ReplayFrame& frame) override
+    {
+        const char* begin;
+        const char* end;
+        while (nextObject(begin, end)) {
+            json object = json::parse(begin, end, nullptr, false);
+            if (object.is_discarded() || !object.is_object()) {
+                continue;
+            }
+            bool found = false;
+            auto speed = object.find("Speed");
+            if (speed != object.end() && speed->is_number()) {
+                m_speed = speed->get<float>();
+                found = true;
+            }
+            auto rpm = object.find("RPM");
+            if (rpm != object.end() && rpm->is_number()) {
+                m_rpm = rpm->get<float>();
+                found = true;
+            }
+            if (!found) {
+                continue;
+            }
+
+            frame.timestampNs = static_cast<uint64_t>(m_records++ * m_periodNs);
+            frame.bus = m_bus;
+            frame.id = m_bus == sigcap::Bus::Udp || m_bus == sigcap::Bus::FlexRay ? 0 : kSpeedRpmFrameId;
+            frame.length = payload::kFrameSize;
+            payload::encodeSpeedRpm(m_speed, m_rpm, frame.payload);
+            return true;
+        }
+        return false;
+    }
+
+private:
+    // Finds the next top-level {...} object, skipping braces inside strings
+    bool nextObject(const char*& begin, const char*& end)
+    {
+        const char* p = m_data + m_offset;
+        const char* limit = m_data + m_size;
+        p = static_cast<const char*>(memchr(p, '{', limit - p));
+        if (!p) {
+            m_offset = m_size;
+            return false;
+        }
+        begin = p;
+        int depth = 0;
+        bool inString = false;
+        for (; p < limit; ++p) {
+            char c = *p;
+            if (inString) {
+                if (c == '\\') {
+                    ++p;
+                } else if (c == '"') {
+                    inString = false;
+                }
+            } else if (c == '"') {
+                inString = true;
+            } else if (c == '{') {
+                ++depth;
+            } else if (c == '}' && --depth == 0) {
+                end = p + 1;
+                m_offset = static_cast<size_t>(end - m_data);
+                return true;
+            }
+        }
+        m_offset = m_size;
+        return false;
+    }
+
+    sigcap::Bus m_bus;
+    double m_periodNs;
+    const char* m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_offset = 0;
+    uint64_t m_records = 0;
+    float m_speed = 0.0f;
+    float m_rpm = 0.0f;
+};
+
+} // namespace
+
+std::unique_ptr<CaptureSource> openCapture(const std::string& path, sigcap::Bus jsonBus, double untimedRateHz,
+                                           std::string& error)
+{
+    if (endsWith(path, ".sigcap")) {
+        std::unique_ptr<SigcapSource> source(new SigcapSource);
+        if (!source->open(path, error)) {
+            return nullptr;
+        }
+        return source;
+    }
+
+    if (!(untimedRateHz > 0.0)) {
+        error = "JSON captures need a positive replay rate";
+        return nullptr;
+    }
+    std::unique_ptr<JsonCaptureSource> source(new JsonCaptureSource(jsonBus, untimedRateHz));
+    if (!source->open(path, error)) {
+        return nullptr;
+    }
+    return source;
+}
+
+sigcap::Bus busFromFileName(const std::string& path)
+{
+    std::string name = path.substr(path.find_last_of('/') + 1);
+    if (name.compare(0, 4, "can_") == 0) {
+        return sigcap::Bus::Can;
+    }
+    if (name.compare(0, 4, "udp_") == 0) {
+        return sigcap::Bus::Udp;
+    }
+    if (name.compare(0, 8, "flexray_") == 0) {
+        return sigcap::Bus::FlexRay;
+    }
+    return sigcap::Bus::Unknown;
+}
@@ -0,0 +1,127 @@
+#include "DatabaseTraffic.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <set>
+
+namespace {
+
+// Signals of the FD messages, which make classic messages carrying only those signals redundant
+std::set<std::string> fdSignalNames(const signaldb::Database& database)
+{
+    std::set<std::string> names;
+    for (const signaldb::Message& message : database.messages()) {
+        if (message.fd && message.cycleMs != 0) {
+            for (const signaldb::Signal& signal : message.signalList) {
+                names.insert(signal.name);
+            }
+        }
+    }
+    return names;
+}
+
+} // namespace
+
+DatabaseTraffic::DatabaseTraffic(const signaldb::Database& database, bool canFd) : m_firstChannel(-1)
+{
+    std::fill(m_gaugeValues, m_gaugeValues + kGaugeCount, 0.0);
+    std::fill(m_gaugeSet, m_gaugeSet + kGaugeCount, false);
+    std::set<std::string> fdSignals = canFd ? fdSignalNames(database) : std::set<std::string>();
+
+    size_t maxSignals = 0;
+    for (const signaldb::Message& message : database.messages()) {
+        if (message.cycleMs == 0 || (message.fd && !canFd)) {
+            continue;
+        }
+        if (!message.fd && canFd && !message.signalList.empty()
+            && std::all_of(message.signalList.begin(), message.signalList.end(),
+                           [&fdSignals](const signaldb::Signal& signal) { return fdSignals.count(signal.name) != 0; })) {
+            continue;
+        }
+
+        Entry entry{signaldb::FramePlan(message), message.name, 1000.0 / message.cycleMs, message.fd,
+                    message.bitRateSwitch, 0, WaveformBank(), {}};
+        for (size_t i = 0; i < message.signalList.size(); ++i) {
+            const signaldb::Signal& signal = message.signalList[i];
+            WaveformSpec wave;
+            wave.shape = Waveform::Triangle;
+            wave.minimum = signal.minimum;
+            wave.maximum = signal.maximum;
+            wave.periodTicks = entry.rateHz * kSweepSeconds;
+            // Spread the phases so the signals of one message do not move in lockstep
+            wave.phase = std::fmod(0.618034 * (m_messages.size() + i), 1.0);
+            entry.waves.add(wave);
+            entry.gauge.push_back(signal.gauge);
+        }
+        maxSignals = std::max(maxSignals, message.signalList.size());
+        m_messages.push_back(std::move(entry));
+    }
+    m_values.resize(maxSignals);
+}
+
+bool DatabaseTraffic::load(const std::string& path, signaldb::Database& database)
+{
+    if (path.empty() || path == "none") {
+        return true;
+    }
+
+    std::string error;
+    if (!database.load(path, &error)) {
+        std::cerr << "Failed to load signal database " << path << ": " << error << std::endl;
+        return false;
+    }
+    std::cout << "Loaded signal database " << path << " with " << database.messages().size() << " messages" << std::endl;
+    return true;
+}
+
+void DatabaseTraffic::addChannels(PacingEngine& pacer)
+{
+    for (size_t i = 0; i < m_messages.size(); ++i) {
+        int channel = pacer.addChannel(m_messages[i].name, m_messages[i].rateHz);
+        if (i == 0) {
+            m_firstChannel = channel;
+        }
+    }
+}
+
+void DatabaseTraffic::setGaugeValue(signaldb::Gauge gauge, double value)
+{
+    m_gaugeValues[static_cast<size_t>(gauge)] = value;
+    m_gaugeSet[static_cast<size_t>(gauge)] = true;
+}
+
+bool DatabaseTraffic::carriesGauge(signaldb::Gauge gauge) const
+{
+    for (const Entry& entry : m_messages) {
+        if (std::find(entry.gauge.begin(), entry.gauge.end(), gauge) != entry.gauge.end()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DatabaseTraffic::nextFrame(int channel, struct canfd_frame& frame, bool& fd)
+{
+    if (m_firstChannel < 0 || channel < m_firstChannel || channel >= m_firstChannel + static_cast<int>(m_messages.size())) {
+        return false;
+    }
+
+    Entry& entry = m_messages[channel - m_firstChannel];
+    entry.waves.generate(entry.tick++);
+    for (size_t i = 0; i < entry.plan.fieldCount(); ++i) {
+        m_values[i] = entry.waves.value(static_cast<int>(i));
+        size_t gauge = static_cast<size_t>(entry.gauge[i]);
+        if (m_gaugeSet[gauge]) {
+            m_values[i] = m_gaugeValues[gauge];
+        }
+    }
+
+    memset(&frame, 0, sizeof(frame));
+    frame.can_id = entry.plan.id();
+    frame.len = entry.plan.length();
+    frame.flags = entry.bitRateSwitch ? CANFD_BRS : 0;
+    entry.plan.pack(m_values.data(), frame.data);
+    fd = entry.fd;
+    return true;
+}
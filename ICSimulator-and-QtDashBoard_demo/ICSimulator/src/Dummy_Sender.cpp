@@ -1,8 +1,6 @@
 #include <iostream>
 #include <cstring>
 #include <unistd.h>
-#include <thread>
-#include <chrono>
 #include <functional>
 #include <arpa/inet.h>
 #include <fcntl.h>
@@ -10,21 +8,19 @@
 #include <linux/can/raw.h>
 #include <sys/ioctl.h>
 #include <net/if.h>
-#include <fstream>
-#include <nlohmann/json.hpp>
-#include <iomanip>
-#include <sstream>
-#include <mutex>
 #include <sys/socket.h>
 #include <netinet/in.h>
-
-using json = nlohmann::json;
+#include <vector>
+#include "PayloadCodec.hpp"
+#include "PacingEngine.hpp"
+#include "SenderOptions.hpp"
+#include "CaptureSink.hpp"
 
 class UDPSimulator {
 private:
     int m_socket;
     struct sockaddr_in m_serverAddr;
-    std::mutex m_mutex;
+    CaptureSink *m_capture = nullptr;
 
 public:
     UDPSimulator(const std::string& ip, int port) : m_socket(-1) {
@@ -56,51 +52,9 @@ public:
         }
     }
 
-    void logToJson(float speed, float rpm) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        json signalEntry;
-        signalEntry["Speed"] = speed;
-        signalEntry["RPM"] = rpm;
-
-        json entries = json::array();
-        std::ifstream in_file("original_sender.json");
-        std::string file_content;
-        if (in_file.is_open()) {
-            std::stringstream buffer;
-            buffer << in_file.rdbuf();
-            file_content = buffer.str();
-            in_file.close();
-            if (!file_content.empty()) {
-                try {
-                    entries = json::parse(file_content);
-                    if (!entries.is_array()) {
-                        std::cerr << "original_sender.json is not an array. Resetting to empty array." << std::endl;
-                        entries = json::array();
-                    }
-                } catch (const json::exception &e) {
-                    std::cerr << "Failed to parse original_sender.json: " << e.what() << std::endl;
-                    std::cerr << "File content: " << file_content << std::endl;
-                    entries = json::array();
-                }
-            }
-        } else {
-            std::cerr << "Failed to open original_sender.json for reading" << std::endl;
-        }
-
-        entries.push_back(signalEntry);
-        saveJsonFile("original_sender.json", entries);
-    }
-
-    void saveJsonFile(const std::string &filename, const json &json_data) {
-        std::ofstream file(filename);
-        if (!file.is_open()) {
-            std::cerr << "Failed to save JSON file: " << filename << std::endl;
-            return;
-        }
-
-        file << json_data.dump(2);
-        file.close();
-        std::cout << "Saved JSON file: " << filename << std::endl;
+    // Sink that captures every speed/RPM frame sent (nullptr: no capture)
+    void setCapture(CaptureSink *capture) {
+        m_capture = capture;
     }
 
     bool sendUDPData(float speed, float rpm) {
@@ -112,21 +66,12 @@ public:
         speed = std::max(0.0f, speed);
         rpm = std::max(0.0f, rpm);
 
-        std::ostringstream speedStream, rpmStream;
-        speedStream << std::fixed << std::setprecision(1) << speed;
-        rpmStream << std::fixed << std::setprecision(0) << rpm;
-
-        std::string speedStr = speedStream.str();
-        std::string rpmStr = rpmStream.str();
-
-        speedStr = (speedStr.size() > 4 ? speedStr.substr(0, 4) : speedStr + std::string(4 - speedStr.size(), ' '));
-        rpmStr = (rpmStr.size() > 4 ? rpmStr.substr(0, 4) : rpmStr + std::string(4 - rpmStr.size(), ' '));
-
-        uint8_t buffer[8];
-        memcpy(buffer, speedStr.c_str(), 4);
-        memcpy(buffer + 4, rpmStr.c_str(), 4);
+        uint8_t buffer[payload::kFrameSize];
+        payload::encodeSpeedRpm(speed, rpm, buffer);
 
-        logToJson(speed, rpm);
+        if (m_capture) {
+            m_capture->record(sigcap::Bus::Udp, 0, buffer, sizeof(buffer), speed, rpm);
+        }
         std::cout << "UDP Sending: Speed=" << speed << ", RPM=" << rpm << std::endl;
 
         ssize_t sent = sendto(m_socket, buffer, sizeof(buffer), 0,
@@ -143,7 +88,6 @@ public:
 class ICSimulator {
 private:
     int m_socket;
-    std::mutex m_mutex;
 
 public:
     ICSimulator() : m_socket(socket(PF_CAN, SOCK_RAW, CAN_RAW)) {
@@ -182,53 +126,6 @@ public:
         }
     }
 
-    void logToJson(float speed, float rpm) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        json signalEntry;
-        signalEntry["Speed"] = speed;
-        signalEntry["RPM"] = rpm;
-
-        json entries = json::array();
-        std::ifstream in_file("original_sender.json");
-        std::string file_content;
-        if (in_file.is_open()) {
-            std::stringstream buffer;
-            buffer << in_file.rdbuf();
-            file_content = buffer.str();
-            in_file.close();
-            if (!file_content.empty()) {
-                try {
-                    entries = json::parse(file_content);
-                    if (!entries.is_array()) {
-                        std::cerr << "original_sender.json is not an array. Resetting to empty array." << std::endl;
-                        entries = json::array();
-                    }
-                } catch (const json::exception &e) {
-                    std::cerr << "Failed to parse original_sender.json: " << e.what() << std::endl;
-                    std::cerr << "File content: " << file_content << std::endl;
-                    entries = json::array();
-                }
-            }
-        } else {
-            std::cerr << "Failed to open original_sender.json for reading" << std::endl;
-        }
-
-        entries.push_back(signalEntry);
-        saveJsonFile("original_sender.json", entries);
-    }
-
-    void saveJsonFile(const std::string &filename, const json &json_data) {
-        std::ofstream file(filename);
-        if (!file.is_open()) {
-            std::cerr << "Failed to save JSON file: " << filename << std::endl;
-            return;
-        }
-
-        file << json_data.dump(2);
-        file.close();
-        std::cout << "Saved JSON file: " << filename << std::endl;
-    }
-
     bool sendCANData(uint32_t canId, const void *data, size_t dataSize) {
         if (m_socket < 0) {
             std::cerr << "CAN Socket is not open!" << std::endl;
@@ -252,21 +149,9 @@ public:
         speed = std::max(0.0f, speed);
         rpm = std::max(0.0f, rpm);
 
-        std::ostringstream speedStream, rpmStream;
-        speedStream << std::fixed << std::setprecision(1) << speed;
-        rpmStream << std::fixed << std::setprecision(0) << rpm;
-
-        std::string speedStr = speedStream.str();
-        std::string rpmStr = rpmStream.str();
+        uint8_t buffer[payload::kFrameSize];
+        payload::encodeSpeedRpm(speed, rpm, buffer);
 
-        speedStr = (speedStr.size() > 4 ? speedStr.substr(0, 4) : speedStr + std::string(4 - speedStr.size(), ' '));
-        rpmStr = (rpmStr.size() > 4 ? rpmStr.substr(0, 4) : rpmStr + std::string(4 - rpmStr.size(), ' '));
-
-        uint8_t buffer[8];
-        memcpy(buffer, speedStr.c_str(), 4);
-        memcpy(buffer + 4, rpmStr.c_str(), 4);
-
-        // logToJson(speed, rpm);
         std::cout << "CAN Sending: Speed=" << speed << ", RPM=" << rpm << std::endl;
 
         return sendCANData(0x64, buffer, sizeof(buffer));
@@ -277,7 +162,6 @@ class FlexRaySimulator {
 private:
     int socketFd;
     struct sockaddr_in serverAddr;
-    std::mutex m_mutex;
 
 public:
     FlexRaySimulator() : socketFd(-1) {
@@ -306,47 +190,6 @@ public:
         }
     }
 
-    void logToJson(float speed, float rpm) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        json signalEntry;
-        signalEntry["Speed"] = speed;
-        signalEntry["RPM"] = rpm;
-
-        json entries = json::array();
-        std::ifstream in_file("original_sender.json");
-        std::string file_content;
-        if (in_file.is_open()) {
-            std::stringstream buffer;
-            buffer << in_file.rdbuf();
-            file_content = buffer.str();
-            in_file.close();
-            if (!file_content.empty()) {
-                try {
-                    entries = json::parse(file_content);
-                    if (!entries.is_array()) {
-                        std::cerr << "original_sender.json is not an array. Resetting to empty array." << std::endl;
-                        entries = json::array();
-                    }
-                } catch (const json::exception &e) {
-                    std::cerr << "Failed to parse original_sender.json: " << e.what() << std::endl;
-                    entries = json::array();
-                }
-            }
-        }
-
-        entries.push_back(signalEntry);
-        saveJsonFile("original_sender.json", entries);
-    }
-
-    void saveJsonFile(const std::string &filename, const json &json_data) {
-        std::ofstream file(filename);
-        if (file.is_open()) {
-            file << json_data.dump(2);
-            file.close();
-            std::cout << "Saved JSON file: " << filename << std::endl;
-        }
-    }
-
     bool sendFlexRayData(uint32_t slotId, const void *data, size_t dataSize) {
         if (socketFd < 0) {
             std::cerr << "FlexRay UDP Socket is not open!" << std::endl;
@@ -371,32 +214,32 @@ public:
         speed = std::max(0.0f, speed);
         rpm = std::max(0.0f, rpm);
 
-        std::ostringstream speedStream, rpmStream;
-        speedStream << std::fixed << std::setprecision(1) << speed;
-        rpmStream << std::fixed << std::setprecision(0) << rpm;
-
-        std::string speedStr = speedStream.str();
-        std::string rpmStr = rpmStream.str();
-
-        speedStr = (speedStr.size() > 4 ? speedStr.substr(0, 4) : speedStr + std::string(4 - speedStr.size(), ' '));
-        rpmStr = (rpmStr.size() > 4 ? rpmStr.substr(0, 4) : rpmStr + std::string(4 - rpmStr.size(), ' '));
-
-        uint8_t buffer[8];
-        memcpy(buffer, speedStr.c_str(), 4);
-        memcpy(buffer + 4, rpmStr.c_str(), 4);
+        uint8_t buffer[payload::kFrameSize];
+        payload::encodeSpeedRpm(speed, rpm, buffer);
 
-        // logToJson(speed, rpm);
         std::cout << "FlexRay Sending: Speed=" << speed << ", RPM=" << rpm << std::endl;
 
         return sendFlexRayData(1, buffer, sizeof(buffer));
     }
 };
 
-void simulateFloatData(const std::function<void(float, float)> &sendData,
+// Triangle sweep position of one pacer channel
+struct SweepState {
+    float speed;
+    float rpm;
+    bool speedIncreasing;
+    bool rpmIncreasing;
+    size_t speedIndex;
+    size_t rpmIndex;
+};
+
+// Sends a speed/RPM triangle sweep on every channel until the pacer stops. channels[i] is called on
+// the ticks of pacer channel i, so each bus runs its own sweep at its own rate.
+void simulateFloatData(const std::vector<std::function<void(float, float)>> &channels,
                        float startSpeed, float endSpeed,
                        float startRPM, float endRPM,
                        float stepSpeed, float stepRPM,
-                       std::chrono::milliseconds delay) {
+                       PacingEngine &pacer) {
     if (startSpeed < 0 || endSpeed < 0 || startRPM < 0 || endRPM < 0 || stepSpeed <= 0 || stepRPM <= 0) {
         std::cerr << "Invalid simulation parameters (negative or zero)" << std::endl;
         return;
@@ -407,14 +250,18 @@ void simulateFloatData(const std::function<void(float, float)> &sendData,
     size_t speedCycleSteps = 2 * speedSteps - 1;
     size_t rpmCycleSteps = 2 * rpmSteps - 1;
 
-    float speed = startSpeed;
-    float rpm = startRPM;
-    bool speedIncreasing = true;
-    bool rpmIncreasing = true;
-    size_t speedIndex = 0;
-    size_t rpmIndex = 0;
+    std::vector<SweepState> sweeps(channels.size(), SweepState{startSpeed, startRPM, true, true, 0, 0});
+
+    int channel;
+    while ((channel = pacer.waitNext()) >= 0) {
+        SweepState &sweep = sweeps[channel];
+        float &speed = sweep.speed;
+        float &rpm = sweep.rpm;
+        bool &speedIncreasing = sweep.speedIncreasing;
+        bool &rpmIncreasing = sweep.rpmIncreasing;
+        size_t &speedIndex = sweep.speedIndex;
+        size_t &rpmIndex = sweep.rpmIndex;
 
-    while (true) {
         if (speedIncreasing) {
             speed = startSpeed + speedIndex * stepSpeed;
             speed = std::min(speed, endSpeed);
@@ -449,62 +296,60 @@ void simulateFloatData(const std::function<void(float, float)> &sendData,
             }
         }
 
-        sendData(speed, rpm);
-        std::this_thread::sleep_for(delay);
+        channels[channel](speed, rpm);
     }
 }
 
-int main() {
-    std::ifstream check_file("original_sender.json");
-    bool needs_init = true;
-    if (check_file.is_open()) {
-        std::stringstream buffer;
-        buffer << check_file.rdbuf();
-        std::string content = buffer.str();
-        check_file.close();
-
-        if (!content.empty()) {
-            try {
-                json temp = json::parse(content);
-                if (temp.is_array()) {
-                    needs_init = false;
-                }
-            } catch (const json::exception& e) {
-                std::cerr << "Existing original_sender.json is invalid: " << e.what() << std::endl;
-                std::cerr << "File content: " << content << std::endl;
-            }
-        }
+int main(int argc, char *argv[]) {
+    SenderOptions options;
+    if (!parseSenderOptions(argc, argv, {"udp", "can", "flexray"}, options)) {
+        return 1;
     }
 
-    if (needs_init) {
-        std::ofstream json_file("original_sender.json");
-        if (json_file.is_open()) {
-            json_file << "[]";
-            json_file.close();
-            std::cout << "Initialized original_sender.json as empty array" << std::endl;
-        } else {
-            std::cerr << "Failed to initialize original_sender.json" << std::endl;
-            return 1;
-        }
+    // UDP speed/RPM frames go to an append-only capture, written by its own thread
+    CaptureSink capture;
+    bool capturing = options.capture != "none";
+    if (capturing && !capture.open(options.capture + ".sigcap")) {
+        return 1;
     }
 
     UDPSimulator udpSimulator("127.0.0.1", 5000);
     ICSimulator icSimulator;
     FlexRaySimulator flexRaySimulator;
+    if (capturing) {
+        udpSimulator.setCapture(&capture);
+    }
 
     const float max_speed = 78.0f;
     const float max_rpm = 8000.0f;
     const float speed_step = 5.0f;
     const float rpm_step = 100.0f;
 
+    // Channel order matches the senders passed to simulateFloatData
+    PacingEngine pacer(options.spinUs, options.durationSeconds);
+    pacer.addChannel("udp", options.rateFor("udp"));
+    pacer.addChannel("can", options.rateFor("can"));
+    pacer.addChannel("flexray", options.rateFor("flexray"));
+    pacer.stopOnSignals();
+
     simulateFloatData(
-        [&udpSimulator, &icSimulator, &flexRaySimulator](float speed, float rpm) {
-            udpSimulator.sendUDPData(speed, rpm);
-            icSimulator.sendCombinedData(speed, rpm);
-            flexRaySimulator.sendCombinedData(speed, rpm);
+        {
+            [&udpSimulator](float speed, float rpm) { udpSimulator.sendUDPData(speed, rpm); },
+            [&icSimulator](float speed, float rpm) { icSimulator.sendCombinedData(speed, rpm); },
+            [&flexRaySimulator](float speed, float rpm) { flexRaySimulator.sendCombinedData(speed, rpm); },
         },
-        0.0f, max_speed, 0.0f, max_rpm, speed_step, rpm_step, std::chrono::milliseconds(100)
+        0.0f, max_speed, 0.0f, max_rpm, speed_step, rpm_step, pacer
     );
 
+    pacer.report(std::cout);
+
+    if (capturing) {
+        // The legacy JSON array is produced once, from the capture, instead of on every send
+        capture.close();
+        capture.report(std::cout);
+        if (!capture.exportJson(options.capture + ".json")) {
+            std::cerr << "Failed to export " << options.capture << ".json" << std::endl;
+        }
+    }
     return 0;
 }
\ No newline at end of file
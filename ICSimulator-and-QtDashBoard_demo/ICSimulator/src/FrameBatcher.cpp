@@ -0,0 +1,111 @@
+#include "FrameBatcher.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include "UringSender.hpp"
+
+FrameBatcher::FrameBatcher(size_t frameSize, size_t capacity)
+    : m_fd(-1),
+      m_frameSize(frameSize),
+      m_capacity(capacity > 0 ? capacity : 1),
+      m_count(0),
+      m_destinationLength(0),
+      m_buffers(m_capacity * frameSize),
+      m_iovecs(m_capacity),
+      m_messages(m_capacity),
+      m_sent(0),
+      m_dropped(0),
+      m_syscalls(0),
+      m_uring(nullptr),
+      m_uringBuffer(-1),
+      m_staged(0)
+{
+    memset(&m_destination, 0, sizeof(m_destination));
+    memset(m_messages.data(), 0, m_messages.size() * sizeof(struct mmsghdr));
+    for (size_t i = 0; i < m_capacity; ++i) {
+        m_iovecs[i].iov_base = &m_buffers[i * m_frameSize];
+        m_messages[i].msg_hdr.msg_iov = &m_iovecs[i];
+        m_messages[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+void FrameBatcher::attach(int fd, const struct sockaddr* destination, socklen_t destinationLength)
+{
+    m_fd = fd;
+    m_destinationLength = 0;
+    if (destination && destinationLength <= sizeof(m_destination)) {
+        memcpy(&m_destination, destination, destinationLength);
+        m_destinationLength = destinationLength;
+    }
+    for (struct mmsghdr& message : m_messages) {
+        message.msg_hdr.msg_name = m_destinationLength ? &m_destination : nullptr;
+        message.msg_hdr.msg_namelen = m_destinationLength;
+    }
+}
+
+void FrameBatcher::useUring(UringSender* uring)
+{
+    m_uring = uring;
+    // Only bound sockets write from registered buffers; UDP frames go out with their msghdr
+    m_uringBuffer = m_destinationLength == 0 ? uring->addBuffer(m_buffers.data(), m_buffers.size()) : -1;
+}
+
+bool FrameBatcher::queue(const void* frame, size_t length)
+{
+    bool ok = true;
+    if (m_count == m_capacity) {
+        ok = flush();
+    }
+    if (m_staged) {
+        // The kernel may still read the staged buffers
+        ok = m_uring->submit() && ok;
+    }
+    if (length > m_frameSize) {
+        std::cerr << "Frame of " << length << " bytes exceeds batch slot of " << m_frameSize << std::endl;
+        ++m_dropped;
+        return false;
+    }
+    memcpy(&m_buffers[m_count * m_frameSize], frame, length);
+    m_iovecs[m_count].iov_len = length;
+    ++m_count;
+    return ok;
+}
+
+bool FrameBatcher::flush()
+{
+    if (m_count == 0) {
+        return true;
+    }
+    if (m_fd < 0) {
+        m_dropped += m_count;
+        m_count = 0;
+        return false;
+    }
+    if (m_uring) {
+        // Sent and accounted by UringSender::submit()
+        m_uring->stage(*this, m_count);
+        m_count = 0;
+        return true;
+    }
+
+    size_t done = 0;
+    while (done < m_count) {
+        int sent = sendmmsg(m_fd, &m_messages[done], static_cast<unsigned>(m_count - done), 0);
+        ++m_syscalls;
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // Typically ENOBUFS/EAGAIN from a full CAN tx queue; later frames would fail the same way
+            std::cerr << "Failed to send " << (m_count - done) << " batched frames: " << strerror(errno) << std::endl;
+            m_dropped += m_count - done;
+            break;
+        }
+        done += static_cast<size_t>(sent);
+        m_sent += static_cast<uint64_t>(sent);
+    }
+
+    bool ok = done == m_count;
+    m_count = 0;
+    return ok;
+}
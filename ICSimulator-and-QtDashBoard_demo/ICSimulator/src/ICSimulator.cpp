@@ -5,12 +5,15 @@
 #include <unistd.h>
 #include <iostream>
 #include <functional>
-#include <chrono>
-#include <thread>
+#include "PacingEngine.hpp"
+#include "SenderOptions.hpp"
+#include "DatabaseTraffic.hpp"
+#include "PayloadCodec.hpp"
+#include "Waveform.hpp"
 using json = nlohmann::json;
 
 // Constructor
-ICSimulator::ICSimulator() : m_socket(socket(PF_CAN, SOCK_RAW, CAN_RAW))
+ICSimulator::ICSimulator() : m_socket(socket(PF_CAN, SOCK_RAW, CAN_RAW)), m_format(wire::Format::Ascii)
 {
     if (m_socket < 0)
     {
@@ -66,18 +69,24 @@ void ICSimulator::closeSocket()
 // Send CAN data
 bool ICSimulator::sendCANData(uint32_t canId, const void* data, size_t dataSize)
 {
-    if (m_socket < 0)
-    {
-        std::cerr << "Socket is not open!\n";
-        return false;
-    }
-
     struct can_frame frame = {};
     frame.can_id = canId;
     frame.can_dlc = 8;
     memset(frame.data, 0, sizeof(frame.data));
     memcpy(frame.data, data, dataSize);
 
+    return sendFrame(frame);
+}
+
+// Send a complete frame, e.g. one packed from the signal database
+bool ICSimulator::sendFrame(const struct can_frame& frame)
+{
+    if (m_socket < 0)
+    {
+        std::cerr << "Socket is not open!\n";
+        return false;
+    }
+
     if (write(m_socket, &frame, sizeof(frame)) != sizeof(frame))
     {
         perror("Failed to send CAN message");
@@ -86,6 +95,35 @@ bool ICSimulator::sendCANData(uint32_t canId, const void* data, size_t dataSize)
     return true;
 }
 
+// Enable CAN FD frames on the socket
+bool ICSimulator::enableFd()
+{
+    int enable = 1;
+    if (m_socket < 0 || setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable)) < 0)
+    {
+        perror("Failed to enable CAN FD frames");
+        return false;
+    }
+    return true;
+}
+
+// Send a CAN FD frame of up to 64 bytes
+bool ICSimulator::sendFdFrame(const struct canfd_frame& frame)
+{
+    if (m_socket < 0)
+    {
+        std::cerr << "Socket is not open!\n";
+        return false;
+    }
+
+    if (write(m_socket, &frame, CANFD_MTU) != CANFD_MTU)
+    {
+        perror("Failed to send CAN FD message");
+        return false;
+    }
+    return true;
+}
+
 // Log signal to JSON
 template<typename T>
 void ICSimulator::logSignalToJson(const std::string& signalName, const T& value)
@@ -111,55 +149,65 @@ bool ICSimulator::sendCombinedData(float speed, float rpm)
     logSignalToJson("Speed", speed);
     logSignalToJson("RPM", rpm);
 
-    uint8_t buffer[8];
-    memcpy(buffer, &speed, sizeof(float));
-    memcpy(buffer + 4, &rpm, sizeof(float));
+    uint8_t buffer[payload::kFrameSize];
+    if (m_format == wire::Format::Binary)
+    {
+        m_encoder.encodeCompact(speed, rpm, buffer);
+    }
+    else
+    {
+        payload::encodeSpeedRpm(speed, rpm, buffer);
+    }
 
     return sendCANData(0x64, buffer, sizeof(buffer));
 }
 
-// Simulates float data from start to end, with optional reverse direction
-void simulateFloatData(const std::function<void(float, float)>& sendData, 
-                     float startSpeed, float endSpeed, 
-                     float startRPM, float endRPM, 
-                     float stepSpeed, float stepRPM, 
-                     std::chrono::milliseconds delay, 
-                     bool reverse = false)
+// Waits for the next tick of channel, handing the ticks of other pacer channels to otherTick.
+// Returns false once the pacer has stopped.
+bool waitForChannel(PacingEngine& pacer, int channel, const std::function<void(int)>& otherTick)
 {
-    if (startSpeed < 0 || endSpeed < 0 || startRPM < 0 || endRPM < 0 || stepSpeed <= 0 || stepRPM <= 0)
+    int next;
+    while ((next = pacer.waitNext()) != channel)
     {
-        std::cerr << "Invalid simulation parameters (negative or zero)\n";
-        return;
-    }
-
-    if (!reverse)
-    {
-        // Forward: start to end
-        for (float speed = startSpeed, rpm = startRPM; 
-             speed <= endSpeed && rpm <= endRPM; 
-             speed += stepSpeed, rpm += stepRPM)
+        if (next < 0)
         {
-            sendData(std::min(speed, endSpeed), std::min(rpm, endRPM));
-            std::this_thread::sleep_for(delay);
+            return false;
         }
+        otherTick(next);
     }
-    else
+    return true;
+}
+
+// Sends the speed/RPM stimulus (signals 0 and 1 of stimulus) on the ticks of pacer channel 0, one tick of the
+// stimulus per pacer tick, until the pacer stops; ticks of the other channels go to otherTick.
+void simulateFloatData(const std::function<void(float, float)>& sendData,
+                       WaveformBank& stimulus,
+                       PacingEngine& pacer,
+                       const std::function<void(int)>& otherTick)
+{
+    for (uint64_t tick = 0; waitForChannel(pacer, 0, otherTick); ++tick)
     {
-        // Reverse: end to start
-        for (float speed = endSpeed, rpm = endRPM; 
-             speed >= startSpeed && rpm >= startRPM; 
-             speed -= stepSpeed, rpm -= stepRPM)
-        {
-            sendData(std::max(startSpeed, speed), std::max(startRPM, rpm));
-            std::this_thread::sleep_for(delay);
-        }
+        stimulus.generate(tick);
+        sendData(static_cast<float>(stimulus.value(0)), static_cast<float>(stimulus.value(1)));
     }
 }
 
 // Main: Runs simulation loops for combined signals
-int main()
+int main(int argc, char* argv[])
 {
+    SenderOptions options;
+    if (!parseSenderOptions(argc, argv, {"can"}, options))
+    {
+        return 1;
+    }
+
     ICSimulator icSimulator;
+    icSimulator.setWireFormat(options.wireFor("can"));
+    if (options.canFd && !icSimulator.enableFd())
+    {
+        std::cerr << "Continuing with classic CAN frames\n";
+        options.canFd = false;
+    }
 
     // Calculate proper RPM step to reach 2223 when speed reaches 73
     const float max_speed = 78.0f;
@@ -167,50 +215,52 @@ int main()
     const float speed_step = 5.0f;
     const float rpm_step = (max_rpm / (max_speed / speed_step));
 
-    while (true) {
-        // Simulate speed (0 to 73 km/h) and RPM (0 to 2223) with synchronized steps
-        simulateFloatData(
-            [&icSimulator](float speed, float rpm) { 
-                icSimulator.sendCombinedData(speed, rpm); 
-            },
-            0.0f, max_speed, 0.0f, max_rpm, speed_step, rpm_step, std::chrono::milliseconds(100)
-        );
-        simulateFloatData(
-            [&icSimulator](float speed, float rpm) { 
-                icSimulator.sendCombinedData(speed, rpm); 
-            },
-            0.0f, max_speed, 0.0f, max_rpm, speed_step, rpm_step, std::chrono::milliseconds(100), true
-        );
-
-        // Below implementations can be used in future, hence commented
-        // // Simulate fuel (0 to 1, step 0.05)
-        // simulateFloatData(
-        //     [&icSimulator](float fuel, float /*unused*/) { 
-        //         icSimulator.sendCombinedData(0.0f, 0.0f); 
-        //     },
-        //     0.0f, 1.0f, 0.0f, 0.0f, 0.05f, 0.0f, std::chrono::milliseconds(100)
-        // );
-        // simulateFloatData(
-        //     [&icSimulator](float fuel, float /*unused*/) { 
-        //         icSimulator.sendCombinedData(0.0f, 0.0f); 
-        //     },
-        //     0.0f, 1.0f, 0.0f, 0.0f, 0.05f, 0.0f, std::chrono::milliseconds(100), true
-        // );
-
-        // // Simulate temperature (-40 to 125°C, step 5)
-        // simulateFloatData(
-        //     [&icSimulator](float temp, float /*unused*/) { 
-        //         icSimulator.sendCombinedData(0.0f, 0.0f); 
-        //     },
-        //     -40.0f, 125.0f, 0.0f, 0.0f, 5.0f, 0.0f, std::chrono::milliseconds(100)
-        // );
-        // simulateFloatData(
-        //     [&icSimulator](float temp, float /*unused*/) { 
-        //         icSimulator.sendCombinedData(0.0f, 0.0f); 
-        //     },
-        //     -40.0f, 125.0f, 0.0f, 0.0f, 5.0f, 0.0f, std::chrono::milliseconds(100), true
-        // );
+    PacingEngine pacer(options.spinUs, options.durationSeconds);
+    pacer.addChannel("can", options.rateFor("can"));
+
+    // Every periodic message of the signal database runs as its own channel after the sweep channel
+    signaldb::Database signalDatabase;
+    if (!DatabaseTraffic::load(options.signalDatabase, signalDatabase))
+    {
+        std::cerr << "Continuing without signal database traffic\n";
+    }
+    DatabaseTraffic databaseTraffic(signalDatabase, options.canFd);
+    databaseTraffic.addChannels(pacer);
+    auto sendDatabaseFrame = [&icSimulator, &databaseTraffic](int channel) {
+        struct canfd_frame frame;
+        bool fd = false;
+        if (databaseTraffic.nextFrame(channel, frame, fd))
+        {
+            // struct can_frame is layout-compatible with the head of struct canfd_frame
+            fd ? icSimulator.sendFdFrame(frame) : icSimulator.sendFrame(reinterpret_cast<const struct can_frame&>(frame));
+        }
+    };
+    pacer.stopOnSignals();
+
+    // In FD mode speed and RPM travel in the FD message of the database instead of their own frame
+    bool packSpeedRpm = options.canFd && databaseTraffic.carriesGauge(signaldb::Gauge::Speed)
+                        && databaseTraffic.carriesGauge(signaldb::Gauge::Rpm);
+    auto sendSpeedRpm = [&icSimulator, &databaseTraffic, packSpeedRpm](float speed, float rpm) {
+        if (packSpeedRpm)
+        {
+            databaseTraffic.setGaugeValue(signaldb::Gauge::Speed, speed);
+            databaseTraffic.setGaugeValue(signaldb::Gauge::Rpm, rpm);
+        }
+        else
+        {
+            icSimulator.sendCombinedData(speed, rpm);
+        }
+    };
+
+    // A triangle of the step sizes is the classic sweep
+    WaveformBank stimulus;
+    if (!makeSpeedRpmStimulus(options.waveform, options.seed, options.rateFor("can"), max_speed, max_rpm,
+                              speed_step, rpm_step, stimulus))
+    {
+        return 1;
     }
+    simulateFloatData(sendSpeedRpm, stimulus, pacer, sendDatabaseFrame);
 
+    pacer.report(std::cout);
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,473 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <memory>
+#include <net/if.h>
+#include <pthread.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "CanBitLength.hpp"
+#include "FrameBatcher.hpp"
+#include "PacingEngine.hpp"
+
+namespace {
+
+constexpr int64_t kNsPerSecond = 1000000000;
+constexpr uint32_t kFirstId = 0x100;
+
+// Cycle times handed out to the virtual ECUs in turn, like the mix of a body/powertrain bus
+constexpr double kCycleMs[] = {10.0, 20.0, 50.0, 100.0, 100.0, 200.0};
+
+// Correction applied per control step is limited to this factor either way
+constexpr double kMaxCorrection = 2.0;
+
+std::atomic<bool> g_stopRequested(false);
+
+void requestStop(int)
+{
+    g_stopRequested.store(true, std::memory_order_relaxed);
+}
+
+struct LoadOptions
+{
+    int ecus = 8;
+    int idsPerEcu = 4;
+    int threads = 0;                 // 0: one per ECU up to the number of cores
+    int dlc = 8;
+    double bitrate = 500000.0;
+    double utilisation = 40.0;       // Target percentage of bitrate
+    double durationSeconds = 0.0;
+    int64_t spinUs = 0;
+    std::string interfaceName = "vcan0";
+    bool dryRun = false;             // Pace and count frames without a socket
+};
+
+void printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --ecus N            virtual ECUs (default 8)\n"
+              << "  --ids-per-ecu N     CAN IDs each ECU sends per cycle (default 4)\n"
+              << "  --threads N         worker threads (default: one per ECU, at most one per core)\n"
+              << "  --dlc N             data bytes per frame, 0 to 8 (default 8)\n"
+              << "  --bitrate BPS       nominal bus bitrate (default 500000)\n"
+              << "  --utilisation PCT   target bus utilisation in percent (default 40)\n"
+              << "  --duration S        stop after S seconds (default: until Ctrl+C)\n"
+              << "  --spin-us US        busy-wait the last US microseconds before each deadline (default 0)\n"
+              << "  --interface IF      CAN interface (default vcan0)\n"
+              << "  --dry-run           pace and count frames without sending them\n";
+}
+
+bool parseNumber(const char* text, double& value)
+{
+    char* end = nullptr;
+    errno = 0;
+    value = strtod(text, &end);
+    return errno == 0 && end != text && *end == '\0' && value >= 0.0;
+}
+
+bool parseLoadOptions(int argc, char* argv[], LoadOptions& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--dry-run") {
+            options.dryRun = true;
+            continue;
+        }
+        if (arg == "--help" || i + 1 >= argc || arg.compare(0, 2, "--") != 0) {
+            printUsage(argv[0]);
+            return false;
+        }
+
+        std::string value = argv[++i];
+        double number = 0.0;
+        if (arg == "--interface") {
+            options.interfaceName = value;
+        } else if (!parseNumber(value.c_str(), number)) {
+            std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+            return false;
+        } else if (arg == "--ecus") {
+            options.ecus = static_cast<int>(number);
+        } else if (arg == "--ids-per-ecu") {
+            options.idsPerEcu = static_cast<int>(number);
+        } else if (arg == "--threads") {
+            options.threads = static_cast<int>(number);
+        } else if (arg == "--dlc") {
+            options.dlc = static_cast<int>(number);
+        } else if (arg == "--bitrate") {
+            options.bitrate = number;
+        } else if (arg == "--utilisation") {
+            options.utilisation = number;
+        } else if (arg == "--duration") {
+            options.durationSeconds = number;
+        } else if (arg == "--spin-us") {
+            options.spinUs = static_cast<int64_t>(number);
+        } else {
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+
+    if (options.ecus < 1 || options.idsPerEcu < 1 || options.dlc > CAN_MAX_DLEN || options.bitrate <= 0.0
+        || options.utilisation <= 0.0 || options.utilisation > 100.0) {
+        std::cerr << "Need at least one ECU and ID, a DLC of 0 to 8, a positive bitrate and 0 < utilisation <= 100"
+                  << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int openCanSocket(const std::string& interfaceName)
+{
+    int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd < 0) {
+        perror("Failed to create CAN socket");
+        return -1;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+
+    // Not interested in the other workers' frames
+    int loopback = 0;
+    setsockopt(fd, SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS, &loopback, sizeof(loopback));
+    setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FILTER, nullptr, 0);
+
+    struct ifreq ifr = {};
+    strncpy(ifr.ifr_name, interfaceName.c_str(), IFNAMSIZ - 1);
+    if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0) {
+        perror("Failed to retrieve CAN interface index");
+        close(fd);
+        return -1;
+    }
+
+    struct sockaddr_can addr = {};
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        perror("Failed to bind CAN socket");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// One simulated control unit: a fixed ID set sent together once per cycle
+struct VirtualEcu
+{
+    std::string name;
+    std::vector<uint32_t> ids;
+    double cycleMs;
+    double rateHz;          // Scaled rate that meets the utilisation target
+    uint32_t noise;         // xorshift state for the payload bytes
+};
+
+// Runs a share of the ECUs on its own thread, socket and pacer. Once a second it compares the bits it
+// sent with its share of the target and rescales all its ECU rates by the ratio, which absorbs the
+// payload-dependent stuff bits and any deadlines the thread could not keep.
+class LoadWorker
+{
+public:
+    LoadWorker(std::vector<VirtualEcu> ecus, double targetBitsPerSecond, const LoadOptions& options)
+        : m_ecus(std::move(ecus)),
+          m_targetBitsPerSecond(targetBitsPerSecond),
+          m_dlc(options.dlc),
+          m_socket(-1),
+          m_dryRun(options.dryRun),
+          m_batcher(sizeof(struct can_frame)),
+          m_pacer(options.spinUs),
+          m_frames(0),
+          m_bits(0),
+          m_dropped(0),
+          m_missed(0)
+    {
+        for (const VirtualEcu& ecu : m_ecus) {
+            m_pacer.addChannel(ecu.name, ecu.rateHz);
+        }
+        m_tickBits.reserve(16);
+    }
+
+    ~LoadWorker()
+    {
+        if (m_socket >= 0) {
+            close(m_socket);
+        }
+    }
+
+    bool open(const std::string& interfaceName)
+    {
+        if (m_dryRun) {
+            return true;
+        }
+        m_socket = openCanSocket(interfaceName);
+        m_batcher.attach(m_socket);
+        return m_socket >= 0;
+    }
+
+    void run()
+    {
+        int64_t windowStartNs = 0;
+        uint64_t windowBits = 0;
+
+        int channel;
+        while ((channel = m_pacer.waitNext()) >= 0) {
+            windowBits += sendCycle(m_ecus[channel]);
+
+            int64_t now = monotonicNs();
+            if (windowStartNs == 0) {
+                windowStartNs = now;
+            } else if (now - windowStartNs >= kNsPerSecond) {
+                double achieved = windowBits * static_cast<double>(kNsPerSecond) / (now - windowStartNs);
+                if (achieved > 0.0) {
+                    double correction = std::min(std::max(m_targetBitsPerSecond / achieved, 1.0 / kMaxCorrection),
+                                                 kMaxCorrection);
+                    for (size_t i = 0; i < m_ecus.size(); ++i) {
+                        m_pacer.setRate(static_cast<int>(i), m_pacer.rate(static_cast<int>(i)) * correction);
+                    }
+                }
+                windowStartNs = now;
+                windowBits = 0;
+            }
+            m_missed.store(m_pacer.missedDeadlines(), std::memory_order_relaxed);
+        }
+    }
+
+    void stop() { m_pacer.stop(); }
+
+    size_t ecuCount() const { return m_ecus.size(); }
+    double targetBitsPerSecond() const { return m_targetBitsPerSecond; }
+    uint64_t frames() const { return m_frames.load(std::memory_order_relaxed); }
+    uint64_t bits() const { return m_bits.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return m_dropped.load(std::memory_order_relaxed); }
+    uint64_t missed() const { return m_missed.load(std::memory_order_relaxed); }
+
+private:
+    // Sends one frame per ID of the ECU with a single sendmmsg; returns the wire bits that went out
+    uint64_t sendCycle(VirtualEcu& ecu)
+    {
+        m_tickBits.clear();
+        for (uint32_t id : ecu.ids) {
+            struct can_frame frame = {};
+            frame.can_id = id;
+            frame.can_dlc = static_cast<uint8_t>(m_dlc);
+            for (int i = 0; i < m_dlc; ++i) {
+                ecu.noise ^= ecu.noise << 13;
+                ecu.noise ^= ecu.noise >> 17;
+                ecu.noise ^= ecu.noise << 5;
+                frame.data[i] = static_cast<uint8_t>(ecu.noise);
+            }
+            m_tickBits.push_back(canFrameBits(frame));
+            if (!m_dryRun) {
+                m_batcher.queue(&frame, sizeof(frame));
+            }
+        }
+
+        // sendmmsg sends a prefix of the batch; the frames after a failure are dropped
+        size_t sent = m_tickBits.size();
+        if (!m_dryRun) {
+            uint64_t before = m_batcher.sentFrames();
+            m_batcher.flush();
+            sent = static_cast<size_t>(m_batcher.sentFrames() - before);
+        }
+        uint64_t bits = 0;
+        for (size_t i = 0; i < sent; ++i) {
+            bits += m_tickBits[i];
+        }
+
+        m_frames.store(m_frames.load(std::memory_order_relaxed) + sent, std::memory_order_relaxed);
+        m_bits.store(m_bits.load(std::memory_order_relaxed) + bits, std::memory_order_relaxed);
+        m_dropped.store(m_dropped.load(std::memory_order_relaxed) + (m_tickBits.size() - sent),
+                        std::memory_order_relaxed);
+        return bits;
+    }
+
+    std::vector<VirtualEcu> m_ecus;
+    double m_targetBitsPerSecond;
+    int m_dlc;
+    int m_socket;
+    bool m_dryRun;
+    FrameBatcher m_batcher;
+    PacingEngine m_pacer;
+    std::vector<int> m_tickBits;
+
+    // Written by the worker thread only, read by the reporting thread
+    std::atomic<uint64_t> m_frames;
+    std::atomic<uint64_t> m_bits;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_missed;
+};
+
+// Builds the ECUs and scales their cycle rates so that, with the stuffed length of their first frames,
+// the bus carries the target utilisation
+std::vector<VirtualEcu> planEcus(const LoadOptions& options, double targetBitsPerSecond)
+{
+    std::vector<VirtualEcu> ecus;
+    double nominalBitsPerSecond = 0.0;
+    uint32_t nextId = kFirstId;
+    for (int e = 0; e < options.ecus; ++e) {
+        VirtualEcu ecu;
+        ecu.name = "ecu" + std::to_string(e);
+        ecu.cycleMs = kCycleMs[e % (sizeof(kCycleMs) / sizeof(kCycleMs[0]))];
+        ecu.noise = 0x9E3779B9u * (e + 1);
+
+        double cycleBits = 0.0;
+        for (int k = 0; k < options.idsPerEcu; ++k, ++nextId) {
+            // Standard IDs first, extended ones once the 11-bit range is used up
+            uint32_t id = nextId <= CAN_SFF_MASK ? nextId : (nextId | CAN_EFF_FLAG);
+            ecu.ids.push_back(id);
+
+            struct can_frame sample = {};
+            sample.can_id = id;
+            sample.can_dlc = static_cast<uint8_t>(options.dlc);
+            memset(sample.data, 0x55, sizeof(sample.data));
+            cycleBits += canFrameBits(sample);
+        }
+        ecu.rateHz = 1000.0 / ecu.cycleMs;
+        nominalBitsPerSecond += ecu.rateHz * cycleBits;
+        ecus.push_back(ecu);
+    }
+
+    double scale = targetBitsPerSecond / nominalBitsPerSecond;
+    for (VirtualEcu& ecu : ecus) {
+        ecu.rateHz *= scale;
+        if (ecu.rateHz > PacingEngine::kMaxRateHz) {
+            std::cerr << ecu.name << " would need " << ecu.rateHz << " Hz; raise --ecus or --ids-per-ecu to reach the target"
+                      << std::endl;
+        }
+    }
+    return ecus;
+}
+
+void printProgress(double seconds, uint64_t bits, uint64_t frames, uint64_t dropped, const LoadOptions& options)
+{
+    std::cout << std::fixed << std::setprecision(1) << "  " << seconds << " s: "
+              << busUtilisation(bits / seconds, options.bitrate) << " % of " << options.bitrate / 1000.0
+              << " kbit/s, " << std::setprecision(0) << frames / seconds << " frames/s, " << dropped << " dropped"
+              << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    LoadOptions options;
+    if (!parseLoadOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    double targetBitsPerSecond = options.bitrate * options.utilisation / 100.0;
+    std::vector<VirtualEcu> ecus = planEcus(options, targetBitsPerSecond);
+
+    int threads = options.threads > 0 ? options.threads
+                                      : static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    threads = std::min(threads, options.ecus);
+
+    // Deal the ECUs out round-robin; each worker's target is the share its ECUs were planned for
+    std::vector<std::vector<VirtualEcu>> shares(threads);
+    std::vector<double> shareTargets(threads, 0.0);
+    double plannedRate = 0.0;
+    for (const VirtualEcu& ecu : ecus) {
+        plannedRate += ecu.rateHz * ecu.ids.size();
+    }
+    for (size_t e = 0; e < ecus.size(); ++e) {
+        shares[e % threads].push_back(ecus[e]);
+        shareTargets[e % threads] += targetBitsPerSecond * ecus[e].rateHz * ecus[e].ids.size() / plannedRate;
+    }
+
+    std::vector<std::unique_ptr<LoadWorker>> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back(new LoadWorker(std::move(shares[t]), shareTargets[t], options));
+        if (!workers.back()->open(options.interfaceName)) {
+            return 1;
+        }
+    }
+
+    std::cout << "Generating " << options.utilisation << " % of " << options.bitrate / 1000.0 << " kbit/s with "
+              << options.ecus << " ECUs x " << options.idsPerEcu << " IDs on " << threads << " threads"
+              << (options.dryRun ? " (dry run)" : "") << std::endl;
+
+    // Workers inherit a mask without SIGINT/SIGTERM, so the signals interrupt the reporting loop below
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    std::vector<std::thread> threadsRunning;
+    for (std::unique_ptr<LoadWorker>& worker : workers) {
+        threadsRunning.emplace_back(&LoadWorker::run, worker.get());
+    }
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    pthread_sigmask(SIG_UNBLOCK, &stopSignals, nullptr);
+
+    int64_t startNs = monotonicNs();
+    int64_t endNs = options.durationSeconds > 0.0 ? startNs + static_cast<int64_t>(options.durationSeconds * kNsPerSecond) : 0;
+    uint64_t lastBits = 0;
+    uint64_t lastFrames = 0;
+    for (int64_t reportNs = startNs + kNsPerSecond;; reportNs += kNsPerSecond) {
+        int64_t wakeNs = endNs != 0 ? std::min(reportNs, endNs) : reportNs;
+        if (!sleepUntilNs(wakeNs, 0, g_stopRequested) || wakeNs == endNs) {
+            break;
+        }
+
+        uint64_t bits = 0;
+        uint64_t frames = 0;
+        uint64_t dropped = 0;
+        for (const std::unique_ptr<LoadWorker>& worker : workers) {
+            bits += worker->bits();
+            frames += worker->frames();
+            dropped += worker->dropped();
+        }
+        printProgress(1.0, bits - lastBits, frames - lastFrames, dropped, options);
+        lastBits = bits;
+        lastFrames = frames;
+    }
+
+    for (std::unique_ptr<LoadWorker>& worker : workers) {
+        worker->stop();
+    }
+    for (std::thread& thread : threadsRunning) {
+        thread.join();
+    }
+
+    double seconds = static_cast<double>(monotonicNs() - startNs) / kNsPerSecond;
+    uint64_t bits = 0;
+    uint64_t frames = 0;
+    uint64_t dropped = 0;
+    uint64_t missed = 0;
+    for (const std::unique_ptr<LoadWorker>& worker : workers) {
+        bits += worker->bits();
+        frames += worker->frames();
+        dropped += worker->dropped();
+        missed += worker->missed();
+    }
+
+    std::cout << "Load report: " << std::fixed << std::setprecision(3) << seconds << " s, target "
+              << std::setprecision(1) << options.utilisation << " %, " << frames << " frames, " << missed
+              << " missed deadlines" << std::endl;
+    printProgress(seconds, bits, frames, dropped, options);
+    for (size_t t = 0; t < workers.size(); ++t) {
+        const LoadWorker& worker = *workers[t];
+        std::cout << "  worker " << t << ": " << worker.ecuCount() << " ECUs, " << std::setprecision(1)
+                  << busUtilisation(worker.bits() / seconds, options.bitrate) << " % (target "
+                  << busUtilisation(worker.targetBitsPerSecond(), options.bitrate) << " %), " << std::setprecision(0)
+                  << worker.frames() / seconds << " frames/s, " << worker.dropped() << " dropped" << std::endl;
+    }
+    return 0;
+}
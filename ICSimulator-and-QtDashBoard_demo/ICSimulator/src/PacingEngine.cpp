@@ -0,0 +1,312 @@
+#include "PacingEngine.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+namespace {
+
+constexpr int64_t kNsPerUs = 1000;
+constexpr int64_t kNsPerSecond = 1000000000;
+constexpr int64_t kCoarseBucketNs = 100 * kNsPerUs;
+
+// Engine stopped by SIGINT/SIGTERM
+PacingEngine* g_signalEngine = nullptr;
+
+void stopSignalEngine(int)
+{
+    if (g_signalEngine) {
+        g_signalEngine->stop();
+    }
+}
+
+} // namespace
+
+int64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * kNsPerSecond + ts.tv_nsec;
+}
+
+bool sleepUntilNs(int64_t deadlineNs, int64_t spinNs, const std::atomic<bool>& stop)
+{
+    int64_t wakeNs = deadlineNs - spinNs;
+    struct timespec wake;
+    wake.tv_sec = wakeNs / kNsPerSecond;
+    wake.tv_nsec = wakeNs % kNsPerSecond;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, nullptr) == EINTR) {
+        if (stop.load(std::memory_order_relaxed)) {
+            return false;
+        }
+    }
+
+    // Busy-wait the tail to avoid the scheduler wakeup latency
+    while (spinNs > 0 && monotonicNs() < deadlineNs) {
+        if (stop.load(std::memory_order_relaxed)) {
+            return false;
+        }
+    }
+    return !stop.load(std::memory_order_relaxed);
+}
+
+LatenessHistogram::LatenessHistogram() : m_buckets(kBucketCount, 0), m_count(0), m_maxNs(0)
+{
+}
+
+void LatenessHistogram::record(int64_t latenessNs)
+{
+    latenessNs = std::max<int64_t>(latenessNs, 0);
+    ++m_buckets[bucketFor(latenessNs)];
+    ++m_count;
+    m_maxNs = std::max(m_maxNs, latenessNs);
+}
+
+int64_t LatenessHistogram::percentileNs(double fraction) const
+{
+    if (m_count == 0) {
+        return 0;
+    }
+    uint64_t rank = static_cast<uint64_t>(fraction * m_count);
+    uint64_t seen = 0;
+    for (int bucket = 0; bucket < kBucketCount; ++bucket) {
+        seen += m_buckets[bucket];
+        if (seen > rank) {
+            return std::min(bucketUpperNs(bucket), m_maxNs);
+        }
+    }
+    return m_maxNs;
+}
+
+void LatenessHistogram::print(std::ostream& out) const
+{
+    out << "p50 " << percentileNs(0.50) / 1000.0 << ", p90 " << percentileNs(0.90) / 1000.0
+        << ", p99 " << percentileNs(0.99) / 1000.0 << ", p99.9 " << percentileNs(0.999) / 1000.0
+        << ", max " << m_maxNs / 1000.0;
+}
+
+int LatenessHistogram::bucketFor(int64_t latenessNs)
+{
+    int64_t us = latenessNs / kNsPerUs;
+    if (us < kFineBuckets) {
+        return static_cast<int>(us);
+    }
+    int64_t coarse = (latenessNs - kFineBuckets * kNsPerUs) / kCoarseBucketNs;
+    return coarse < kCoarseBuckets ? kFineBuckets + static_cast<int>(coarse) : kBucketCount - 1;
+}
+
+int64_t LatenessHistogram::bucketUpperNs(int bucket)
+{
+    if (bucket < kFineBuckets) {
+        return (bucket + 1) * kNsPerUs;
+    }
+    return kFineBuckets * kNsPerUs + (bucket - kFineBuckets + 1) * kCoarseBucketNs;
+}
+
+double PacingOptions::rateFor(const std::string& channel) const
+{
+    auto it = channelRates.find(channel);
+    return it != channelRates.end() ? it->second : rateHz;
+}
+
+bool parseNonNegative(const char* text, double& value)
+{
+    char* end = nullptr;
+    errno = 0;
+    value = strtod(text, &end);
+    return errno == 0 && end != text && *end == '\0' && value >= 0.0;
+}
+
+OptionStatus parsePacingOption(const std::string& name, const char* value, const std::vector<std::string>& channels,
+                               PacingOptions& options)
+{
+    bool channelRate = name.compare(0, 7, "--rate-") == 0;
+    if (name != "--rate" && !channelRate && name != "--duration" && name != "--spin-us") {
+        return OptionStatus::Unknown;
+    }
+    if (channelRate && std::find(channels.begin(), channels.end(), name.substr(7)) == channels.end()) {
+        std::cerr << "Unknown channel in " << name << std::endl;
+        return OptionStatus::Invalid;
+    }
+
+    double number = 0.0;
+    if (!parseNonNegative(value, number)) {
+        std::cerr << "Invalid value for " << name << ": " << value << std::endl;
+        return OptionStatus::Invalid;
+    }
+    if (name == "--rate") {
+        options.rateHz = number;
+    } else if (channelRate) {
+        options.channelRates[name.substr(7)] = number;
+    } else if (name == "--duration") {
+        options.durationSeconds = number;
+    } else {
+        options.spinUs = static_cast<int64_t>(number);
+    }
+    return OptionStatus::Parsed;
+}
+
+void printPacingUsage(std::ostream& out, const std::vector<std::string>& channels)
+{
+    out << "  --rate HZ             default rate of every channel, " << PacingEngine::kMinRateHz << " to "
+        << PacingEngine::kMaxRateHz << " Hz (default 10)\n"
+        << "  --rate-<channel> HZ   rate of one channel (";
+    for (size_t i = 0; i < channels.size(); ++i) {
+        out << (i ? ", " : "") << channels[i];
+    }
+    out << "), e.g. --rate-" << (channels.empty() ? "can" : channels.front()) << " 1000\n"
+        << "  --duration S          stop after S seconds (default: until Ctrl+C)\n"
+        << "  --spin-us US          busy-wait the last US microseconds before each deadline (default 0)\n";
+}
+
+PacingEngine::PacingEngine(int64_t spinUs, double durationSeconds)
+    : m_spinNs(std::max<int64_t>(spinUs, 0) * kNsPerUs),
+      m_durationNs(static_cast<int64_t>(std::max(durationSeconds, 0.0) * kNsPerSecond)),
+      m_runStartNs(0),
+      m_runEndNs(0),
+      m_stopRequested(false)
+{
+}
+
+int PacingEngine::addChannel(const std::string& name, double rateHz)
+{
+    double clamped = std::min(std::max(rateHz, kMinRateHz), kMaxRateHz);
+    if (clamped != rateHz) {
+        std::cerr << "Rate of " << name << " clamped to " << clamped << " Hz" << std::endl;
+    }
+
+    Channel channel;
+    channel.name = name;
+    channel.rateHz = clamped;
+    channel.periodNs = static_cast<int64_t>(kNsPerSecond / clamped);
+    channel.startNs = 0;
+    channel.nextDeadlineNs = 0;
+    channel.nextTick = 0;
+    channel.ticks = 0;
+    channel.missed = 0;
+    m_channels.push_back(channel);
+    return static_cast<int>(m_channels.size()) - 1;
+}
+
+void PacingEngine::setRate(int index, double rateHz)
+{
+    Channel& channel = m_channels[index];
+    channel.rateHz = std::min(std::max(rateHz, kMinRateHz), kMaxRateHz);
+    channel.periodNs = static_cast<int64_t>(kNsPerSecond / channel.rateHz);
+    if (channel.startNs != 0) {
+        // Restart the grid at the pending deadline so the change does not shift or burst ticks
+        channel.startNs = channel.nextDeadlineNs;
+        channel.nextTick = 0;
+    }
+}
+
+uint64_t PacingEngine::missedDeadlines() const
+{
+    uint64_t missed = 0;
+    for (const Channel& channel : m_channels) {
+        missed += channel.missed;
+    }
+    return missed;
+}
+
+int PacingEngine::waitNext()
+{
+    if (m_channels.empty() || stopped()) {
+        stop();
+        if (m_runEndNs == 0) {
+            m_runEndNs = monotonicNs();
+        }
+        return -1;
+    }
+
+    int64_t now = monotonicNs();
+    if (m_runStartNs == 0) {
+        // All channels tick for the first time right away, then on their own grid
+        m_runStartNs = now;
+        for (Channel& channel : m_channels) {
+            channel.startNs = now;
+            channel.nextDeadlineNs = now;
+        }
+    }
+
+    // Skip periods that are already a full period overdue rather than sending them in a burst
+    for (Channel& channel : m_channels) {
+        while (channel.nextDeadlineNs + channel.periodNs <= now) {
+            ++channel.missed;
+            ++channel.nextTick;
+            channel.nextDeadlineNs =
+                channel.startNs + static_cast<int64_t>(channel.nextTick * (kNsPerSecond / channel.rateHz));
+        }
+    }
+
+    size_t next = 0;
+    for (size_t i = 1; i < m_channels.size(); ++i) {
+        if (m_channels[i].nextDeadlineNs < m_channels[next].nextDeadlineNs) {
+            next = i;
+        }
+    }
+    Channel& channel = m_channels[next];
+
+    if (m_durationNs > 0 && channel.nextDeadlineNs >= m_runStartNs + m_durationNs) {
+        if (!sleepUntilNs(m_runStartNs + m_durationNs, m_spinNs, m_stopRequested)) {
+            m_runEndNs = monotonicNs();
+            return -1;
+        }
+        stop();
+        m_runEndNs = m_runStartNs + m_durationNs;
+        return -1;
+    }
+
+    if (!sleepUntilNs(channel.nextDeadlineNs, m_spinNs, m_stopRequested)) {
+        m_runEndNs = monotonicNs();
+        return -1;
+    }
+    completeTick(channel, monotonicNs());
+    return static_cast<int>(next);
+}
+
+void PacingEngine::stopOnSignals()
+{
+    g_signalEngine = this;
+
+    // No SA_RESTART, so a pending clock_nanosleep returns EINTR and the loop ends promptly
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stopSignalEngine;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+
+void PacingEngine::report(std::ostream& out) const
+{
+    int64_t endNs = m_runEndNs != 0 ? m_runEndNs : monotonicNs();
+    double seconds = m_runStartNs != 0 ? static_cast<double>(endNs - m_runStartNs) / kNsPerSecond : 0.0;
+
+    out << "Pacing report: " << std::fixed << std::setprecision(3) << seconds << " s";
+    if (m_spinNs > 0) {
+        out << ", spin tail " << m_spinNs / kNsPerUs << " us";
+    }
+    out << "\n";
+
+    for (const Channel& channel : m_channels) {
+        double achieved = seconds > 0.0 ? channel.ticks / seconds : 0.0;
+        out << "  " << channel.name << ": target " << std::setprecision(1) << channel.rateHz << " Hz, achieved "
+            << achieved << " Hz, " << channel.ticks << " ticks, " << channel.missed << " missed deadlines\n";
+        out << "    lateness us: ";
+        channel.lateness.print(out);
+        out << "\n";
+    }
+    out.flush();
+}
+
+void PacingEngine::completeTick(Channel& channel, int64_t wakeNs)
+{
+    channel.lateness.record(wakeNs - channel.nextDeadlineNs);
+    ++channel.ticks;
+    ++channel.nextTick;
+    channel.nextDeadlineNs = channel.startNs + static_cast<int64_t>(channel.nextTick * (kNsPerSecond / channel.rateHz));
+}
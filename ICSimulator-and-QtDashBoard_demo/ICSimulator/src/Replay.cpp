@@ -0,0 +1,114 @@
+#include <cerrno>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "CaptureSource.hpp"
+#include "ReplayEngine.hpp"
+
+namespace {
+
+void printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [options] CAPTURE...\n"
+              << "  CAPTURE             .sigcap capture, or JSON log (can_*.json, udp_*.json, original_sender_*.json)\n"
+              << "  --speed X           playback speed factor (default 1; 0 replays as fast as possible)\n"
+              << "  --rate HZ           record rate of JSON logs, which carry no timestamps (default 10)\n"
+              << "  --bus BUS           bus of JSON logs: can, udp, flexray or all (default: from the file name,\n"
+              << "                      all for original_sender_*.json)\n"
+              << "  --spin-us US        busy-wait the last US microseconds before each deadline (default 0)\n"
+              << "  --interface IF      CAN interface (default vcan0)\n";
+}
+
+bool parseNumber(const char* text, double& value)
+{
+    char* end = nullptr;
+    errno = 0;
+    value = strtod(text, &end);
+    return errno == 0 && end != text && *end == '\0' && value >= 0.0;
+}
+
+bool parseBus(const std::string& text, sigcap::Bus& bus)
+{
+    if (text == "can") {
+        bus = sigcap::Bus::Can;
+    } else if (text == "udp") {
+        bus = sigcap::Bus::Udp;
+    } else if (text == "flexray") {
+        bus = sigcap::Bus::FlexRay;
+    } else if (text == "all") {
+        bus = sigcap::Bus::Unknown;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    ReplayOptions options;
+    double rateHz = 10.0;
+    bool busGiven = false;
+    sigcap::Bus jsonBus = sigcap::Bus::Unknown;
+    std::vector<std::string> captures;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            captures.push_back(arg);
+            continue;
+        }
+        if (arg == "--help" || i + 1 >= argc) {
+            printUsage(argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+
+        std::string value = argv[++i];
+        double number = 0.0;
+        if (arg == "--bus") {
+            busGiven = parseBus(value, jsonBus);
+            if (!busGiven) {
+                std::cerr << "Unknown bus: " << value << std::endl;
+                return 1;
+            }
+        } else if (arg == "--interface") {
+            options.canInterface = value;
+        } else if (!parseNumber(value.c_str(), number)) {
+            std::cerr << "Invalid value for " << arg << ": " << value << std::endl;
+            return 1;
+        } else if (arg == "--speed") {
+            options.speed = number;
+        } else if (arg == "--rate") {
+            rateHz = number;
+        } else if (arg == "--spin-us") {
+            options.spinUs = static_cast<int64_t>(number);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (captures.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    ReplayEngine engine(options);
+    for (const std::string& path : captures) {
+        std::string error;
+        std::unique_ptr<CaptureSource> source = openCapture(path, busGiven ? jsonBus : busFromFileName(path), rateHz, error);
+        if (!source) {
+            std::cerr << "Failed to open capture " << path << ": " << error << std::endl;
+            return 1;
+        }
+        engine.addSource(std::move(source));
+    }
+
+    engine.openBuses();
+    engine.stopOnSignals();
+    engine.run();
+    engine.report(std::cout);
+    return 0;
+}
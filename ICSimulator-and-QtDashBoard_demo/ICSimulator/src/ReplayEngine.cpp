@@ -0,0 +1,339 @@
+#include "ReplayEngine.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr int64_t kNsPerSecond = 1000000000;
+constexpr int64_t kQueueWaitNs = 100000;    // Back-off of a thread waiting on the prefetch queue
+
+// Engine stopped by SIGINT/SIGTERM
+ReplayEngine* g_signalEngine = nullptr;
+
+void stopSignalEngine(int)
+{
+    if (g_signalEngine) {
+        g_signalEngine->stop();
+    }
+}
+
+void napNs(int64_t ns)
+{
+    struct timespec pause = {0, static_cast<long>(ns)};
+    nanosleep(&pause, nullptr);
+}
+
+int openCanSocket(const std::string& interfaceName)
+{
+    int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd < 0) {
+        perror("Failed to create CAN socket");
+        return -1;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+
+    struct ifreq ifr = {};
+    strncpy(ifr.ifr_name, interfaceName.c_str(), IFNAMSIZ - 1);
+    if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0) {
+        perror("Failed to retrieve CAN interface index");
+        close(fd);
+        return -1;
+    }
+
+    struct sockaddr_can addr = {};
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        perror("Failed to bind CAN socket");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int openUdpSocket(const std::string& host, int port, struct sockaddr_in& destination)
+{
+    memset(&destination, 0, sizeof(destination));
+    destination.sin_family = AF_INET;
+    destination.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &destination.sin_addr) <= 0) {
+        perror("Invalid address/Address not supported");
+        return -1;
+    }
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) {
+        perror("Socket creation failed");
+        return -1;
+    }
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    return fd;
+}
+
+size_t roundUpPowerOfTwo(size_t value)
+{
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+ReplayEngine::ReplayEngine(const ReplayOptions& options)
+    : m_options(options),
+      m_buses{{"can", -1, FrameBatcher(sizeof(struct can_frame)), 0},
+              {"udp", -1, FrameBatcher(sizeof(ReplayFrame::payload)), 0},
+              {"flexray", -1, FrameBatcher(sizeof(ReplayFrame::payload)), 0}},
+      m_queue(roundUpPowerOfTwo(std::max<size_t>(options.queueFrames, 2))),
+      m_mask(m_queue.size() - 1),
+      m_head(0),
+      m_tail(0),
+      m_prefetchDone(false),
+      m_stopRequested(false),
+      m_frames(0),
+      m_deadlines(0),
+      m_underruns(0),
+      m_unsupported(0),
+      m_runStartNs(0),
+      m_runEndNs(0)
+{
+}
+
+ReplayEngine::~ReplayEngine()
+{
+    stop();
+    if (m_prefetchThread.joinable()) {
+        m_prefetchThread.join();
+    }
+    for (BusOutput& bus : m_buses) {
+        if (bus.socket >= 0) {
+            bus.batcher.flush();
+            close(bus.socket);
+        }
+    }
+}
+
+void ReplayEngine::addSource(std::unique_ptr<CaptureSource> source)
+{
+    m_sources.push_back(std::move(source));
+}
+
+void ReplayEngine::openBuses()
+{
+    m_buses[kCan].socket = openCanSocket(m_options.canInterface);
+    m_buses[kCan].batcher.attach(m_buses[kCan].socket);
+
+    struct sockaddr_in destination;
+    m_buses[kUdp].socket = openUdpSocket(m_options.host, m_options.udpPort, destination);
+    m_buses[kUdp].batcher.attach(m_buses[kUdp].socket, reinterpret_cast<struct sockaddr*>(&destination),
+                                 sizeof(destination));
+    m_buses[kFlexRay].socket = openUdpSocket(m_options.host, m_options.flexRayPort, destination);
+    m_buses[kFlexRay].batcher.attach(m_buses[kFlexRay].socket, reinterpret_cast<struct sockaddr*>(&destination),
+                                     sizeof(destination));
+}
+
+void ReplayEngine::run()
+{
+    m_prefetchThread = std::thread(&ReplayEngine::prefetch, this);
+
+    const double nsPerCaptureNs = m_options.speed > 0.0 ? 1.0 / m_options.speed : 0.0;
+    const int64_t spinNs = m_options.spinUs * 1000;
+    int64_t currentDeadlineNs = -1;
+    ReplayFrame frame;
+
+    m_runStartNs = monotonicNs();
+    while (pop(frame)) {
+        int64_t deadlineNs = m_runStartNs + static_cast<int64_t>(frame.timestampNs * nsPerCaptureNs);
+        if (nsPerCaptureNs > 0.0 && deadlineNs != currentDeadlineNs) {
+            // New deadline: send what the previous one queued, then wait for this one
+            flushAll();
+            if (!sleepUntilNs(deadlineNs, spinNs, m_stopRequested)) {
+                break;
+            }
+            m_lateness.record(monotonicNs() - deadlineNs);
+            ++m_deadlines;
+            currentDeadlineNs = deadlineNs;
+        }
+        queueFrame(frame);
+    }
+    flushAll();
+    m_runEndNs = monotonicNs();
+
+    stop();
+    m_prefetchThread.join();
+}
+
+void ReplayEngine::stopOnSignals()
+{
+    g_signalEngine = this;
+
+    // No SA_RESTART, so a pending clock_nanosleep returns EINTR and the replay ends promptly
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stopSignalEngine;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+}
+
+void ReplayEngine::report(std::ostream& out) const
+{
+    double seconds = m_runEndNs > m_runStartNs ? static_cast<double>(m_runEndNs - m_runStartNs) / kNsPerSecond : 0.0;
+
+    out << "Replay report: " << std::fixed << std::setprecision(3) << seconds << " s, " << m_frames << " frames";
+    if (m_options.speed > 0.0) {
+        out << ", speed x" << std::setprecision(2) << m_options.speed;
+    } else {
+        out << ", unpaced";
+    }
+    out << ", " << m_underruns << " prefetch underruns";
+    if (m_unsupported > 0) {
+        out << ", " << m_unsupported << " frames on unsupported buses";
+    }
+    out << "\n";
+
+    for (const BusOutput& bus : m_buses) {
+        out << "  " << bus.name << ": " << bus.batcher.sentFrames() << " sent, "
+            << bus.batcher.droppedFrames() + bus.unsent << " dropped, " << bus.batcher.flushCalls()
+            << " sendmmsg calls\n";
+    }
+    if (m_deadlines > 0) {
+        out << "  " << m_deadlines << " deadlines, lateness us: ";
+        m_lateness.print(out);
+        out << "\n";
+    }
+    out.flush();
+}
+
+void ReplayEngine::prefetch()
+{
+    // Head frame of every source that is not exhausted yet
+    std::vector<ReplayFrame> heads(m_sources.size());
+    std::vector<size_t> live;
+    for (size_t i = 0; i < m_sources.size(); ++i) {
+        if (m_sources[i]->next(heads[i])) {
+            live.push_back(i);
+        }
+    }
+
+    uint64_t head = m_head.load(std::memory_order_relaxed);
+    while (!live.empty() && !m_stopRequested.load(std::memory_order_relaxed)) {
+        // A handful of captures at most, so a linear scan beats a heap
+        size_t earliest = 0;
+        for (size_t i = 1; i < live.size(); ++i) {
+            if (heads[live[i]].timestampNs < heads[live[earliest]].timestampNs) {
+                earliest = i;
+            }
+        }
+
+        while (head - m_tail.load(std::memory_order_acquire) > m_mask) {
+            if (m_stopRequested.load(std::memory_order_relaxed)) {
+                break;
+            }
+            napNs(kQueueWaitNs);
+        }
+        if (m_stopRequested.load(std::memory_order_relaxed)) {
+            break;
+        }
+
+        size_t source = live[earliest];
+        m_queue[head & m_mask] = heads[source];
+        m_head.store(++head, std::memory_order_release);
+
+        if (!m_sources[source]->next(heads[source])) {
+            live.erase(live.begin() + earliest);
+        }
+    }
+    m_prefetchDone.store(true, std::memory_order_release);
+}
+
+bool ReplayEngine::pop(ReplayFrame& frame)
+{
+    uint64_t tail = m_tail.load(std::memory_order_relaxed);
+    bool waited = false;
+    while (tail == m_head.load(std::memory_order_acquire)) {
+        if (m_stopRequested.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        if (m_prefetchDone.load(std::memory_order_acquire)) {
+            // The producer may have published its last frames right before finishing
+            if (tail == m_head.load(std::memory_order_acquire)) {
+                return false;
+            }
+            break;
+        }
+        if (!waited) {
+            ++m_underruns;
+            waited = true;
+        }
+        napNs(kQueueWaitNs);
+    }
+
+    frame = m_queue[tail & m_mask];
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+void ReplayEngine::queueFrame(const ReplayFrame& frame)
+{
+    ++m_frames;
+    switch (frame.bus) {
+    case sigcap::Bus::Can:
+    case sigcap::Bus::Unknown: {
+        struct can_frame canFrame = {};
+        canFrame.can_id = frame.id;
+        canFrame.can_dlc = std::min<uint8_t>(frame.length, CAN_MAX_DLEN);
+        memcpy(canFrame.data, frame.payload, canFrame.can_dlc);
+        queueOn(kCan, &canFrame, sizeof(canFrame));
+        if (frame.bus == sigcap::Bus::Can) {
+            break;
+        }
+        // Untargeted JSON records go to every bus, like the Sender
+        queueOn(kUdp, frame.payload, frame.length);
+        queueOn(kFlexRay, frame.payload, frame.length);
+        break;
+    }
+    case sigcap::Bus::Udp:
+        queueOn(kUdp, frame.payload, frame.length);
+        break;
+    case sigcap::Bus::FlexRay:
+        queueOn(kFlexRay, frame.payload, frame.length);
+        break;
+    default:
+        ++m_unsupported;
+        break;
+    }
+}
+
+void ReplayEngine::queueOn(BusIndex index, const void* data, size_t length)
+{
+    BusOutput& bus = m_buses[index];
+    if (bus.socket < 0) {
+        ++bus.unsent;
+        return;
+    }
+    bus.batcher.queue(data, length);
+}
+
+void ReplayEngine::flushAll()
+{
+    for (BusOutput& bus : m_buses) {
+        if (bus.batcher.pending() > 0) {
+            bus.batcher.flush();
+        }
+    }
+}
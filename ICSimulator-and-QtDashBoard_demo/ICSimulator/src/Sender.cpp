@@ -1,8 +1,6 @@
 #include <iostream>
 #include <cstring>
 #include <unistd.h>
-#include <thread>
-#include <chrono>
 #include <functional>
 #include <arpa/inet.h>
 #include <fcntl.h>
@@ -10,25 +8,31 @@
 #include <linux/can/raw.h>
 #include <sys/ioctl.h>
 #include <net/if.h>
-#include <fstream>
-#include <nlohmann/json.hpp>
-#include <iomanip>
-#include <sstream>
-#include <mutex>
 #include <sys/socket.h>
 #include <netinet/in.h>
-
-using json = nlohmann::json;
+#include <vector>
+#include "PayloadCodec.hpp"
+#include "PacingEngine.hpp"
+#include "SenderOptions.hpp"
+#include "FrameBatcher.hpp"
+#include "DatabaseTraffic.hpp"
+#include "WireFormat.hpp"
+#include "CaptureSink.hpp"
+#include "UringSender.hpp"
+#include "Multicast.hpp"
+#include "Waveform.hpp"
 
 class UDPSimulator {
 private:
     int m_socket;
     struct sockaddr_in m_serverAddr;
-    std::mutex m_mutex;
-    json m_entries;
+    CaptureSink *m_capture = nullptr;
+    FrameBatcher m_batcher;
+    wire::Format m_format = wire::Format::Ascii;
+    wire::Encoder m_encoder;
 
 public:
-    UDPSimulator(const std::string& ip, int port) : m_socket(-1) {
+    UDPSimulator(const std::string& ip, int port) : m_socket(-1), m_batcher(wire::kFullSize) {
         m_socket = socket(AF_INET, SOCK_DGRAM, 0);
         if (m_socket < 0) {
             perror("Failed to create UDP socket");
@@ -44,40 +48,57 @@ public:
             closeSocket();
             return;
         }
-        m_entries = json::array();
+        m_batcher.attach(m_socket, reinterpret_cast<struct sockaddr*>(&m_serverAddr), sizeof(m_serverAddr));
     }
 
     ~UDPSimulator() {
+        flush();
         closeSocket();
     }
 
-    void closeSocket() {
-        if (m_socket >= 0) {
-            close(m_socket);
-            m_socket = -1;
+    // Sends all queued frames with one sendmmsg call
+    bool flush() {
+        return m_batcher.flush();
+    }
+
+    // Sets TTL and outgoing interface when the destination is a multicast group; no-op for unicast
+    bool configureMulticast(int ttl, const std::string& interfaceAddress) {
+        if (m_socket < 0 || !mcast::isMulticast(m_serverAddr.sin_addr)) {
+            return true;
+        }
+        struct in_addr interface;
+        if (!mcast::parseAddress(interfaceAddress.c_str(), interface) ||
+            !mcast::configureSender(m_socket, ttl, interface)) {
+            perror("Failed to configure UDP multicast");
+            return false;
         }
+        return true;
     }
 
-    void logToJson(float speed, float rpm) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        json signalEntry;
-        signalEntry["Speed"] = speed;
-        signalEntry["RPM"] = rpm;
+    const FrameBatcher &batcher() const {
+        return m_batcher;
+    }
 
-        m_entries.push_back(signalEntry);
-        saveJsonFile("original_sender.json", m_entries);
+    // Sends through the shared io_uring instead of sendmmsg
+    void useUring(UringSender *uring) {
+        m_batcher.useUring(uring);
     }
 
-    void saveJsonFile(const std::string &filename, const json &json_data) {
-        std::ofstream file(filename, std::ios::out | std::ios::trunc);
-        if (!file.is_open()) {
-            std::cerr << "Failed to save JSON file: " << filename << std::endl;
-            return;
+    // Payload of the speed/RPM frames: legacy ASCII or sequenced binary frames (WireFormat.hpp)
+    void setWireFormat(wire::Format format) {
+        m_format = format;
+    }
+
+    void closeSocket() {
+        if (m_socket >= 0) {
+            close(m_socket);
+            m_socket = -1;
         }
+    }
 
-        file << json_data.dump(2);
-        file.close();
-        std::cout << "Saved JSON file: " << filename << std::endl;
+    // Sink that captures every speed/RPM frame sent (nullptr: no capture)
+    void setCapture(CaptureSink *capture) {
+        m_capture = capture;
     }
 
     bool sendUDPData(float speed, float rpm) {
@@ -89,42 +110,33 @@ public:
         speed = std::max(0.0f, speed);
         rpm = std::max(0.0f, rpm);
 
-        std::ostringstream speedStream, rpmStream;
-        speedStream << std::fixed << std::setprecision(1) << speed;
-        rpmStream << std::fixed << std::setprecision(0) << rpm;
-
-        std::string speedStr = speedStream.str();
-        std::string rpmStr = rpmStream.str();
-
-        speedStr = (speedStr.size() > 4 ? speedStr.substr(0, 4) : speedStr + std::string(4 - speedStr.size(), ' '));
-        rpmStr = (rpmStr.size() > 4 ? rpmStr.substr(0, 4) : rpmStr + std::string(4 - rpmStr.size(), ' '));
-
-        uint8_t buffer[8];
-        memcpy(buffer, speedStr.c_str(), 4);
-        memcpy(buffer + 4, rpmStr.c_str(), 4);
-
-        logToJson(speed, rpm);
-        std::cout << "UDP Sending: Speed=" << speed << ", RPM=" << rpm << std::endl;
-
-        ssize_t sent = sendto(m_socket, buffer, sizeof(buffer), 0,
-                              (struct sockaddr*)&m_serverAddr, sizeof(m_serverAddr));
+        uint8_t buffer[wire::kFullSize];
+        size_t length = payload::kFrameSize;
+        if (m_format == wire::Format::Binary) {
+            length = m_encoder.encodeFull(speed, rpm, buffer);
+        } else {
+            payload::encodeSpeedRpm(speed, rpm, buffer);
+        }
 
-        if (sent < 0) {
-            std::cerr << "Failed to send UDP message: " << strerror(errno) << std::endl;
-            return false;
+        if (m_capture) {
+            m_capture->record(sigcap::Bus::Udp, 0, buffer, length, speed, rpm);
         }
-        return true;
+
+        // Sent with the rest of the batch on the next flush()
+        return m_batcher.queue(buffer, length);
     }
 };
 
 class ICSimulator {
 private:
     int m_socket;
-    std::mutex m_mutex;
-    json m_entries;
+    CaptureSink *m_capture = nullptr;
+    FrameBatcher m_batcher;
+    wire::Format m_format = wire::Format::Ascii;
+    wire::Encoder m_encoder;
 
 public:
-    ICSimulator() : m_socket(socket(PF_CAN, SOCK_RAW, CAN_RAW)) {
+    ICSimulator() : m_socket(socket(PF_CAN, SOCK_RAW, CAN_RAW)), m_batcher(CANFD_MTU) {
         if (m_socket < 0) {
             perror("Failed to create CAN socket");
             return;
@@ -147,13 +159,33 @@ public:
             perror("Failed to bind CAN socket");
             closeSocket();
         }
-        m_entries = json::array();
+        m_batcher.attach(m_socket);
     }
 
     ~ICSimulator() {
+        flush();
         closeSocket();
     }
 
+    // Sends all queued frames with one sendmmsg call
+    bool flush() {
+        return m_batcher.flush();
+    }
+
+    const FrameBatcher &batcher() const {
+        return m_batcher;
+    }
+
+    // Sends through the shared io_uring instead of sendmmsg
+    void useUring(UringSender *uring) {
+        m_batcher.useUring(uring);
+    }
+
+    // Payload of the speed/RPM frames: legacy ASCII or sequenced binary frames (WireFormat.hpp)
+    void setWireFormat(wire::Format format) {
+        m_format = format;
+    }
+
     void closeSocket() {
         if (m_socket >= 0) {
             close(m_socket);
@@ -161,81 +193,86 @@ public:
         }
     }
 
-    void logToJson(float speed, float rpm) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        json signalEntry;
-        signalEntry["Speed"] = speed;
-        signalEntry["RPM"] = rpm;
-
-        m_entries.push_back(signalEntry);
-        saveJsonFile("original_sender.json", m_entries);
+    // Sink that captures every speed/RPM frame sent (nullptr: no capture)
+    void setCapture(CaptureSink *capture) {
+        m_capture = capture;
     }
 
-    void saveJsonFile(const std::string &filename, const json &json_data) {
-        std::ofstream file(filename, std::ios::out | std::ios::trunc);
-        if (!file.is_open()) {
-            std::cerr << "Failed to save JSON file: " << filename << std::endl;
-            return;
-        }
-
-        file << json_data.dump(2);
-        file.close();
-        std::cout << "Saved JSON file: " << filename << std::endl;
+    bool sendCANData(uint32_t canId, const void *data, size_t dataSize) {
+        struct can_frame frame = {};
+        frame.can_id = canId;
+        frame.can_dlc = 8;
+        memset(frame.data, 0, sizeof(frame.data));
+        memcpy(frame.data, data, dataSize);
+        return sendFrame(frame);
     }
 
-    bool sendCANData(uint32_t canId, const void *data, size_t dataSize) {
+    // Queues a complete frame, e.g. one packed from the signal database
+    bool sendFrame(const struct can_frame &frame) {
         if (m_socket < 0) {
             std::cerr << "CAN Socket is not open!" << std::endl;
             return false;
         }
 
-        struct can_frame frame = {};
-        frame.can_id = canId;
-        frame.can_dlc = 8;
-        memset(frame.data, 0, sizeof(frame.data));
-        memcpy(frame.data, data, dataSize);
+        // Sent with the rest of the batch on the next flush()
+        return m_batcher.queue(&frame, sizeof(frame));
+    }
 
-        if (write(m_socket, &frame, sizeof(frame)) != sizeof(frame)) {
-            perror("Failed to send CAN message");
+    // Switches the socket to CAN FD (CAN_RAW_FD_FRAMES); classic frames can still be sent
+    bool enableFd() {
+        int enable = 1;
+        if (m_socket < 0 || setsockopt(m_socket, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &enable, sizeof(enable)) < 0) {
+            perror("Failed to enable CAN FD frames");
             return false;
         }
         return true;
     }
 
+    // Queues a CAN FD frame of up to 64 bytes
+    bool sendFdFrame(const struct canfd_frame &frame) {
+        if (m_socket < 0) {
+            std::cerr << "CAN Socket is not open!" << std::endl;
+            return false;
+        }
+        return m_batcher.queue(&frame, CANFD_MTU);
+    }
+
     bool sendCombinedData(float speed, float rpm) {
         speed = std::max(0.0f, speed);
         rpm = std::max(0.0f, rpm);
 
-        std::ostringstream speedStream, rpmStream;
-        speedStream << std::fixed << std::setprecision(1) << speed;
-        rpmStream << std::fixed << std::setprecision(0) << rpm;
-
-        std::string speedStr = speedStream.str();
-        std::string rpmStr = rpmStream.str();
-
-        speedStr = (speedStr.size() > 4 ? speedStr.substr(0, 4) : speedStr + std::string(4 - speedStr.size(), ' '));
-        rpmStr = (rpmStr.size() > 4 ? rpmStr.substr(0, 4) : rpmStr + std::string(4 - rpmStr.size(), ' '));
-
-        uint8_t buffer[8];
-        memcpy(buffer, speedStr.c_str(), 4);
-        memcpy(buffer + 4, rpmStr.c_str(), 4);
-
-        logToJson(speed, rpm);
-        std::cout << "CAN Sending: Speed=" << speed << ", RPM=" << rpm << std::endl;
+        uint8_t buffer[payload::kFrameSize];
+        if (m_format == wire::Format::Binary) {
+            m_encoder.encodeCompact(speed, rpm, buffer);
+        } else {
+            payload::encodeSpeedRpm(speed, rpm, buffer);
+        }
 
+        if (m_capture) {
+            m_capture->record(sigcap::Bus::Can, 0x64, buffer, sizeof(buffer), speed, rpm);
+        }
         return sendCANData(0x64, buffer, sizeof(buffer));
     }
+
+    // Captures speed/RPM values sent inside a signal database frame instead of their own frame
+    void captureValues(float speed, float rpm) {
+        if (m_capture) {
+            m_capture->record(sigcap::Bus::Can, 0, nullptr, 0, speed, rpm);
+        }
+    }
 };
 
 class FlexRaySimulator {
 private:
     int m_socket;
     struct sockaddr_in m_serverAddr;
-    std::mutex m_mutex;
-    json m_entries;
+    CaptureSink *m_capture = nullptr;
+    FrameBatcher m_batcher;
+    wire::Format m_format = wire::Format::Ascii;
+    wire::Encoder m_encoder;
 
 public:
-    FlexRaySimulator(const std::string& ip, int port) : m_socket(-1) {
+    FlexRaySimulator(const std::string& ip, int port) : m_socket(-1), m_batcher(wire::kFullSize) {
         m_socket = socket(AF_INET, SOCK_DGRAM, 0);
         if (m_socket < 0) {
             perror("Failed to create FlexRay UDP socket");
@@ -251,40 +288,57 @@ public:
             closeSocket();
             return;
         }
-        m_entries = json::array();
+        m_batcher.attach(m_socket, reinterpret_cast<struct sockaddr*>(&m_serverAddr), sizeof(m_serverAddr));
     }
 
     ~FlexRaySimulator() {
+        flush();
         closeSocket();
     }
 
-    void closeSocket() {
-        if (m_socket >= 0) {
-            close(m_socket);
-            m_socket = -1;
+    // Sends all queued frames with one sendmmsg call
+    bool flush() {
+        return m_batcher.flush();
+    }
+
+    // Sets TTL and outgoing interface when the destination is a multicast group; no-op for unicast
+    bool configureMulticast(int ttl, const std::string& interfaceAddress) {
+        if (m_socket < 0 || !mcast::isMulticast(m_serverAddr.sin_addr)) {
+            return true;
+        }
+        struct in_addr interface;
+        if (!mcast::parseAddress(interfaceAddress.c_str(), interface) ||
+            !mcast::configureSender(m_socket, ttl, interface)) {
+            perror("Failed to configure FlexRay multicast");
+            return false;
         }
+        return true;
     }
 
-    void logToJson(float speed, float rpm) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        json signalEntry;
-        signalEntry["Speed"] = speed;
-        signalEntry["RPM"] = rpm;
+    const FrameBatcher &batcher() const {
+        return m_batcher;
+    }
 
-        m_entries.push_back(signalEntry);
-        saveJsonFile("original_sender.json", m_entries);
+    // Sends through the shared io_uring instead of sendmmsg
+    void useUring(UringSender *uring) {
+        m_batcher.useUring(uring);
     }
 
-    void saveJsonFile(const std::string &filename, const json &json_data) {
-        std::ofstream file(filename, std::ios::out | std::ios::trunc);
-        if (!file.is_open()) {
-            std::cerr << "Failed to save JSON file: " << filename << std::endl;
-            return;
+    // Payload of the speed/RPM frames: legacy ASCII or sequenced binary frames (WireFormat.hpp)
+    void setWireFormat(wire::Format format) {
+        m_format = format;
+    }
+
+    void closeSocket() {
+        if (m_socket >= 0) {
+            close(m_socket);
+            m_socket = -1;
         }
+    }
 
-        file << json_data.dump(2);
-        file.close();
-        std::cout << "Saved JSON file: " << filename << std::endl;
+    // Sink that captures every speed/RPM frame sent (nullptr: no capture)
+    void setCapture(CaptureSink *capture) {
+        m_capture = capture;
     }
 
     bool sendUDPData(float speed, float rpm) {
@@ -296,31 +350,20 @@ public:
         speed = std::max(0.0f, speed);
         rpm = std::max(0.0f, rpm);
 
-        std::ostringstream speedStream, rpmStream;
-        speedStream << std::fixed << std::setprecision(1) << speed;
-        rpmStream << std::fixed << std::setprecision(0) << rpm;
-
-        std::string speedStr = speedStream.str();
-        std::string rpmStr = rpmStream.str();
-
-        speedStr = (speedStr.size() > 4 ? speedStr.substr(0, 4) : speedStr + std::string(4 - speedStr.size(), ' '));
-        rpmStr = (rpmStr.size() > 4 ? rpmStr.substr(0, 4) : rpmStr + std::string(4 - rpmStr.size(), ' '));
-
-        uint8_t buffer[8];
-        memcpy(buffer, speedStr.c_str(), 4);
-        memcpy(buffer + 4, rpmStr.c_str(), 4);
-
-        logToJson(speed, rpm);
-        std::cout << "FlexRay Sending: Speed=" << speed << ", RPM=" << rpm << std::endl;
-
-        ssize_t sent = sendto(m_socket, buffer, sizeof(buffer), 0,
-                              (struct sockaddr*)&m_serverAddr, sizeof(m_serverAddr));
+        uint8_t buffer[wire::kFullSize];
+        size_t length = payload::kFrameSize;
+        if (m_format == wire::Format::Binary) {
+            length = m_encoder.encodeFull(speed, rpm, buffer);
+        } else {
+            payload::encodeSpeedRpm(speed, rpm, buffer);
+        }
 
-        if (sent < 0) {
-            std::cerr << "Failed to send FlexRay UDP message: " << strerror(errno) << std::endl;
-            return false;
+        if (m_capture) {
+            m_capture->record(sigcap::Bus::FlexRay, 0, buffer, length, speed, rpm);
         }
-        return true;
+
+        // Sent with the rest of the batch on the next flush()
+        return m_batcher.queue(buffer, length);
     }
 
     bool sendCombinedData(float speed, float rpm) {
@@ -328,96 +371,173 @@ public:
     }
 };
 
-void simulateFloatData(const std::function<void(float, float)> &sendData,
-                       float startSpeed, float endSpeed,
-                       float startRPM, float endRPM,
-                       float stepSpeed, float stepRPM,
-                       std::chrono::milliseconds delay) {
-    if (startSpeed < 0 || endSpeed < 0 || startRPM < 0 || endRPM < 0 || stepSpeed <= 0 || stepRPM <= 0) {
-        std::cerr << "Invalid simulation parameters (negative or zero)" << std::endl;
-        return;
-    }
-
-    size_t speedSteps = static_cast<size_t>((endSpeed - startSpeed) / stepSpeed) + 1;
-    size_t rpmSteps = static_cast<size_t>((endRPM - startRPM) / stepRPM) + 1;
-    size_t speedCycleSteps = 2 * speedSteps - 1;
-    size_t rpmCycleSteps = 2 * rpmSteps - 1;
-
-    float speed = startSpeed;
-    float rpm = startRPM;
-    bool speedIncreasing = true;
-    bool rpmIncreasing = true;
-    size_t speedIndex = 0;
-    size_t rpmIndex = 0;
-
-    while (true) {
-        if (speedIncreasing) {
-            speed = startSpeed + speedIndex * stepSpeed;
-            speed = std::min(speed, endSpeed);
-            speedIndex++;
-            if (speed >= endSpeed) {
-                speedIncreasing = false;
-            }
-        } else {
-            speed = endSpeed - (speedIndex - speedSteps) * stepSpeed;
-            speed = std::max(startSpeed, speed);
-            speedIndex++;
-            if (speed <= startSpeed) {
-                speedIncreasing = true;
-                speedIndex = 0;
-            }
-        }
-
-        if (rpmIncreasing) {
-            rpm = startRPM + rpmIndex * stepRPM;
-            rpm = std::min(rpm, endRPM);
-            rpmIndex++;
-            if (rpm >= endRPM) {
-                rpmIncreasing = false;
-            }
-        } else {
-            rpm = endRPM - (rpmIndex - rpmSteps) * stepRPM;
-            rpm = std::max(startRPM, rpm);
-            rpmIndex++;
-            if (rpm <= startRPM) {
-                rpmIncreasing = true;
-                rpmIndex = 0;
-            }
+// Sends the speed/RPM stimulus on every channel until the pacer stops. channels[i] is called on the
+// ticks of pacer channel i with signals 0 (speed) and 1 (RPM) of stimuli[i] at its own tick count, so
+// each bus runs its own copy of the stimulus at its own rate. afterTick runs after every tick with the
+// channel index, including pacer channels beyond channels.size().
+void simulateFloatData(const std::vector<std::function<void(float, float)>> &channels,
+                       std::vector<WaveformBank> &stimuli,
+                       PacingEngine &pacer,
+                       const std::function<void(int)> &afterTick) {
+    std::vector<uint64_t> ticks(channels.size(), 0);
+
+    int channel;
+    while ((channel = pacer.waitNext()) >= 0) {
+        if (channel >= static_cast<int>(channels.size())) {
+            afterTick(channel);
+            continue;
         }
 
-        sendData(speed, rpm);
-        std::this_thread::sleep_for(delay);
+        WaveformBank &stimulus = stimuli[channel];
+        stimulus.generate(ticks[channel]++);
+        channels[channel](static_cast<float>(stimulus.value(0)), static_cast<float>(stimulus.value(1)));
+        afterTick(channel);
     }
 }
 
-int main() {
-    std::ofstream json_file("original_sender.json", std::ios::out | std::ios::trunc);
-    if (json_file.is_open()) {
-        json_file << "[]";
-        json_file.close();
-        std::cout << "Initialized original_sender.json as empty array" << std::endl;
-    } else {
-        std::cerr << "Failed to initialize original_sender.json" << std::endl;
+// Prints how many frames each bus sent and in how many sendmmsg calls
+void reportBatching(const char *bus, const FrameBatcher &batcher) {
+    double perCall = batcher.flushCalls() ? static_cast<double>(batcher.sentFrames()) / batcher.flushCalls() : 0.0;
+    std::cout << "  " << bus << ": " << batcher.sentFrames() << " frames in " << batcher.flushCalls()
+              << " sendmmsg calls (" << perCall << " per call), " << batcher.droppedFrames() << " dropped" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    SenderOptions options;
+    if (!parseSenderOptions(argc, argv, {"udp", "can", "flexray"}, options)) {
+        return 1;
+    }
+
+    // Every speed/RPM frame goes to one append-only capture, written by its own thread
+    CaptureSink capture;
+    bool capturing = options.capture != "none";
+    if (capturing && !capture.open(options.capture + ".sigcap")) {
         return 1;
     }
 
-    UDPSimulator udpSimulator("127.0.0.1", 5000);
+    // Declared before the simulators so it outlives their batchers
+    UringSender uring;
+
+    UDPSimulator udpSimulator(options.host, 5000);
     ICSimulator icSimulator;
-    FlexRaySimulator flexRaySimulator("127.0.0.1", 5002);
+    if (options.canFd && !icSimulator.enableFd()) {
+        std::cerr << "Continuing with classic CAN frames" << std::endl;
+        options.canFd = false;
+    }
+    FlexRaySimulator flexRaySimulator(options.host, 5002);
+    if (!udpSimulator.configureMulticast(options.multicastTtl, options.multicastInterface) ||
+        !flexRaySimulator.configureMulticast(options.multicastTtl, options.multicastInterface)) {
+        return 1;
+    }
+    udpSimulator.setWireFormat(options.wireFor("udp"));
+    icSimulator.setWireFormat(options.wireFor("can"));
+    flexRaySimulator.setWireFormat(options.wireFor("flexray"));
+    if (options.ioUring) {
+        if (uring.open()) {
+            udpSimulator.useUring(&uring);
+            icSimulator.useUring(&uring);
+            flexRaySimulator.useUring(&uring);
+            uring.registerBuffers();
+        } else {
+            std::cerr << "io_uring unavailable, sending with sendmmsg" << std::endl;
+            options.ioUring = false;
+        }
+    }
+    if (capturing) {
+        udpSimulator.setCapture(&capture);
+        icSimulator.setCapture(&capture);
+        flexRaySimulator.setCapture(&capture);
+    }
 
     const float max_speed = 78.0f;
     const float max_rpm = 8000.0f;
     const float speed_step = 5.0f;
     const float rpm_step = 100.0f;
 
+    signaldb::Database signalDatabase;
+    if (!DatabaseTraffic::load(options.signalDatabase, signalDatabase)) {
+        std::cerr << "Continuing without signal database traffic" << std::endl;
+    }
+    DatabaseTraffic databaseTraffic(signalDatabase, options.canFd);
+    // In FD mode speed and RPM travel in the FD message of the database instead of their own frame
+    bool packSpeedRpm = options.canFd && databaseTraffic.carriesGauge(signaldb::Gauge::Speed) &&
+                        databaseTraffic.carriesGauge(signaldb::Gauge::Rpm);
+
+    // Channel order matches the senders passed to simulateFloatData
+    PacingEngine pacer(options.spinUs, options.durationSeconds);
+    pacer.addChannel("udp", options.rateFor("udp"));
+    pacer.addChannel("can", options.rateFor("can"));
+    pacer.addChannel("flexray", options.rateFor("flexray"));
+    // Followed by one CAN channel per periodic signal database message
+    databaseTraffic.addChannels(pacer);
+    // Frames are held for up to one flush window and then sent in one call per bus
+    int flushChannel = options.flushUs > 0 ? pacer.addChannel("flush", 1e6 / options.flushUs) : -1;
+    pacer.stopOnSignals();
+
+    // Same stimulus on every bus, each at its own rate; a triangle of the step sizes is the classic sweep
+    std::vector<WaveformBank> stimuli(3);
+    const char *stimulusChannels[] = {"udp", "can", "flexray"};
+    for (size_t i = 0; i < stimuli.size(); ++i) {
+        if (!makeSpeedRpmStimulus(options.waveform, options.seed, options.rateFor(stimulusChannels[i]), max_speed,
+                                  max_rpm, speed_step, rpm_step, stimuli[i])) {
+            return 1;
+        }
+    }
+
     simulateFloatData(
-        [&udpSimulator, &icSimulator, &flexRaySimulator](float speed, float rpm) {
-            udpSimulator.sendUDPData(speed, rpm);
-            icSimulator.sendCombinedData(speed, rpm);
-            flexRaySimulator.sendCombinedData(speed, rpm);
+        {
+            [&udpSimulator](float speed, float rpm) { udpSimulator.sendUDPData(speed, rpm); },
+            [&icSimulator, &databaseTraffic, packSpeedRpm](float speed, float rpm) {
+                if (!packSpeedRpm) {
+                    icSimulator.sendCombinedData(speed, rpm);
+                    return;
+                }
+                icSimulator.captureValues(speed, rpm);
+                databaseTraffic.setGaugeValue(signaldb::Gauge::Speed, speed);
+                databaseTraffic.setGaugeValue(signaldb::Gauge::Rpm, rpm);
+            },
+            [&flexRaySimulator](float speed, float rpm) { flexRaySimulator.sendCombinedData(speed, rpm); },
         },
-        0.0f, max_speed, 0.0f, max_rpm, speed_step, rpm_step, std::chrono::milliseconds(100)
+        stimuli, pacer,
+        [&](int channel) {
+            struct canfd_frame frame;
+            bool fd = false;
+            if (databaseTraffic.nextFrame(channel, frame, fd)) {
+                // struct can_frame is layout-compatible with the head of struct canfd_frame
+                fd ? icSimulator.sendFdFrame(frame) : icSimulator.sendFrame(reinterpret_cast<const struct can_frame &>(frame));
+            }
+            if (flushChannel < 0 || channel == flushChannel) {
+                udpSimulator.flush();
+                icSimulator.flush();
+                flexRaySimulator.flush();
+                // With io_uring the flushes above only staged the frames; one submission sends all buses
+                uring.submit();
+            }
+        }
     );
 
+    // Send whatever the last window still holds
+    udpSimulator.flush();
+    icSimulator.flush();
+    flexRaySimulator.flush();
+    uring.submit();
+
+    pacer.report(std::cout);
+    std::cout << "Batching report:" << std::endl;
+    reportBatching("udp", udpSimulator.batcher());
+    reportBatching("can", icSimulator.batcher());
+    reportBatching("flexray", flexRaySimulator.batcher());
+    if (options.ioUring) {
+        uring.report(std::cout);
+    }
+
+    if (capturing) {
+        // The legacy JSON array is produced once, from the capture, instead of on every send
+        capture.close();
+        capture.report(std::cout);
+        if (!capture.exportJson(options.capture + ".json")) {
+            std::cerr << "Failed to export " << options.capture << ".json" << std::endl;
+        }
+    }
     return 0;
 }
\ No newline at end of file
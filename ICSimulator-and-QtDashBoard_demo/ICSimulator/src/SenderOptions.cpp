@@ -0,0 +1,118 @@
+#include "SenderOptions.hpp"
+#include <algorithm>
+#include <iostream>
+
+namespace {
+
+void printUsage(const char* program, const std::vector<std::string>& channels)
+{
+    std::cerr << "Usage: " << program << " [--rate HZ] [--rate-<channel> HZ] [--duration S] [--spin-us US] [--flush-us US] [--dbc FILE] [--fd] [--io-uring]\n"
+              << "       [--wire ascii|binary] [--wire-<channel> ascii|binary] [--capture BASE]\n"
+              << "       [--host ADDR] [--multicast-ttl N] [--multicast-if ADDR] [--waveform SHAPE|FILE] [--seed N]\n";
+    printPacingUsage(std::cerr, channels);
+    std::cerr << "  --flush-us US         batching senders: send queued frames every US microseconds (default 0)\n"
+              << "  --dbc FILE            CAN senders: signal database to send (default vehicle_signals.json, none disables)\n"
+              << "  --fd                  CAN senders: send CAN FD frames packing many signals each\n"
+              << "  --io-uring            batching senders: send through io_uring instead of sendmmsg\n"
+              << "  --wire FORMAT         speed/RPM payload: ascii (default) or sequenced, timestamped binary\n"
+              << "  --wire-<channel> F    payload of one channel, e.g. --wire-" << channels.front() << " binary\n"
+              << "  --host ADDR           UDP/FlexRay destination, unicast or multicast group (default 127.0.0.1)\n"
+              << "  --multicast-ttl N     TTL of multicast frames, 0 to 255 (default 1)\n"
+              << "  --multicast-if ADDR   address of the interface multicast frames leave by\n"
+              << "  --waveform SHAPE      speed/RPM waveform, ramp, triangle (default), sine, step, noise,\n"
+              << "                        or a file of \"seconds fraction\" lines for a piecewise-linear profile\n"
+              << "  --seed N              noise seed, the same seed gives the same stimulus (default 1)\n"
+              << "  --capture BASE        Sender: capture sent frames to BASE.sigcap, BASE.json on exit\n"
+              << "                        (default original_sender, none disables)\n";
+}
+
+} // namespace
+
+wire::Format SenderOptions::wireFor(const std::string& channel) const
+{
+    auto it = channelFormats.find(channel);
+    return it != channelFormats.end() ? it->second : wireFormat;
+}
+
+bool parseSenderOptions(int argc, char* argv[], const std::vector<std::string>& channels, SenderOptions& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--fd") {
+            options.canFd = true;
+            continue;
+        }
+        if (arg == "--io-uring") {
+            options.ioUring = true;
+            continue;
+        }
+        if (arg == "--help" || arg == "-h" || i + 1 >= argc || arg.compare(0, 2, "--") != 0) {
+            printUsage(argv[0], channels);
+            return false;
+        }
+
+        OptionStatus pacing = parsePacingOption(arg, argv[i + 1], channels, options);
+        if (pacing == OptionStatus::Invalid) {
+            return false;
+        }
+        if (pacing == OptionStatus::Parsed) {
+            ++i;
+            continue;
+        }
+
+        if (arg == "--dbc") {
+            options.signalDatabase = argv[++i];
+            continue;
+        }
+        if (arg == "--capture") {
+            options.capture = argv[++i];
+            continue;
+        }
+        if (arg == "--waveform") {
+            options.waveform = argv[++i];
+            continue;
+        }
+        if (arg == "--host" || arg == "--multicast-if") {
+            struct in_addr address;
+            if (!mcast::parseAddress(argv[i + 1], address)) {
+                std::cerr << "Invalid address for " << arg << ": " << argv[i + 1] << std::endl;
+                return false;
+            }
+            (arg == "--host" ? options.host : options.multicastInterface) = argv[++i];
+            continue;
+        }
+        if (arg == "--wire" || arg.compare(0, 7, "--wire-") == 0) {
+            if (arg != "--wire" && std::find(channels.begin(), channels.end(), arg.substr(7)) == channels.end()) {
+                std::cerr << "Unknown channel in " << arg << std::endl;
+                return false;
+            }
+            wire::Format format;
+            if (!wire::parseFormat(argv[i + 1], format)) {
+                std::cerr << "Invalid value for " << arg << ": " << argv[i + 1] << std::endl;
+                return false;
+            }
+            (arg == "--wire" ? options.wireFormat : options.channelFormats[arg.substr(7)]) = format;
+            ++i;
+            continue;
+        }
+
+        double value = 0.0;
+        if (!parseNonNegative(argv[i + 1], value)) {
+            std::cerr << "Invalid value for " << arg << ": " << argv[i + 1] << std::endl;
+            return false;
+        }
+        ++i;
+
+        if (arg == "--flush-us") {
+            options.flushUs = static_cast<int64_t>(value);
+        } else if (arg == "--seed") {
+            options.seed = static_cast<uint64_t>(value);
+        } else if (arg == "--multicast-ttl" && value <= 255.0) {
+            options.multicastTtl = static_cast<int>(value);
+        } else {
+            printUsage(argv[0], channels);
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,311 @@
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <memory>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+#include "FrameBatcher.hpp"
+#include "PacingEngine.hpp"
+#include "UringSender.hpp"
+
+// Compares the sendmmsg and io_uring transports of FrameBatcher on vcan0 and UDP loopback.
+// Every run sends the same number of frames in batches; with io_uring the batches of all buses in a run
+// go to the kernel in one submission, as in Sender. CAN runs are skipped when the interface is missing.
+
+namespace {
+
+struct BenchOptions
+{
+    uint64_t frames = 200000;        // Per bus and run
+    size_t batch = 64;
+    std::string interfaceName = "vcan0";
+    int port = 5099;
+};
+
+void printUsage(const char* program)
+{
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --frames N        frames per bus and run (default 200000)\n"
+              << "  --batch N         frames per flush (default 64)\n"
+              << "  --interface IF    CAN interface (default vcan0)\n"
+              << "  --port N          UDP loopback port (default 5099)\n";
+}
+
+bool parseBenchOptions(int argc, char* argv[], BenchOptions& options)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return false;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+        std::string value = argv[++i];
+        char* end = nullptr;
+        unsigned long long number = strtoull(value.c_str(), &end, 10);
+        bool numeric = !value.empty() && *end == '\0';
+        if (arg == "--frames" && numeric && number > 0) {
+            options.frames = number;
+        } else if (arg == "--batch" && numeric && number > 0) {
+            options.batch = static_cast<size_t>(number);
+        } else if (arg == "--port" && numeric && number > 0 && number < 65536) {
+            options.port = static_cast<int>(number);
+        } else if (arg == "--interface") {
+            options.interfaceName = value;
+        } else {
+            std::cerr << "Invalid option " << arg << " " << value << std::endl;
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+int64_t threadCpuNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+// Raw CAN socket bound to the interface, or -1 (quietly: a missing vcan0 only skips the CAN runs)
+int openCan(const std::string& interfaceName)
+{
+    int fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd < 0) {
+        return -1;
+    }
+    struct ifreq ifr;
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, interfaceName.c_str(), IFNAMSIZ - 1);
+    struct sockaddr_can addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.can_family = AF_CAN;
+    if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0 ||
+        (addr.can_ifindex = ifr.ifr_ifindex,
+         bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// One bus of a run: its socket, batcher and the frame it repeats
+struct Channel
+{
+    std::string name;
+    int fd = -1;
+    struct sockaddr_in destination;
+    bool udp = false;
+    std::vector<uint8_t> frame;
+    std::unique_ptr<FrameBatcher> batcher;
+};
+
+struct RunResult
+{
+    uint64_t sent = 0;
+    uint64_t dropped = 0;
+    uint64_t syscalls = 0;
+    int64_t wallNs = 0;
+    int64_t cpuNs = 0;
+};
+
+class TransportBench
+{
+public:
+    explicit TransportBench(const BenchOptions& options)
+        : m_options(options), m_receiver(-1), m_canAvailable(false), m_uringAvailable(false) {}
+
+    ~TransportBench() {
+        if (m_receiver >= 0) {
+            close(m_receiver);
+        }
+    }
+
+    bool open() {
+        // The loopback receiver keeps UDP datagrams from bouncing with ECONNREFUSED; it is drained
+        // outside the measured sections
+        m_receiver = socket(AF_INET, SOCK_DGRAM, 0);
+        if (m_receiver < 0) {
+            perror("Failed to create UDP receiver");
+            return false;
+        }
+        int bufferSize = 8 * 1024 * 1024;
+        setsockopt(m_receiver, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+        memset(&m_loopback, 0, sizeof(m_loopback));
+        m_loopback.sin_family = AF_INET;
+        m_loopback.sin_port = htons(static_cast<uint16_t>(m_options.port));
+        m_loopback.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(m_receiver, reinterpret_cast<struct sockaddr*>(&m_loopback), sizeof(m_loopback)) < 0) {
+            perror("Failed to bind UDP receiver");
+            return false;
+        }
+
+        int probe = openCan(m_options.interfaceName);
+        m_canAvailable = probe >= 0;
+        if (m_canAvailable) {
+            close(probe);
+        } else {
+            std::cout << "CAN interface " << m_options.interfaceName << " unavailable, skipping CAN runs" << std::endl;
+        }
+
+        UringSender uring;
+        m_uringAvailable = uring.open();
+        if (!m_uringAvailable) {
+            std::cout << "io_uring unavailable, skipping io_uring runs" << std::endl;
+        }
+        return true;
+    }
+
+    void runAll() {
+        std::cout << std::left << std::setw(10) << "buses" << std::setw(10) << "transport" << std::right
+                  << std::setw(12) << "frames/s" << std::setw(12) << "cpu ns/fr" << std::setw(10) << "syscalls"
+                  << std::setw(12) << "frames/call" << std::setw(9) << "dropped" << std::endl;
+        const char* scenarios[] = {"can", "udp", "can+udp"};
+        for (const char* scenario : scenarios) {
+            std::string buses = scenario;
+            if (buses.find("can") != std::string::npos && !m_canAvailable) {
+                continue;
+            }
+            print(buses, "sendmmsg", run(buses, false));
+            if (m_uringAvailable) {
+                print(buses, "io_uring", run(buses, true));
+            }
+        }
+    }
+
+private:
+    std::vector<Channel> makeChannels(const std::string& buses) {
+        std::vector<Channel> channels;
+        if (buses.find("can") != std::string::npos) {
+            Channel can;
+            can.name = "can";
+            can.fd = openCan(m_options.interfaceName);
+            struct can_frame frame;
+            memset(&frame, 0, sizeof(frame));
+            frame.can_id = 0x100;
+            frame.can_dlc = 8;
+            can.frame.assign(reinterpret_cast<uint8_t*>(&frame), reinterpret_cast<uint8_t*>(&frame) + sizeof(frame));
+            can.batcher.reset(new FrameBatcher(sizeof(struct can_frame), m_options.batch));
+            can.batcher->attach(can.fd);
+            channels.push_back(std::move(can));
+        }
+        if (buses.find("udp") != std::string::npos) {
+            Channel udp;
+            udp.name = "udp";
+            udp.udp = true;
+            udp.fd = socket(AF_INET, SOCK_DGRAM, 0);
+            udp.destination = m_loopback;
+            udp.frame.assign(8, 0x5a);
+            udp.batcher.reset(new FrameBatcher(udp.frame.size(), m_options.batch));
+            udp.batcher->attach(udp.fd, reinterpret_cast<const struct sockaddr*>(&udp.destination),
+                                sizeof(udp.destination));
+            channels.push_back(std::move(udp));
+        }
+        return channels;
+    }
+
+    RunResult run(const std::string& buses, bool useUring) {
+        RunResult result;
+        // Declared before the channels so it outlives their batchers
+        UringSender uring;
+        std::vector<Channel> channels = makeChannels(buses);
+        if (useUring) {
+            uring.open();
+            for (Channel& channel : channels) {
+                channel.batcher->useUring(&uring);
+            }
+            uring.registerBuffers();
+        }
+
+        uint64_t batches = (m_options.frames + m_options.batch - 1) / m_options.batch;
+        uint64_t remaining = m_options.frames;
+        for (uint64_t b = 0; b < batches; ++b) {
+            size_t count = static_cast<size_t>(std::min<uint64_t>(remaining, m_options.batch));
+            remaining -= count;
+
+            int64_t wallStart = monotonicNs();
+            int64_t cpuStart = threadCpuNs();
+            for (Channel& channel : channels) {
+                for (size_t i = 0; i < count; ++i) {
+                    channel.batcher->queue(channel.frame.data(), channel.frame.size());
+                }
+                channel.batcher->flush();
+            }
+            uring.submit();
+            result.cpuNs += threadCpuNs() - cpuStart;
+            result.wallNs += monotonicNs() - wallStart;
+
+            drainReceiver();
+        }
+
+        for (Channel& channel : channels) {
+            result.sent += channel.batcher->sentFrames();
+            result.dropped += channel.batcher->droppedFrames();
+            result.syscalls += channel.batcher->flushCalls();
+        }
+        result.syscalls += uring.submitCalls();
+        for (Channel& channel : channels) {
+            channel.batcher.reset();
+            close(channel.fd);
+        }
+        return result;
+    }
+
+    void drainReceiver() {
+        char buffer[64];
+        while (recv(m_receiver, buffer, sizeof(buffer), MSG_DONTWAIT) >= 0) {
+        }
+    }
+
+    void print(const std::string& buses, const char* transport, const RunResult& result) const {
+        double seconds = result.wallNs / 1e9;
+        uint64_t frames = result.sent + result.dropped;
+        std::cout << std::left << std::setw(10) << buses << std::setw(10) << transport << std::right << std::fixed
+                  << std::setprecision(0) << std::setw(12) << (seconds > 0.0 ? result.sent / seconds : 0.0)
+                  << std::setprecision(1) << std::setw(12)
+                  << (frames ? static_cast<double>(result.cpuNs) / frames : 0.0) << std::setw(10) << result.syscalls
+                  << std::setw(12) << (result.syscalls ? static_cast<double>(frames) / result.syscalls : 0.0)
+                  << std::setw(9) << result.dropped << std::endl;
+    }
+
+    BenchOptions m_options;
+    int m_receiver;
+    struct sockaddr_in m_loopback;
+    bool m_canAvailable;
+    bool m_uringAvailable;
+};
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    BenchOptions options;
+    if (!parseBenchOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    TransportBench bench(options);
+    if (!bench.open()) {
+        return 1;
+    }
+    std::cout << options.frames << " frames per bus and run in batches of " << options.batch << std::endl;
+    bench.runAll();
+    return 0;
+}
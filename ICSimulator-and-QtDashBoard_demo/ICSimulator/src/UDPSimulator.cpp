@@ -2,15 +2,17 @@
 #include <iostream>
 #include <cstring>
 #include <unistd.h>
-#include <thread>
-#include <chrono>
 #include <functional>
+#include "PacingEngine.hpp"
+#include "SenderOptions.hpp"
+#include "PayloadCodec.hpp"
+#include "Waveform.hpp"
 #include <arpa/inet.h>
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
 
 // Constructor: Initializes UDP socket and JSON logging
-UDPSimulator::UDPSimulator(const std::string& ip, int port) : m_socket(-1)
+UDPSimulator::UDPSimulator(const std::string& ip, int port) : m_socket(-1), m_format(wire::Format::Ascii)
 {
     m_socket = socket(AF_INET, SOCK_DGRAM, 0);
     if (m_socket < 0) {
@@ -77,10 +79,14 @@ bool UDPSimulator::sendUDPData(float speed, float rpm)
         speed = std::max(0.0f, speed);
         rpm = std::max(0.0f, rpm);
 
-        // Pack data into an 8-byte buffer (4 bytes for speed, 4 bytes for rpm)
-        uint8_t buffer[8];
-        memcpy(buffer, &speed, sizeof(float));     // Bytes 0-3: speed
-        memcpy(buffer + 4, &rpm, sizeof(float));   // Bytes 4-7: rpm
+        // Pack data into an 8-byte ASCII payload or a full binary frame
+        uint8_t buffer[wire::kFullSize];
+        size_t length = payload::kFrameSize;
+        if (m_format == wire::Format::Binary) {
+            length = m_encoder.encodeFull(speed, rpm, buffer);
+        } else {
+            payload::encodeSpeedRpm(speed, rpm, buffer);
+        }
 
         // Log each signal individually
         logSignalToJson("Speed", speed);
@@ -90,7 +96,7 @@ bool UDPSimulator::sendUDPData(float speed, float rpm)
         std::cout << "Sending: Speed=" << speed << ", RPM=" << rpm << std::endl;
 
         // Send the buffer
-         ssize_t sent = sendto(m_socket, buffer, sizeof(buffer), 0,
+         ssize_t sent = sendto(m_socket, buffer, length, 0,
                          (struct sockaddr*)&m_serverAddr, 
                          sizeof(m_serverAddr));
 
@@ -103,39 +109,28 @@ bool UDPSimulator::sendUDPData(float speed, float rpm)
         return true;
 }
 
-// Simulates float data from start to end, with optional reverse direction
-void simulateFloatData(const std::function<void(float, float)>& sendData, float startSpeed, float endSpeed, float startRPM, float endRPM, float stepSpeed, float stepRPM, std::chrono::milliseconds delay, bool reverse = false)
+// Sends the speed/RPM stimulus (signals 0 and 1 of stimulus), one tick of the stimulus per pacer tick,
+// until the pacer stops
+void simulateFloatData(const std::function<void(float, float)>& sendData, WaveformBank& stimulus, PacingEngine& pacer)
 {
-    if (startSpeed < 0 || endSpeed < 0 || startRPM < 0 || endRPM < 0 || stepSpeed <= 0 || stepRPM <= 0)
-    {
-        std::cerr << "Invalid simulation parameters (negative or zero)\n";
-        return;
-    }
-
-    if (!reverse)
+    for (uint64_t tick = 0; pacer.waitNext() >= 0; ++tick)
     {
-        // Forward: start to end
-        for (float speed = startSpeed, rpm = startRPM; speed <= endSpeed && rpm <= endRPM; speed += stepSpeed, rpm += stepRPM)
-        {
-            sendData(std::min(speed, endSpeed), std::min(rpm, endRPM));
-            std::this_thread::sleep_for(delay);
-        }
-    }
-    else
-    {
-        // Reverse: end to start
-        for (float speed = endSpeed, rpm = endRPM; speed >= startSpeed && rpm >= startRPM; speed -= stepSpeed, rpm -= stepRPM)
-        {
-            sendData(std::max(startSpeed, speed), std::max(startRPM, rpm));
-            std::this_thread::sleep_for(delay);
-        }
+        stimulus.generate(tick);
+        sendData(static_cast<float>(stimulus.value(0)), static_cast<float>(stimulus.value(1)));
     }
 }
 
 // Main: Runs simulation loops for combined signals
-int main()
+int main(int argc, char* argv[])
 {
+    SenderOptions options;
+    if (!parseSenderOptions(argc, argv, {"udp"}, options))
+    {
+        return 1;
+    }
+
     UDPSimulator udpSimulator("127.0.0.1", 5000);
+    udpSimulator.setWireFormat(options.wireFor("udp"));
 
     // Calculate proper RPM step to reach 2223 when speed reaches 73
     const float max_speed = 78.0f;
@@ -143,21 +138,24 @@ int main()
     const float speed_step = 5.0f;
     const float rpm_step = (max_rpm / (max_speed / speed_step));
 
-    while (true) {
-        // Simulate speed (0 to 73 km/h) and RPM (0 to 2223) with synchronized steps
-        simulateFloatData(
-            [&udpSimulator](float speed, float rpm) { 
-                udpSimulator.sendUDPData(speed, rpm); 
-            },
-            0.0f, max_speed, 0.0f, max_rpm, speed_step, rpm_step, std::chrono::milliseconds(100)
-        );
-        simulateFloatData(
-            [&udpSimulator](float speed, float rpm) { 
-                udpSimulator.sendUDPData(speed, rpm); 
-            },
-            0.0f, max_speed, 0.0f, max_rpm, speed_step, rpm_step, std::chrono::milliseconds(100), true
-        );
-    }
+    PacingEngine pacer(options.spinUs, options.durationSeconds);
+    pacer.addChannel("udp", options.rateFor("udp"));
+    pacer.stopOnSignals();
 
+    // A triangle of the step sizes is the classic sweep
+    WaveformBank stimulus;
+    if (!makeSpeedRpmStimulus(options.waveform, options.seed, options.rateFor("udp"), max_speed, max_rpm,
+                              speed_step, rpm_step, stimulus))
+    {
+        return 1;
+    }
+    simulateFloatData(
+        [&udpSimulator](float speed, float rpm) {
+            udpSimulator.sendUDPData(speed, rpm);
+        },
+        stimulus, pacer
+    );
+
+    pacer.report(std::cout);
     return 0;
 }
\ No newline at end of file
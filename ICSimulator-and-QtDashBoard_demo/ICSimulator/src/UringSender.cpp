@@ -0,0 +1,288 @@
+#include "UringSender.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "FrameBatcher.hpp"
+
+namespace {
+
+int ioUringSetup(unsigned entries, struct io_uring_params* params)
+{
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, const void* arg, unsigned count)
+{
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+unsigned* ringField(void* ring, uint32_t offset)
+{
+    return reinterpret_cast<unsigned*>(static_cast<char*>(ring) + offset);
+}
+
+} // namespace
+
+UringSender::UringSender(unsigned entries)
+    : m_entries(entries > 0 ? entries : 1),
+      m_fd(-1),
+      m_sqRing(MAP_FAILED),
+      m_sqRingSize(0),
+      m_cqRing(MAP_FAILED),
+      m_cqRingSize(0),
+      m_sqes(MAP_FAILED),
+      m_sqesSize(0),
+      m_sqHead(nullptr),
+      m_sqTail(nullptr),
+      m_sqMask(nullptr),
+      m_sqArray(nullptr),
+      m_cqHead(nullptr),
+      m_cqTail(nullptr),
+      m_cqMask(nullptr),
+      m_cqes(nullptr),
+      m_localTail(0),
+      m_pending(0),
+      m_inFlight(0),
+      m_registered(false),
+      m_submitCalls(0),
+      m_completions(0),
+      m_failed(0),
+      m_lastError(0)
+{
+}
+
+UringSender::~UringSender()
+{
+    submit();
+    close();
+}
+
+bool UringSender::open()
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    m_fd = ioUringSetup(m_entries, &params);
+    if (m_fd < 0) {
+        perror("io_uring_setup");
+        return false;
+    }
+    m_entries = params.sq_entries;
+
+    m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap) {
+        m_sqRingSize = m_cqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+    }
+
+    m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+    if (m_sqRing == MAP_FAILED) {
+        perror("Failed to map io_uring submission ring");
+        close();
+        return false;
+    }
+    if (singleMap) {
+        m_cqRing = m_sqRing;
+    } else {
+        m_cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+        if (m_cqRing == MAP_FAILED) {
+            perror("Failed to map io_uring completion ring");
+            close();
+            return false;
+        }
+    }
+    m_sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    m_sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+    if (m_sqes == MAP_FAILED) {
+        perror("Failed to map io_uring submission entries");
+        close();
+        return false;
+    }
+
+    m_sqHead = ringField(m_sqRing, params.sq_off.head);
+    m_sqTail = ringField(m_sqRing, params.sq_off.tail);
+    m_sqMask = ringField(m_sqRing, params.sq_off.ring_mask);
+    m_sqArray = ringField(m_sqRing, params.sq_off.array);
+    m_cqHead = ringField(m_cqRing, params.cq_off.head);
+    m_cqTail = ringField(m_cqRing, params.cq_off.tail);
+    m_cqMask = ringField(m_cqRing, params.cq_off.ring_mask);
+    m_cqes = static_cast<char*>(m_cqRing) + params.cq_off.cqes;
+    m_localTail = *m_sqTail;
+    return true;
+}
+
+int UringSender::addBuffer(void* base, size_t length)
+{
+    m_buffers.push_back({base, length});
+    return static_cast<int>(m_buffers.size() - 1);
+}
+
+bool UringSender::registerBuffers()
+{
+    if (m_fd < 0 || m_buffers.empty()) {
+        return false;
+    }
+    if (ioUringRegister(m_fd, IORING_REGISTER_BUFFERS, m_buffers.data(), static_cast<unsigned>(m_buffers.size())) < 0) {
+        perror("Failed to register io_uring buffers, using unregistered writes");
+        return false;
+    }
+    m_registered = true;
+    return true;
+}
+
+void UringSender::stage(FrameBatcher& batcher, size_t count)
+{
+    // Unconnected UDP needs the destination of each message: send the prepared msghdr like sendmmsg does
+    bool withDestination = batcher.m_destinationLength > 0;
+    bool fixed = m_registered && batcher.m_uringBuffer >= 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (m_pending == m_entries) {
+            submit();
+        }
+
+        unsigned index = m_localTail & *m_sqMask;
+        struct io_uring_sqe* sqe = static_cast<struct io_uring_sqe*>(m_sqes) + index;
+        memset(sqe, 0, sizeof(*sqe));
+        sqe->fd = batcher.m_fd;
+        if (withDestination) {
+            sqe->opcode = IORING_OP_SENDMSG;
+            sqe->addr = reinterpret_cast<uint64_t>(&batcher.m_messages[i].msg_hdr);
+            sqe->len = 1;
+        } else {
+            sqe->opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+            sqe->addr = reinterpret_cast<uint64_t>(batcher.m_iovecs[i].iov_base);
+            sqe->len = static_cast<uint32_t>(batcher.m_iovecs[i].iov_len);
+            sqe->buf_index = static_cast<uint16_t>(fixed ? batcher.m_uringBuffer : 0);
+        }
+        sqe->user_data = reinterpret_cast<uint64_t>(&batcher);
+        m_sqArray[index] = index;
+        ++m_localTail;
+        ++m_pending;
+        ++batcher.m_staged;
+    }
+}
+
+bool UringSender::submit()
+{
+    if (m_pending == 0 && m_inFlight == 0) {
+        return true;
+    }
+    uint64_t failedBefore = m_failed;
+    // Release: the kernel must see the entries before the new tail
+    __atomic_store_n(m_sqTail, m_localTail, __ATOMIC_RELEASE);
+    while (m_pending > 0 || m_inFlight > 0) {
+        // The kernel stops at an entry that fails before being issued (it completes with the error) and then
+        // returns without waiting, so waiting for every staged request never waits for entries left in the ring
+        unsigned toSubmit = static_cast<unsigned>(m_pending);
+        int submitted = enter(toSubmit, toSubmit + static_cast<unsigned>(m_inFlight));
+        if (submitted < 0) {
+            dropPending();
+            return false;
+        }
+        m_pending -= static_cast<size_t>(submitted);
+        m_inFlight += static_cast<size_t>(submitted);
+        m_inFlight -= std::min<size_t>(m_inFlight, reap());
+    }
+    return m_failed == failedBefore;
+}
+
+int UringSender::enter(unsigned toSubmit, unsigned waitFor)
+{
+    while (true) {
+        int result = ioUringEnter(m_fd, toSubmit, waitFor, IORING_ENTER_GETEVENTS);
+        ++m_submitCalls;
+        if (result >= 0) {
+            return result;
+        }
+        if (errno == EINTR) {
+            // The entries were not consumed if the call was interrupted before submitting them
+            continue;
+        }
+        if (errno == EAGAIN || errno == EBUSY) {
+            // Completion queue pressure: the caller reaps and retries
+            return 0;
+        }
+        perror("io_uring_enter");
+        return -1;
+    }
+}
+
+unsigned UringSender::reap()
+{
+    unsigned head = *m_cqHead;
+    unsigned tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+    unsigned reaped = 0;
+    for (; head != tail; ++head, ++reaped) {
+        const struct io_uring_cqe& cqe = static_cast<const struct io_uring_cqe*>(m_cqes)[head & *m_cqMask];
+        FrameBatcher* batcher = reinterpret_cast<FrameBatcher*>(cqe.user_data);
+        if (cqe.res < 0) {
+            ++m_failed;
+            m_lastError = -cqe.res;
+            ++batcher->m_dropped;
+        } else {
+            ++batcher->m_sent;
+        }
+        // The kernel is done with the buffer; the batcher may reuse it once all its frames are back
+        --batcher->m_staged;
+    }
+    m_completions += reaped;
+    __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+    return reaped;
+}
+
+void UringSender::dropPending()
+{
+    // Without SQPOLL the kernel only reads the submission queue inside io_uring_enter, so the tail can move back
+    for (unsigned tail = m_localTail - static_cast<unsigned>(m_pending); tail != m_localTail; ++tail) {
+        const struct io_uring_sqe& sqe = static_cast<const struct io_uring_sqe*>(m_sqes)[m_sqArray[tail & *m_sqMask]];
+        FrameBatcher* batcher = reinterpret_cast<FrameBatcher*>(sqe.user_data);
+        ++batcher->m_dropped;
+        --batcher->m_staged;
+        ++m_failed;
+    }
+    m_localTail -= static_cast<unsigned>(m_pending);
+    m_pending = 0;
+    __atomic_store_n(m_sqTail, m_localTail, __ATOMIC_RELEASE);
+}
+
+void UringSender::report(std::ostream& out) const
+{
+    double perCall = m_submitCalls ? static_cast<double>(m_completions) / m_submitCalls : 0.0;
+    out << "  io_uring: " << m_completions << " writes in " << m_submitCalls << " io_uring_enter calls (" << perCall
+        << " per call), " << (m_registered ? "registered" : "unregistered") << " buffers, " << m_failed
+        << " failed completions";
+    if (m_failed > 0) {
+        out << " (last: " << strerror(m_lastError) << ")";
+    }
+    out << std::endl;
+}
+
+void UringSender::close()
+{
+    if (m_sqes != MAP_FAILED) {
+        munmap(m_sqes, m_sqesSize);
+        m_sqes = MAP_FAILED;
+    }
+    if (m_cqRing != MAP_FAILED && m_cqRing != m_sqRing) {
+        munmap(m_cqRing, m_cqRingSize);
+    }
+    m_cqRing = MAP_FAILED;
+    if (m_sqRing != MAP_FAILED) {
+        munmap(m_sqRing, m_sqRingSize);
+        m_sqRing = MAP_FAILED;
+    }
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
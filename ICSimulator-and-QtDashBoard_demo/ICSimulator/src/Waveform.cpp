@@ -0,0 +1,252 @@
+#include "Waveform.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// 2^52: adding and subtracting it rounds a smaller non-negative double to an integer
+constexpr double kRoundBias = 4503599627370496.0;
+
+// floor() of 0 <= x < 2^52 without libm, so loops using it vectorize even on baseline SSE2
+inline double floorNonNegative(double x)
+{
+    double rounded = (x + kRoundBias) - kRoundBias;
+    return rounded - static_cast<double>(rounded > x);
+}
+
+// sin(v) for 0 <= v <= pi/2, Taylor series to v^11 (error below 4e-8)
+inline double sinQuarter(double v)
+{
+    double v2 = v * v;
+    return v * (1.0 + v2 * (-1.0 / 6.0 + v2 * (1.0 / 120.0 + v2 * (-1.0 / 5040.0 +
+                v2 * (1.0 / 362880.0 + v2 * (-1.0 / 39916800.0))))));
+}
+
+// SplitMix64 finalizer: a fixed bijective hash, identical on every platform
+inline uint64_t mix64(uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+} // namespace
+
+bool parseWaveform(const std::string& name, Waveform& shape)
+{
+    static const struct {
+        const char* name;
+        Waveform shape;
+    } kNames[] = {
+        {"ramp", Waveform::Ramp}, {"triangle", Waveform::Triangle}, {"sine", Waveform::Sine},
+        {"step", Waveform::Step}, {"noise", Waveform::Noise},
+    };
+    for (const auto& entry : kNames) {
+        if (name == entry.name) {
+            shape = entry.shape;
+            return true;
+        }
+    }
+    return false;
+}
+
+WaveformBank::WaveformBank(uint64_t seed)
+    : m_seed(seed)
+{
+}
+
+int WaveformBank::add(const WaveformSpec& spec)
+{
+    int slot = static_cast<int>(m_values.size());
+    m_values.push_back(spec.minimum);
+    double span = spec.maximum - spec.minimum;
+
+    if (spec.shape == Waveform::Piecewise) {
+        std::vector<WaveformPoint> points = spec.points;
+        if (points.size() < 2 || points.back().time <= points.front().time) {
+            // Nothing to interpolate: hold the first value (or the minimum)
+            double value = points.empty() ? 0.0 : points.front().value;
+            points.assign({{0.0, value}, {1.0, value}});
+        }
+        double length = points.back().time - points.front().time;
+        m_profiles.push_back(Profile{slot, spec.minimum, span, spec.phase * length, std::move(points), 0});
+        return slot;
+    }
+
+    double period = std::max(spec.periodTicks, 1e-9);
+    Group& group = m_groups[static_cast<size_t>(spec.shape)];
+    group.slots.push_back(slot);
+    group.minimum.push_back(spec.minimum);
+    group.span.push_back(span);
+    group.offset.push_back(spec.phase * period);
+    group.invPeriod.push_back(1.0 / period);
+    group.duty.push_back(spec.duty);
+    // Stream of this signal: depends on the seed and its index only
+    group.key.push_back(mix64(m_seed ^ mix64(static_cast<uint64_t>(slot) + 0x9e3779b97f4a7c15ull)));
+    group.result.push_back(0.0);
+    return slot;
+}
+
+void WaveformBank::generate(uint64_t tick)
+{
+    double t = static_cast<double>(tick);
+    for (size_t shape = 0; shape < kGroupCount; ++shape) {
+        Group& group = m_groups[shape];
+        if (group.slots.empty()) {
+            continue;
+        }
+        generateGroup(static_cast<Waveform>(shape), group, t);
+        for (size_t i = 0; i < group.slots.size(); ++i) {
+            m_values[group.slots[i]] = group.result[i];
+        }
+    }
+    for (Profile& profile : m_profiles) {
+        m_values[profile.slot] = profileValue(profile, t);
+    }
+}
+
+void WaveformBank::generateBlock(uint64_t firstTick, size_t ticks, double* out)
+{
+    for (size_t k = 0; k < ticks; ++k) {
+        generate(firstTick + k);
+        std::copy(m_values.begin(), m_values.end(), out + k * m_values.size());
+    }
+}
+
+void WaveformBank::generateGroup(Waveform shape, Group& group, double tick)
+{
+    const size_t count = group.slots.size();
+    const double* __restrict minimum = group.minimum.data();
+    const double* __restrict span = group.span.data();
+    const double* __restrict offset = group.offset.data();
+    const double* __restrict invPeriod = group.invPeriod.data();
+    const double* __restrict duty = group.duty.data();
+    double* __restrict result = group.result.data();
+
+    // One loop per shape, so each loop body is branch-free and vectorizes
+    switch (shape) {
+    case Waveform::Ramp:
+        for (size_t i = 0; i < count; ++i) {
+            double cycles = (tick + offset[i]) * invPeriod[i];
+            result[i] = minimum[i] + span[i] * (cycles - floorNonNegative(cycles));
+        }
+        break;
+    case Waveform::Triangle:
+        for (size_t i = 0; i < count; ++i) {
+            double cycles = (tick + offset[i]) * invPeriod[i];
+            double position = cycles - floorNonNegative(cycles);
+            result[i] = minimum[i] + span[i] * (1.0 - std::fabs(2.0 * position - 1.0));
+        }
+        break;
+    case Waveform::Sine:
+        for (size_t i = 0; i < count; ++i) {
+            double cycles = (tick + offset[i]) * invPeriod[i];
+            double position = cycles - floorNonNegative(cycles);
+            // (1 - cos(2 pi p)) / 2 = sin^2(pi p), and sin(pi p) = sin(pi h) with h folded into [0, 1/2]
+            double s = sinQuarter(kPi * (0.5 - std::fabs(position - 0.5)));
+            result[i] = minimum[i] + span[i] * (s * s);
+        }
+        break;
+    case Waveform::Step:
+        for (size_t i = 0; i < count; ++i) {
+            double cycles = (tick + offset[i]) * invPeriod[i];
+            double position = cycles - floorNonNegative(cycles);
+            result[i] = minimum[i] + span[i] * static_cast<double>(position < duty[i]);
+        }
+        break;
+    case Waveform::Noise:
+        // 64-bit multiplies do not vectorize before AVX-512; still a few ns per signal
+        for (size_t i = 0; i < count; ++i) {
+            uint64_t interval = static_cast<uint64_t>(floorNonNegative((tick + offset[i]) * invPeriod[i]));
+            uint64_t bits = mix64(group.key[i] + interval * 0x9e3779b97f4a7c15ull);
+            result[i] = minimum[i] + span[i] * (static_cast<double>(bits >> 11) * (1.0 / 9007199254740992.0));
+        }
+        break;
+    case Waveform::Piecewise:
+        break;
+    }
+}
+
+double WaveformBank::profileValue(Profile& profile, double tick)
+{
+    const std::vector<WaveformPoint>& points = profile.points;
+    double start = points.front().time;
+    double length = points.back().time - start;
+    double cycles = (tick + profile.offset) / length;
+    double time = start + (cycles - floorNonNegative(cycles)) * length;
+
+    // Ticks mostly move forward, so continue from the last segment
+    size_t& segment = profile.cursor;
+    if (segment + 1 >= points.size() || time < points[segment].time) {
+        segment = 0;
+    }
+    while (segment + 2 < points.size() && time >= points[segment + 1].time) {
+        ++segment;
+    }
+
+    const WaveformPoint& a = points[segment];
+    const WaveformPoint& b = points[segment + 1];
+    double fraction = b.time > a.time ? (time - a.time) / (b.time - a.time) : 0.0;
+    return profile.minimum + profile.span * (a.value + (b.value - a.value) * fraction);
+}
+
+bool WaveformBank::loadProfile(const std::string& path, double ticksPerSecond, std::vector<WaveformPoint>& points)
+{
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open waveform profile " << path << std::endl;
+        return false;
+    }
+
+    points.clear();
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        WaveformPoint point;
+        if (!(fields >> point.time)) {
+            continue;
+        }
+        if (!(fields >> point.value) || point.time < 0.0 ||
+            (!points.empty() && point.time * ticksPerSecond <= points.back().time)) {
+            std::cerr << path << ":" << lineNumber << ": expected \"seconds fraction\" with increasing times" << std::endl;
+            return false;
+        }
+        point.time *= ticksPerSecond;
+        points.push_back(point);
+    }
+    if (points.size() < 2) {
+        std::cerr << "Waveform profile " << path << " needs at least two points" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool makeSpeedRpmStimulus(const std::string& waveform, uint64_t seed, double ticksPerSecond, double maxSpeed,
+                          double maxRpm, double speedStep, double rpmStep, WaveformBank& stimulus)
+{
+    WaveformSpec speed;
+    if (!parseWaveform(waveform, speed.shape)) {
+        speed.shape = Waveform::Piecewise;
+        if (!WaveformBank::loadProfile(waveform, ticksPerSecond, speed.points)) {
+            return false;
+        }
+    }
+    WaveformSpec rpm = speed;
+    speed.maximum = maxSpeed;
+    speed.periodTicks = 2.0 * maxSpeed / speedStep;
+    rpm.maximum = maxRpm;
+    rpm.periodTicks = 2.0 * maxRpm / rpmStep;
+
+    stimulus = WaveformBank(seed);
+    stimulus.add(speed);
+    stimulus.add(rpm);
+    return true;
+}
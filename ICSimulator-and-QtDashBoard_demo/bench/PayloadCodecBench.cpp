@@ -0,0 +1,152 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "PayloadCodec.hpp"
+
+// Factors by which the codec must beat the legacy string code measured in the same run. A ratio within one
+// run depends far less on the machine and its load than a fixed time; on x86-64 the codec measures 70x to
+// 100x ahead encoding and 4.4x to 9x decoding, and the floors stay well below the slowest runs.
+static constexpr double kMinEncodeSpeedup = 30.0;
+static constexpr double kMinDecodeSpeedup = 3.0;
+
+// Distinct frames cycled through so the branch predictor cannot memorise a single input
+static constexpr size_t kFrameCount = 4096;
+
+// Frames encoded/decoded per measurement of the codec and of the legacy code
+static constexpr size_t kIterations = 20000000;
+static constexpr size_t kLegacyIterations = 1000000;
+
+// Prevents the compiler from discarding the measured work
+static volatile uint64_t g_sink;
+
+// Returns the nanoseconds per frame spent in body(i) over iterations calls
+template <typename Body>
+double measure(Body body, size_t iterations = kIterations)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        body(i);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+// Encoder the senders used before PayloadCodec.hpp
+void legacyEncode(float speed, float rpm, uint8_t *out)
+{
+    std::ostringstream speedStream, rpmStream;
+    speedStream << std::fixed << std::setprecision(1) << speed;
+    rpmStream << std::fixed << std::setprecision(0) << rpm;
+
+    std::string speedStr = speedStream.str();
+    std::string rpmStr = rpmStream.str();
+
+    speedStr = (speedStr.size() > 4 ? speedStr.substr(0, 4) : speedStr + std::string(4 - speedStr.size(), ' '));
+    rpmStr = (rpmStr.size() > 4 ? rpmStr.substr(0, 4) : rpmStr + std::string(4 - rpmStr.size(), ' '));
+
+    memcpy(out, speedStr.c_str(), 4);
+    memcpy(out + 4, rpmStr.c_str(), 4);
+}
+
+// Stand-in for the receivers' former QByteArray -> QString -> toFloat/toInt chain, without Qt
+bool legacyDecode(const uint8_t *frame, float &speed, int &rpm)
+{
+    std::string data(reinterpret_cast<const char *>(frame), payload::kFrameSize);
+    try
+    {
+        speed = std::stof(data.substr(0, 4));
+        rpm = std::stoi(data.substr(4, 4));
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    // Optional absolute budget for runs on a known, quiet target; without it the timings are only reported
+    double budgetNs = argc > 1 ? atof(argv[1]) : 0.0;
+
+    // Same value ranges as the simulators: 0-150 m/s speed, 0-8000 RPM
+    std::vector<float> speeds(kFrameCount), rpms(kFrameCount);
+    std::vector<uint8_t> frames(kFrameCount * payload::kFrameSize);
+    srand(42);
+    for (size_t i = 0; i < kFrameCount; ++i)
+    {
+        speeds[i] = static_cast<float>(rand()) / RAND_MAX * 150.0f;
+        rpms[i] = static_cast<float>(rand()) / RAND_MAX * 8000.0f;
+        payload::encodeSpeedRpm(speeds[i], rpms[i], &frames[i * payload::kFrameSize]);
+    }
+
+    double encodeNs = measure([&](size_t i) {
+        size_t index = i & (kFrameCount - 1);
+        uint8_t out[payload::kFrameSize];
+        payload::encodeSpeedRpm(speeds[index], rpms[index], out);
+        uint64_t word;
+        memcpy(&word, out, sizeof(word));
+        g_sink = g_sink + word;
+    });
+
+    size_t failures = 0;
+    double decodeNs = measure([&](size_t i) {
+        size_t index = i & (kFrameCount - 1);
+        float speed = 0.0f;
+        int rpm = 0;
+        if (!payload::decodeSpeedRpm(&frames[index * payload::kFrameSize], speed, rpm))
+        {
+            ++failures;
+        }
+        g_sink = g_sink + static_cast<uint64_t>(speed) + static_cast<uint64_t>(rpm);
+    });
+
+    double legacyEncodeNs = measure([&](size_t i) {
+        size_t index = i & (kFrameCount - 1);
+        uint8_t out[payload::kFrameSize];
+        legacyEncode(speeds[index], rpms[index], out);
+        uint64_t word;
+        memcpy(&word, out, sizeof(word));
+        g_sink = g_sink + word;
+    }, kLegacyIterations);
+
+    double legacyDecodeNs = measure([&](size_t i) {
+        size_t index = i & (kFrameCount - 1);
+        float speed = 0.0f;
+        int rpm = 0;
+        legacyDecode(&frames[index * payload::kFrameSize], speed, rpm);
+        g_sink = g_sink + static_cast<uint64_t>(speed) + static_cast<uint64_t>(rpm);
+    }, kLegacyIterations);
+
+    double encodeSpeedup = legacyEncodeNs / encodeNs;
+    double decodeSpeedup = legacyDecodeNs / decodeNs;
+    std::cout << "encode: " << encodeNs << " ns/frame (legacy " << legacyEncodeNs << ", " << encodeSpeedup << "x)"
+              << std::endl;
+    std::cout << "decode: " << decodeNs << " ns/frame (legacy " << legacyDecodeNs << ", " << decodeSpeedup << "x)"
+              << std::endl;
+
+    if (failures != 0)
+    {
+        std::cerr << failures << " frames failed to decode" << std::endl;
+        return 1;
+    }
+    if (encodeSpeedup < kMinEncodeSpeedup || decodeSpeedup < kMinDecodeSpeedup)
+    {
+        std::cerr << "Codec is less than " << kMinEncodeSpeedup << "x (encode) / " << kMinDecodeSpeedup
+                  << "x (decode) faster than the legacy string code" << std::endl;
+        return 1;
+    }
+    if (budgetNs > 0.0 && (encodeNs > budgetNs || decodeNs > budgetNs))
+    {
+        std::cerr << "Codec exceeds the " << budgetNs << " ns/frame budget" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,93 @@
+#ifndef MULTICAST_HPP
+#define MULTICAST_HPP
+
+// IPv4 multicast setup of the datagram transports (UDP, FlexRay-over-UDP), shared by the ICSimulator
+// senders and the Dashboard receivers.
+//
+// A sender whose destination is a multicast group sends every frame once, whatever the number of
+// Dashboards listening; the switch (or the loopback device) copies it to every member. Receivers bind the
+// group and port with SO_REUSEADDR and SO_REUSEPORT, so several Dashboards on one host each get a copy,
+// and join the group on the interface of their own address.
+//
+// The functions only configure the socket and return false with errno set; callers report errors in
+// their own way.
+
+#include <cstdint>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace mcast {
+
+// Frames stay on the local subnet unless a larger TTL is asked for
+constexpr int kDefaultTtl = 1;
+
+// Parses a dotted IPv4 address; an empty text gives INADDR_ANY
+inline bool parseAddress(const char *text, struct in_addr &address)
+{
+    if (text == nullptr || *text == '\0')
+    {
+        address.s_addr = htonl(INADDR_ANY);
+        return true;
+    }
+    return inet_pton(AF_INET, text, &address) == 1;
+}
+
+// True for 224.0.0.0/4
+inline bool isMulticast(const struct in_addr &address)
+{
+    return IN_MULTICAST(ntohl(address.s_addr));
+}
+
+// Sets the TTL and loopback of the frames a socket sends to a group, and the interface they leave by
+// (INADDR_ANY: the one the routing table picks)
+inline bool configureSender(int fd, int ttl, const struct in_addr &interfaceAddress, bool loopback = true)
+{
+    unsigned char ttlValue = static_cast<unsigned char>(ttl < 0 ? 0 : (ttl > 255 ? 255 : ttl));
+    unsigned char loopValue = loopback ? 1 : 0;
+    if (setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttlValue, sizeof(ttlValue)) < 0 ||
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loopValue, sizeof(loopValue)) < 0)
+    {
+        return false;
+    }
+    if (interfaceAddress.s_addr != htonl(INADDR_ANY) &&
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &interfaceAddress, sizeof(interfaceAddress)) < 0)
+    {
+        return false;
+    }
+    return true;
+}
+
+// Binds a socket to group:port, shareable by other receivers on the host, and joins the group on the
+// interface with the given address (INADDR_ANY: the one the routing table picks)
+inline bool bindReceiver(int fd, const struct in_addr &group, uint16_t port, const struct in_addr &interfaceAddress)
+{
+    int enable = 1;
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) < 0 ||
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) < 0)
+    {
+        return false;
+    }
+
+    // Binding the group rather than INADDR_ANY keeps unicast traffic to the same port out of the socket
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr = group;
+    if (bind(fd, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) < 0)
+    {
+        return false;
+    }
+
+    struct ip_mreq membership;
+    memset(&membership, 0, sizeof(membership));
+    membership.imr_multiaddr = group;
+    membership.imr_interface = interfaceAddress;
+    return setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &membership, sizeof(membership)) == 0;
+}
+
+} // namespace mcast
+
+#endif // MULTICAST_HPP
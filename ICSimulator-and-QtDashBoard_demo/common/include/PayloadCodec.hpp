@@ -0,0 +1,294 @@
+#ifndef PAYLOADCODEC_HPP
+#define PAYLOADCODEC_HPP
+
+// Fixed-width ASCII speed/RPM payload shared by the senders and the Dashboard receivers.
+//
+// Layout (8 bytes): bytes 0-3 speed with one decimal, bytes 4-7 RPM with no decimals. Each field is
+// left-aligned, space-padded and cut to 4 characters, e.g. "12.5" "850 ", "100." "8000".
+//
+// Both directions work on caller-provided byte spans and never allocate. The decoder validates all
+// eight bytes at once with SWAR (SIMD within a 64-bit register) before parsing the two fields.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+namespace payload {
+
+constexpr size_t kFieldWidth = 4;
+constexpr size_t kFrameSize = 2 * kFieldWidth;
+
+namespace detail {
+
+constexpr uint64_t kOnes = 0x0101010101010101ull;
+constexpr uint64_t kHighBits = 0x8080808080808080ull;
+constexpr uint64_t kLowBits = 0x7F7F7F7F7F7F7F7Full;
+
+// Powers of ten indexed by the number of fraction digits a field can hold
+constexpr double kPow10[kFieldWidth] = {1.0, 10.0, 100.0, 1000.0};
+
+// Sets the high bit of every byte of x that is zero
+inline uint64_t zeroBytes(uint64_t x)
+{
+    return ~(((x & kLowBits) + kLowBits) | x | kLowBits);
+}
+
+// Sets the high bit of every byte of x that equals c
+inline uint64_t bytesEqual(uint64_t x, uint8_t c)
+{
+    return zeroBytes(x ^ (kOnes * c));
+}
+
+// Sets the high bit of every byte of x that is an ASCII digit
+inline uint64_t digitBytes(uint64_t x)
+{
+    uint64_t highNibbleIs3 = zeroBytes((x & (kOnes * 0xF0)) ^ (kOnes * 0x30));
+    // Low nibble < 10 <=> low nibble + 6 does not reach 16; bytes cannot carry into each other here
+    uint64_t lowNibbleBelow10 = ~(((x & (kOnes * 0x0F)) + (kOnes * 0x06)) << 3) & kHighBits;
+    return highNibbleIs3 & lowNibbleBelow10;
+}
+
+constexpr uint64_t kSpeedField = 0x0000000080808080ull;
+constexpr uint64_t kRpmField = 0x8080808000000000ull;
+constexpr uint64_t kFieldStarts = 0x0000008000000080ull;
+
+// True if both fields are "digits[.digits]" followed only by padding: no sign, no leading spaces, at
+// most one dot in speed, none in rpm and at least one digit each. This covers everything the encoder
+// produces for non-negative values. Works on the per-byte high-bit masks of the payload.
+inline bool isPlainPayload(uint64_t digits, uint64_t dots, uint64_t spaces)
+{
+    uint64_t nonSpaces = ~spaces & kHighBits;
+    uint64_t speedDots = dots & kSpeedField;
+    // A space followed by a non-space inside the same field means the padding is not a suffix
+    bool paddingIsSuffix = ((spaces << 8) & nonSpaces & ~(kFieldStarts & kRpmField)) == 0;
+    return (digits | dots | spaces) == kHighBits && paddingIsSuffix && (nonSpaces & kFieldStarts) == kFieldStarts &&
+           (speedDots & (speedDots - 1)) == 0 && (dots & kRpmField) == 0 && (digits & kSpeedField) != 0;
+}
+
+// Accumulates a plain field without branches
+inline void accumulatePlainField(const uint8_t *field, int32_t &mantissa, int &fractionDigits)
+{
+    int32_t value = 0;
+    int fraction = 0;
+    int seenDot = 0;
+    for (size_t i = 0; i < kFieldWidth; ++i)
+    {
+        unsigned digit = static_cast<unsigned>(field[i]) - '0';
+        int isDigit = digit < 10;
+        value = isDigit ? value * 10 + static_cast<int32_t>(digit) : value;
+        fraction += isDigit & seenDot;
+        seenDot |= field[i] == '.';
+    }
+    mantissa = value;
+    fractionDigits = fraction;
+}
+
+// Parses one field as "[spaces][sign]digits[.digits][spaces]" with the same acceptance rules as
+// QString::toFloat / QString::toInt for this alphabet. Returns false on any other layout.
+inline bool parseField(const uint8_t *field, bool allowFraction, int32_t &mantissa, int &fractionDigits)
+{
+    size_t i = 0;
+    while (i < kFieldWidth && field[i] == ' ')
+    {
+        ++i;
+    }
+
+    bool negative = false;
+    if (i < kFieldWidth && (field[i] == '-' || field[i] == '+'))
+    {
+        negative = field[i] == '-';
+        ++i;
+    }
+
+    int32_t value = 0;
+    int digits = 0;
+    int fraction = 0;
+    bool seenDot = false;
+    for (; i < kFieldWidth; ++i)
+    {
+        uint8_t c = field[i];
+        if (c >= '0' && c <= '9')
+        {
+            value = value * 10 + (c - '0');
+            ++digits;
+            fraction += seenDot;
+        }
+        else if (c == '.' && allowFraction && !seenDot)
+        {
+            seenDot = true;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    // Only trailing padding may follow the number
+    for (; i < kFieldWidth; ++i)
+    {
+        if (field[i] != ' ')
+        {
+            return false;
+        }
+    }
+    if (digits == 0)
+    {
+        return false;
+    }
+
+    mantissa = negative ? -value : value;
+    fractionDigits = fraction;
+    return true;
+}
+
+// Adding and subtracting 2^52 rounds a non-negative double below 2^52 to an integer, half-to-even,
+// which is what printf does; values at or above kRoundLimit take the snprintf path instead
+constexpr double kRoundShift = 4503599627370496.0;
+constexpr double kRoundLimit = 1e15;
+
+// Rare path for huge and non-finite values: let printf produce the same text std::ostream would
+inline void formatWide(double value, int decimals, uint8_t *field)
+{
+    char text[512];
+    int length = snprintf(text, sizeof(text), "%.*f", decimals, value);
+    for (size_t i = 0; i < kFieldWidth; ++i)
+    {
+        field[i] = static_cast<int>(i) < length ? static_cast<uint8_t>(text[i]) : ' ';
+    }
+}
+
+// Writes value rounded to the given number of decimals in fixed notation into a 4-character,
+// space-padded field. Negative values that round to zero keep their sign ("-0.0"), as with printf.
+inline void formatField(double value, int decimals, uint8_t *field)
+{
+    double scaled = std::fabs(value) * kPow10[decimals]; // Exact for float inputs
+    if (!(scaled < kRoundLimit))
+    {
+        formatWide(value, decimals, field);
+        return;
+    }
+    uint64_t magnitude = static_cast<uint64_t>((scaled + kRoundShift) - kRoundShift);
+
+    // Emit digits least significant first, inserting the decimal point
+    char digits[24];
+    size_t length = 0;
+    int emitted = 0;
+    do
+    {
+        if (decimals > 0 && emitted == decimals)
+        {
+            digits[length++] = '.';
+        }
+        digits[length++] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+        ++emitted;
+    } while (magnitude != 0 || emitted <= decimals);
+    if (std::signbit(value))
+    {
+        digits[length++] = '-';
+    }
+
+    for (size_t i = 0; i < kFieldWidth; ++i)
+    {
+        field[i] = i < length ? static_cast<uint8_t>(digits[length - 1 - i]) : ' ';
+    }
+}
+
+// Stores the low 4 bytes of a little-endian packed string
+inline void storeField(uint64_t packed, uint8_t *field)
+{
+    for (size_t i = 0; i < kFieldWidth; ++i)
+    {
+        field[i] = static_cast<uint8_t>(packed >> (8 * i));
+    }
+}
+
+// Writes speed with one decimal. Fast path for 0 <= speed < 999.95, the sender range.
+inline void formatSpeedField(float speed, uint8_t *field)
+{
+    double scaled = static_cast<double>(speed) * 10.0;
+    if (!(scaled >= 0.0 && scaled < 9999.5) || std::signbit(speed))
+    {
+        formatField(speed, 1, field);
+        return;
+    }
+    uint32_t tenths = static_cast<uint32_t>((scaled + kRoundShift) - kRoundShift);
+    uint32_t whole = tenths / 10;
+
+    // Build "hte.f" plus padding, then drop leading zeros of the integer part (keeping one)
+    uint64_t packed = ('0' + whole / 100) | ('0' + whole / 10 % 10) << 8 | ('0' + whole % 10) << 16 | uint64_t('.') << 24 |
+                      uint64_t('0' + tenths % 10) << 32 | 0x202020ull << 40;
+    unsigned leadingZeros = (whole < 100) + (whole < 10);
+    storeField(packed >> (8 * leadingZeros), field);
+}
+
+// Writes rpm with no decimals. Fast path for 0 <= rpm < 9999.5, the sender range.
+inline void formatRpmField(float rpm, uint8_t *field)
+{
+    double value = static_cast<double>(rpm);
+    if (!(value >= 0.0 && value < 9999.5) || std::signbit(rpm))
+    {
+        formatField(rpm, 0, field);
+        return;
+    }
+    uint32_t whole = static_cast<uint32_t>((value + kRoundShift) - kRoundShift);
+
+    uint64_t packed = ('0' + whole / 1000) | ('0' + whole / 100 % 10) << 8 | ('0' + whole / 10 % 10) << 16 |
+                      uint64_t('0' + whole % 10) << 24 | 0x20202020ull << 32;
+    unsigned leadingZeros = (whole < 1000) + (whole < 100) + (whole < 10);
+    storeField(packed >> (8 * leadingZeros), field);
+}
+
+} // namespace detail
+
+// Encodes speed (one decimal) and rpm (no decimals) into an 8-byte payload. Produces the same bytes as
+// std::fixed with setprecision(1)/(0) followed by substr/padding to 4 characters.
+inline void encodeSpeedRpm(float speed, float rpm, uint8_t *out)
+{
+    detail::formatSpeedField(speed, out);
+    detail::formatRpmField(rpm, out + kFieldWidth);
+}
+
+// Decodes an 8-byte payload into speed and rpm. Returns false if either field is not a number, in which
+// case the outputs are left unchanged. Fields may carry leading/trailing spaces and a sign, as accepted by
+// QString::toFloat/toInt; "nan", "inf" and exponents are rejected.
+inline bool decodeSpeedRpm(const uint8_t *in, float &speed, int &rpm)
+{
+    uint64_t x;
+    memcpy(&x, in, sizeof(x));
+    uint64_t digits = detail::digitBytes(x);
+    uint64_t dots = detail::bytesEqual(x, '.');
+    uint64_t spaces = detail::bytesEqual(x, ' ');
+
+    int32_t speedMantissa;
+    int speedFraction;
+    int32_t rpmValue;
+    int rpmFraction;
+    if (detail::isPlainPayload(digits, dots, spaces))
+    {
+        // Fast path: everything the senders emit
+        detail::accumulatePlainField(in, speedMantissa, speedFraction);
+        detail::accumulatePlainField(in + kFieldWidth, rpmValue, rpmFraction);
+    }
+    else
+    {
+        uint64_t signs = detail::bytesEqual(x, '-') | detail::bytesEqual(x, '+');
+        if ((digits | dots | spaces | signs) != detail::kHighBits ||
+            !detail::parseField(in, true, speedMantissa, speedFraction) ||
+            !detail::parseField(in + kFieldWidth, false, rpmValue, rpmFraction))
+        {
+            return false;
+        }
+    }
+
+    // Exact decimal -> double division, then one rounding to float, matches QString::toFloat
+    speed = static_cast<float>(speedMantissa / detail::kPow10[speedFraction]);
+    rpm = rpmValue;
+    return true;
+}
+
+} // namespace payload
+
+#endif // PAYLOADCODEC_HPP
@@ -0,0 +1,308 @@
+#ifndef SIGNALCAPTURE_HPP
+#define SIGNALCAPTURE_HPP
+
+// Binary signal capture format (.sigcap) shared by the Dashboard receivers and the ICSimulator tools.
+//
+// Layout: one 64-byte SigCapHeader followed by fixed-size 32-byte SigCapRecord entries. The writer grows
+// the file in preallocated segments and publishes the committed record count in the header, so a reader
+// can mmap the file and index records directly without parsing. All fields are host-endian
+// (little-endian on both x86-64 and the Jetson).
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <time.h>
+
+namespace sigcap {
+
+constexpr char kMagic[8] = {'S', 'I', 'G', 'C', 'A', 'P', '\0', '\0'};
+constexpr uint16_t kVersion = 1;
+constexpr uint32_t kDefaultSegmentRecords = 65536; // 2 MiB per preallocated segment
+
+// Bus the records were captured on
+enum class Bus : uint8_t
+{
+    Unknown = 0,
+    Can = 1,
+    Udp = 2,
+    FlexRay = 3,
+    Lin = 4,
+};
+
+struct Header
+{
+    char magic[8];
+    uint16_t version;
+    uint16_t headerSize;
+    uint16_t recordSize;
+    uint8_t bus;
+    uint8_t reserved0;
+    uint64_t recordCount;   // Records committed by the writer
+    uint64_t startTimeNs;   // CLOCK_REALTIME when the capture was opened
+    uint32_t segmentRecords;
+    uint8_t reserved[28];
+};
+static_assert(sizeof(Header) == 64, "sigcap header must be 64 bytes");
+
+struct Record
+{
+    uint64_t timestampNs;   // CLOCK_REALTIME receive time
+    uint32_t id;            // CAN ID, LIN ID or FlexRay slot; 0 for plain UDP
+    uint8_t bus;            // Bus enum
+    uint8_t length;         // Valid bytes in payload
+    uint16_t sequence;      // Per-bus send sequence, modulo 2^16 (sender captures; 0 in receiver captures)
+    uint8_t payload[8];     // Raw frame payload
+    float speed;            // Decoded raw speed (m/s)
+    float rpm;              // Decoded RPM
+};
+static_assert(sizeof(Record) == 32, "sigcap record must be 32 bytes");
+
+// Returns the current CLOCK_REALTIME time in nanoseconds
+inline uint64_t realtimeNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// Class: Writer
+// Description: Appends records to a .sigcap file. Not thread-safe; intended to be driven by one writer thread.
+class Writer
+{
+public:
+    Writer() : m_fd(-1), m_count(0), m_allocated(0), m_segmentRecords(kDefaultSegmentRecords) {}
+    ~Writer() { close(); }
+
+    Writer(const Writer &) = delete;
+    Writer &operator=(const Writer &) = delete;
+
+    // Creates (or truncates) the capture file and writes an empty header
+    bool open(const std::string &path, Bus bus, uint32_t segmentRecords = kDefaultSegmentRecords)
+    {
+        close();
+        m_fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (m_fd < 0)
+        {
+            return false;
+        }
+
+        m_count = 0;
+        m_allocated = 0;
+        m_segmentRecords = segmentRecords ? segmentRecords : kDefaultSegmentRecords;
+
+        memset(&m_header, 0, sizeof(m_header));
+        memcpy(m_header.magic, kMagic, sizeof(kMagic));
+        m_header.version = kVersion;
+        m_header.headerSize = sizeof(Header);
+        m_header.recordSize = sizeof(Record);
+        m_header.bus = static_cast<uint8_t>(bus);
+        m_header.startTimeNs = realtimeNs();
+        m_header.segmentRecords = m_segmentRecords;
+        return writeHeader();
+    }
+
+    bool isOpen() const { return m_fd >= 0; }
+    uint64_t count() const { return m_count; }
+
+    // Appends count records and grows the file by whole segments when needed
+    bool append(const Record *records, size_t count)
+    {
+        if (m_fd < 0)
+        {
+            return false;
+        }
+        if (count == 0)
+        {
+            return true;
+        }
+
+        uint64_t needed = m_count + count;
+        if (needed > m_allocated)
+        {
+            uint64_t segments = (needed + m_segmentRecords - 1) / m_segmentRecords;
+            uint64_t newAllocated = segments * m_segmentRecords;
+            off_t offset = static_cast<off_t>(sizeof(Header) + m_allocated * sizeof(Record));
+            off_t length = static_cast<off_t>((newAllocated - m_allocated) * sizeof(Record));
+            // Preallocation is an optimisation; continue if the filesystem does not support it
+            posix_fallocate(m_fd, offset, length);
+            m_allocated = newAllocated;
+        }
+
+        const char *data = reinterpret_cast<const char *>(records);
+        size_t remaining = count * sizeof(Record);
+        off_t offset = static_cast<off_t>(sizeof(Header) + m_count * sizeof(Record));
+        while (remaining > 0)
+        {
+            ssize_t written = pwrite(m_fd, data, remaining, offset);
+            if (written <= 0)
+            {
+                return false;
+            }
+            data += written;
+            offset += written;
+            remaining -= static_cast<size_t>(written);
+        }
+        m_count = needed;
+        return true;
+    }
+
+    // Publishes the record count in the header so readers see the appended records
+    bool commit()
+    {
+        if (m_fd < 0)
+        {
+            return false;
+        }
+        m_header.recordCount = m_count;
+        return writeHeader();
+    }
+
+    // Commits, trims the unused preallocated tail and closes the file
+    void close()
+    {
+        if (m_fd < 0)
+        {
+            return;
+        }
+        commit();
+        if (ftruncate(m_fd, static_cast<off_t>(sizeof(Header) + m_count * sizeof(Record))) < 0)
+        {
+            perror("Failed to trim sigcap file");
+        }
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+private:
+    bool writeHeader()
+    {
+        return pwrite(m_fd, &m_header, sizeof(m_header), 0) == static_cast<ssize_t>(sizeof(m_header));
+    }
+
+    int m_fd;
+    uint64_t m_count;
+    uint64_t m_allocated;
+    uint32_t m_segmentRecords;
+    Header m_header;
+};
+
+// Class: Reader
+// Description: Read-only memory-mapped view of a .sigcap file. Records are accessed in place.
+class Reader
+{
+public:
+    Reader() : m_base(nullptr), m_mappedSize(0), m_header(nullptr), m_records(nullptr), m_count(0) {}
+    ~Reader() { close(); }
+
+    Reader(const Reader &) = delete;
+    Reader &operator=(const Reader &) = delete;
+
+    // Maps the file and validates the header
+    bool open(const std::string &path)
+    {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(Header))
+        {
+            ::close(fd);
+            return false;
+        }
+
+        void *base = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED)
+        {
+            return false;
+        }
+
+        const Header *header = static_cast<const Header *>(base);
+        if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion ||
+            header->recordSize != sizeof(Record) || header->headerSize < sizeof(Header))
+        {
+            munmap(base, static_cast<size_t>(st.st_size));
+            return false;
+        }
+
+        m_base = base;
+        m_mappedSize = static_cast<size_t>(st.st_size);
+        m_header = header;
+        m_records = reinterpret_cast<const Record *>(static_cast<const char *>(base) + header->headerSize);
+
+        // Never trust the count beyond what is actually on disk
+        uint64_t onDisk = (m_mappedSize - header->headerSize) / sizeof(Record);
+        m_count = header->recordCount < onDisk ? header->recordCount : onDisk;
+        madvise(base, m_mappedSize, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void close()
+    {
+        if (m_base)
+        {
+            munmap(m_base, m_mappedSize);
+        }
+        m_base = nullptr;
+        m_mappedSize = 0;
+        m_header = nullptr;
+        m_records = nullptr;
+        m_count = 0;
+    }
+
+    bool isOpen() const { return m_base != nullptr; }
+    const Header &header() const { return *m_header; }
+    uint64_t size() const { return m_count; }
+    const Record *begin() const { return m_records; }
+    const Record *end() const { return m_records + m_count; }
+    const Record &operator[](uint64_t index) const { return m_records[index]; }
+
+private:
+    void *m_base;
+    size_t m_mappedSize;
+    const Header *m_header;
+    const Record *m_records;
+    uint64_t m_count;
+};
+
+// Converts a capture to the JSON array layout consumed by Autoware: [{"Speed":x,"RPM":y}, ...].
+// Streams through the mapped records, so memory use does not depend on the capture length.
+inline bool exportJson(const std::string &capturePath, const std::string &jsonPath)
+{
+    Reader reader;
+    if (!reader.open(capturePath))
+    {
+        return false;
+    }
+
+    FILE *out = fopen(jsonPath.c_str(), "w");
+    if (!out)
+    {
+        return false;
+    }
+
+    fputs("[", out);
+    bool first = true;
+    for (const Record &record : reader)
+    {
+        fprintf(out, "%s{\"Speed\":%.7g,\"RPM\":%.7g}", first ? "\n  " : ",\n  ", record.speed, record.rpm);
+        first = false;
+    }
+    fputs(first ? "]" : "\n]", out);
+
+    bool ok = ferror(out) == 0;
+    return fclose(out) == 0 && ok;
+}
+
+} // namespace sigcap
+
+#endif // SIGNALCAPTURE_HPP
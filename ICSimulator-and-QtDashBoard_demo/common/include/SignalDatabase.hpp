@@ -0,0 +1,414 @@
+#ifndef SIGNALDATABASE_HPP
+#define SIGNALDATABASE_HPP
+
+// CAN signal database shared by the ICSimulator senders and the Dashboard CanReceiver.
+//
+// The database is a JSON file loaded once at startup (see common/signals/vehicle_signals.json):
+//
+//   {"messages": [{"name": "FuelStatus", "id": "0x3A0", "extended": false, "fd": false, "length": 8, "cycleMs": 100,
+//                  "signals": [{"name": "FuelLevel", "startBit": 0, "length": 8, "byteOrder": "intel",
+//                               "signed": false, "factor": 0.4, "offset": 0, "min": 0, "max": 100,
+//                               "unit": "%", "gauge": "fuel"}]}]}
+//
+// Start bits use DBC numbering: the least significant bit for Intel (little-endian) signals and the most
+// significant bit in DBC "sawtooth" order for Motorola (big-endian) ones. "gauge" optionally binds a
+// signal to a Dashboard gauge: speed (m/s), rpm, fuel or temperature.
+//
+// "fd": true marks a CAN FD message; it may carry up to 64 bytes (a valid FD length: 0-8, 12, 16, 20, 24,
+// 32, 48 or 64) and is sent with the bit rate switch unless "brs" is false. Classic messages hold 1 to 8.
+//
+// Each message is compiled into a FramePlan: a table of byte offsets, shifts, masks and scale factors.
+// Every signal is read or written through one 64-bit word loaded at its first byte (little-endian for
+// Intel, big-endian for Motorola), so a signal may span at most 8 bytes. Packing and unpacking never
+// touch strings or allocate.
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace signaldb {
+
+constexpr size_t kClassicPayload = 8;
+constexpr size_t kMaxPayload = 64;   // CAN FD
+constexpr uint32_t kExtendedFlag = 0x80000000u; // Same bit as CAN_EFF_FLAG
+constexpr uint32_t kStandardIdMask = 0x7FFu;
+constexpr uint32_t kExtendedIdMask = 0x1FFFFFFFu;
+
+// Dashboard gauge a signal drives
+enum class Gauge : uint8_t
+{
+    None = 0,
+    Speed,
+    Rpm,
+    Fuel,
+    Temperature,
+};
+
+struct Signal
+{
+    std::string name;
+    unsigned startBit = 0;
+    unsigned length = 0;
+    bool bigEndian = false;
+    bool isSigned = false;
+    double factor = 1.0;
+    double offset = 0.0;
+    double minimum = 0.0;
+    double maximum = 0.0;
+    std::string unit;
+    Gauge gauge = Gauge::None;
+};
+
+struct Message
+{
+    uint32_t id = 0;        // kExtendedFlag set for 29-bit identifiers
+    std::string name;
+    uint8_t length = kClassicPayload;
+    bool fd = false;        // CAN FD frame
+    bool bitRateSwitch = false;
+    uint32_t cycleMs = 0;   // 0: not sent periodically
+    std::vector<Signal> signalList; // Not "signals", which is a Qt keyword macro
+};
+
+// Precompiled bit layout and scaling of one signal
+struct FieldPlan
+{
+    uint64_t mask;          // Low `length` bits
+    uint8_t byteOffset;     // First byte of the 64-bit word holding the signal
+    uint8_t shift;          // LSB position in that word
+    bool bigEndian;
+    bool isSigned;
+    uint8_t length;
+    double factor;
+    double inverseFactor;
+    double offset;
+    double rawMin;
+    double rawMax;
+};
+
+// Pack/unpack plan of one message. Values are physical values in signal order.
+class FramePlan
+{
+public:
+    explicit FramePlan(const Message &message) : m_id(message.id), m_length(message.length)
+    {
+        m_fields.reserve(message.signalList.size());
+        for (const Signal &signal : message.signalList)
+        {
+            FieldPlan field;
+            field.mask = signal.length >= 64 ? ~0ull : (1ull << signal.length) - 1;
+            field.byteOffset = static_cast<uint8_t>(signal.startBit / 8);
+            field.shift = static_cast<uint8_t>(signal.bigEndian ? motorolaMsb(signal.startBit) + 1 - signal.length
+                                                                : signal.startBit % 8);
+            field.bigEndian = signal.bigEndian;
+            field.isSigned = signal.isSigned;
+            field.length = static_cast<uint8_t>(signal.length);
+            field.factor = signal.factor;
+            field.inverseFactor = 1.0 / signal.factor;
+            field.offset = signal.offset;
+            if (signal.isSigned)
+            {
+                field.rawMin = -std::ldexp(1.0, static_cast<int>(signal.length) - 1);
+                field.rawMax = std::ldexp(1.0, static_cast<int>(signal.length) - 1) - 1.0;
+            }
+            else
+            {
+                field.rawMin = 0.0;
+                field.rawMax = std::ldexp(1.0, static_cast<int>(signal.length)) - 1.0;
+            }
+            m_fields.push_back(field);
+        }
+    }
+
+    uint32_t id() const { return m_id; }
+    uint8_t length() const { return m_length; }
+    size_t fieldCount() const { return m_fields.size(); }
+    const FieldPlan &field(size_t index) const { return m_fields[index]; }
+
+    // Encodes fieldCount() physical values into length() bytes; values are rounded and saturated to
+    // the raw range of each signal
+    void pack(const double *values, uint8_t *out) const
+    {
+        // Padded so the word of a signal in the last bytes never runs past the buffer
+        uint8_t bytes[kMaxPayload + 8] = {};
+        for (size_t i = 0; i < m_fields.size(); ++i)
+        {
+            const FieldPlan &field = m_fields[i];
+            double raw = std::nearbyint((values[i] - field.offset) * field.inverseFactor);
+            raw = raw < field.rawMin ? field.rawMin : (raw > field.rawMax ? field.rawMax : raw);
+            uint64_t bits = field.isSigned ? static_cast<uint64_t>(static_cast<int64_t>(raw))
+                                           : static_cast<uint64_t>(raw);
+            place(field, bits, bytes);
+        }
+        memcpy(out, bytes, m_length);
+    }
+
+    // Decodes length() bytes into fieldCount() physical values
+    void unpack(const uint8_t *in, double *values) const
+    {
+        uint8_t bytes[kMaxPayload + 8];
+        memcpy(bytes, in, m_length);
+        memset(bytes + m_length, 0, sizeof(bytes) - m_length);
+        for (size_t i = 0; i < m_fields.size(); ++i)
+        {
+            const FieldPlan &field = m_fields[i];
+            uint64_t bits = (loadWord(field, bytes) >> field.shift) & field.mask;
+            double raw;
+            if (field.isSigned && field.length < 64)
+            {
+                unsigned unused = 64 - field.length;
+                raw = static_cast<double>(static_cast<int64_t>(bits << unused) >> unused);
+            }
+            else
+            {
+                raw = field.isSigned ? static_cast<double>(static_cast<int64_t>(bits)) : static_cast<double>(bits);
+            }
+            values[i] = raw * field.factor + field.offset;
+        }
+    }
+
+    // Sets the bits a signal covers in a kMaxPayload + 8 byte mask; used to detect overlapping signals
+    void occupiedBits(size_t index, uint8_t *bytes) const { place(m_fields[index], m_fields[index].mask, bytes); }
+
+    // Bit position of a Motorola start bit in the big-endian 64-bit word starting at its own byte
+    static unsigned motorolaMsb(unsigned startBit) { return 56 + startBit % 8; }
+
+private:
+    static uint64_t loadWord(const FieldPlan &field, const uint8_t *bytes)
+    {
+        const uint8_t *p = bytes + field.byteOffset;
+        uint64_t word = 0;
+        for (int i = 0; i < 8; ++i)
+        {
+            word |= static_cast<uint64_t>(p[i]) << (field.bigEndian ? 56 - 8 * i : 8 * i);
+        }
+        return word;
+    }
+
+    static void place(const FieldPlan &field, uint64_t bits, uint8_t *bytes)
+    {
+        uint64_t shifted = (bits & field.mask) << field.shift;
+        uint8_t *p = bytes + field.byteOffset;
+        for (int i = 0; i < 8; ++i)
+        {
+            p[i] |= static_cast<uint8_t>(shifted >> (field.bigEndian ? 56 - 8 * i : 8 * i));
+        }
+    }
+
+    uint32_t m_id;
+    uint8_t m_length;
+    std::vector<FieldPlan> m_fields;
+};
+
+// Loaded signal database
+class Database
+{
+public:
+    // Loads and validates a database file; on failure the database is left empty and error says why
+    bool load(const std::string &path, std::string *error = nullptr)
+    {
+        std::ifstream file(path);
+        if (!file.is_open())
+        {
+            return fail(error, "cannot open " + path);
+        }
+        std::stringstream text;
+        text << file.rdbuf();
+        return loadFromString(text.str(), error);
+    }
+
+    bool loadFromString(const std::string &text, std::string *error = nullptr)
+    {
+        m_messages.clear();
+        std::vector<Message> messages;
+        try
+        {
+            nlohmann::json root = nlohmann::json::parse(text);
+            for (const nlohmann::json &entry : root.at("messages"))
+            {
+                Message message;
+                if (!parseMessage(entry, message, error))
+                {
+                    return false;
+                }
+                for (const Message &other : messages)
+                {
+                    if (other.id == message.id)
+                    {
+                        return fail(error, message.name + ": duplicate id of " + other.name);
+                    }
+                }
+                messages.push_back(std::move(message));
+            }
+        }
+        catch (const nlohmann::json::exception &e)
+        {
+            return fail(error, e.what());
+        }
+        m_messages = std::move(messages);
+        return true;
+    }
+
+    const std::vector<Message> &messages() const { return m_messages; }
+
+    const Message *findMessage(uint32_t id) const
+    {
+        for (const Message &message : m_messages)
+        {
+            if (message.id == id)
+            {
+                return &message;
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    static bool fail(std::string *error, const std::string &reason)
+    {
+        if (error)
+        {
+            *error = reason;
+        }
+        return false;
+    }
+
+    static uint32_t parseId(const nlohmann::json &value)
+    {
+        if (value.is_string())
+        {
+            return static_cast<uint32_t>(std::stoul(value.get<std::string>(), nullptr, 0));
+        }
+        return value.get<uint32_t>();
+    }
+
+    static bool parseGauge(const std::string &name, Gauge &gauge)
+    {
+        static const char *const kNames[] = {"", "speed", "rpm", "fuel", "temperature"};
+        for (size_t i = 0; i < sizeof(kNames) / sizeof(kNames[0]); ++i)
+        {
+            if (name == kNames[i])
+            {
+                gauge = static_cast<Gauge>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool parseMessage(const nlohmann::json &entry, Message &message, std::string *error)
+    {
+        message.name = entry.at("name").get<std::string>();
+        uint32_t id = parseId(entry.at("id"));
+        bool extended = entry.value("extended", false);
+        if (id > (extended ? kExtendedIdMask : kStandardIdMask))
+        {
+            return fail(error, message.name + ": id out of range");
+        }
+        message.id = extended ? (id | kExtendedFlag) : id;
+        message.fd = entry.value("fd", false);
+        message.bitRateSwitch = message.fd && entry.value("brs", true);
+        unsigned length = entry.value("length", static_cast<unsigned>(kClassicPayload));
+        if (!validLength(length, message.fd))
+        {
+            return fail(error, message.name + (message.fd ? ": length must be a CAN FD length of 1 to 64 bytes"
+                                                          : ": length must be 1 to 8 bytes"));
+        }
+        message.length = static_cast<uint8_t>(length);
+        message.cycleMs = entry.value("cycleMs", 0u);
+
+        for (const nlohmann::json &item : entry.at("signals"))
+        {
+            Signal signal;
+            signal.name = item.at("name").get<std::string>();
+            signal.startBit = item.at("startBit").get<unsigned>();
+            signal.length = item.at("length").get<unsigned>();
+            std::string order = item.value("byteOrder", std::string("intel"));
+            signal.bigEndian = order == "motorola";
+            signal.isSigned = item.value("signed", false);
+            signal.factor = item.value("factor", 1.0);
+            signal.offset = item.value("offset", 0.0);
+            signal.minimum = item.value("min", 0.0);
+            signal.maximum = item.value("max", 0.0);
+            signal.unit = item.value("unit", std::string());
+            std::string where = message.name + "." + signal.name;
+
+            if (order != "intel" && order != "motorola")
+            {
+                return fail(error, where + ": byteOrder must be intel or motorola");
+            }
+            if (!parseGauge(item.value("gauge", std::string()), signal.gauge))
+            {
+                return fail(error, where + ": unknown gauge");
+            }
+            if (signal.factor == 0.0)
+            {
+                return fail(error, where + ": factor must not be 0");
+            }
+            if (signal.length == 0 || signal.length > 64 || signal.startBit >= 8 * message.length)
+            {
+                return fail(error, where + ": bad start bit or length");
+            }
+            // One past the MSB position of the signal in its word; a Motorola signal runs towards later bytes
+            unsigned lsbOffset = FramePlan::motorolaMsb(signal.startBit) + 1;
+            bool fits = signal.bigEndian
+                            ? lsbOffset >= signal.length && signal.startBit / 8 + (63 - (lsbOffset - signal.length)) / 8 < message.length
+                            : signal.startBit + signal.length <= 8u * message.length;
+            if (!fits)
+            {
+                return fail(error, where + ": does not fit the message");
+            }
+            if (!signal.bigEndian && signal.startBit % 8 + signal.length > 64)
+            {
+                return fail(error, where + ": spans more than 8 bytes");
+            }
+            message.signalList.push_back(signal);
+        }
+
+        FramePlan plan(message);
+        uint8_t used[kMaxPayload + 8] = {};
+        for (size_t i = 0; i < plan.fieldCount(); ++i)
+        {
+            uint8_t bits[kMaxPayload + 8] = {};
+            plan.occupiedBits(i, bits);
+            for (size_t b = 0; b < sizeof(bits); ++b)
+            {
+                if (used[b] & bits[b])
+                {
+                    return fail(error, message.name + "." + message.signalList[i].name + ": overlaps another signal");
+                }
+                used[b] |= bits[b];
+            }
+        }
+        return true;
+    }
+
+    static bool validLength(unsigned length, bool fd)
+    {
+        if (!fd)
+        {
+            return length >= 1 && length <= kClassicPayload;
+        }
+        static const unsigned kFdLengths[] = {1, 2, 3, 4, 5, 6, 7, 8, 12, 16, 20, 24, 32, 48, 64};
+        for (unsigned valid : kFdLengths)
+        {
+            if (length == valid)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::vector<Message> m_messages;
+};
+
+} // namespace signaldb
+
+#endif // SIGNALDATABASE_HPP
@@ -0,0 +1,310 @@
+#ifndef WIREFORMAT_HPP
+#define WIREFORMAT_HPP
+
+// Sequenced, timestamped binary framing of the speed/RPM signals, shared by the ICSimulator senders and
+// the Dashboard receivers. It replaces the 8-byte ASCII payload of PayloadCodec.hpp per transport; the
+// receivers tell the two apart by the first byte, since ASCII payloads never set its top bit.
+//
+// Header byte: bit 7 set, bits 6-5 format version (kVersion), bits 4-0 signal set id.
+//
+// Full frame (datagram transports: UDP, FlexRay-over-UDP), 18 bytes little-endian:
+//   0  header         1  flags (0)
+//   2  speed u16      0.01 m/s
+//   4  rpm u16        0.25 rpm
+//   6  sequence u32
+//   10 timestamp u64  sender CLOCK_MONOTONIC in ns
+//
+// Compact frame (8-byte CAN and LIN payloads), 8 bytes little-endian:
+//   0  header         1  sequence, low 8 bits
+//   2  timestamp u16  sender CLOCK_MONOTONIC in us, low 16 bits
+//   4  speed u16      6  rpm u16 (scaled as above)
+//
+// Receivers extend the truncated compact fields against their own state: the sequence against the last
+// one seen and the timestamp against their own monotonic clock, which holds while one-way latency stays
+// below 65 ms. Sender and receiver must share the clock (same host or a PTP-synchronised one) for the
+// latency to be meaningful.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <time.h>
+
+namespace wire {
+
+constexpr uint8_t kVersion = 1;
+constexpr uint8_t kBinaryFlag = 0x80;
+constexpr size_t kFullSize = 18;
+constexpr size_t kCompactSize = 8;
+constexpr double kSpeedResolution = 0.01;
+constexpr double kRpmResolution = 0.25;
+
+// Signals a frame carries
+enum class SignalSet : uint8_t
+{
+    SpeedRpm = 1,
+};
+
+// Payload format of one transport
+enum class Format : uint8_t
+{
+    Ascii,      // PayloadCodec.hpp, the legacy format
+    Binary,     // Full or compact frames of this header
+};
+
+// Parses "ascii" or "binary"
+inline bool parseFormat(const std::string &name, Format &format)
+{
+    if (name == "ascii")
+    {
+        format = Format::Ascii;
+        return true;
+    }
+    if (name == "binary")
+    {
+        format = Format::Binary;
+        return true;
+    }
+    return false;
+}
+
+inline uint64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+// A decoded frame
+struct Frame
+{
+    uint8_t version;
+    SignalSet signalSet;
+    bool compact;
+    uint32_t sequence;      // Full sequence, or its low 8 bits for compact frames
+    uint64_t timestampNs;   // Full timestamp, or its low 16 bits in us (times 1000) for compact frames
+    float speed;            // m/s
+    float rpm;
+};
+
+namespace detail {
+
+inline void store16(uint8_t *out, uint16_t value)
+{
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+}
+
+inline uint16_t load16(const uint8_t *in)
+{
+    return static_cast<uint16_t>(in[0] | (in[1] << 8));
+}
+
+inline void store32(uint8_t *out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+inline uint32_t load32(const uint8_t *in)
+{
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        value |= static_cast<uint32_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+inline void store64(uint8_t *out, uint64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+inline uint64_t load64(const uint8_t *in)
+{
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+// Rounds value / resolution into 0..65535
+inline uint16_t toFixed(float value, double resolution)
+{
+    double scaled = value / resolution + 0.5;
+    return static_cast<uint16_t>(scaled < 0.0 ? 0.0 : (scaled > 65535.0 ? 65535.0 : scaled));
+}
+
+inline uint8_t header(SignalSet signalSet)
+{
+    return static_cast<uint8_t>(kBinaryFlag | (kVersion << 5) | (static_cast<uint8_t>(signalSet) & 0x1F));
+}
+
+inline bool parseHeader(uint8_t byte, Frame &frame)
+{
+    frame.version = static_cast<uint8_t>((byte >> 5) & 0x03);
+    frame.signalSet = static_cast<SignalSet>(byte & 0x1F);
+    return (byte & kBinaryFlag) != 0 && frame.version == kVersion && frame.signalSet == SignalSet::SpeedRpm;
+}
+
+} // namespace detail
+
+// True if a payload is a binary frame rather than ASCII
+inline bool isBinary(const uint8_t *data, size_t length)
+{
+    return length > 0 && (data[0] & kBinaryFlag) != 0;
+}
+
+// Numbers and stamps the frames of one transport stream
+class Encoder
+{
+public:
+    explicit Encoder(SignalSet signalSet = SignalSet::SpeedRpm) : m_signalSet(signalSet), m_sequence(0) {}
+
+    // Writes kFullSize bytes; returns the frame size
+    size_t encodeFull(float speed, float rpm, uint8_t *out)
+    {
+        out[0] = detail::header(m_signalSet);
+        out[1] = 0;
+        detail::store16(out + 2, detail::toFixed(speed, kSpeedResolution));
+        detail::store16(out + 4, detail::toFixed(rpm, kRpmResolution));
+        detail::store32(out + 6, m_sequence++);
+        detail::store64(out + 10, monotonicNs());
+        return kFullSize;
+    }
+
+    // Writes kCompactSize bytes; returns the frame size
+    size_t encodeCompact(float speed, float rpm, uint8_t *out)
+    {
+        out[0] = detail::header(m_signalSet);
+        out[1] = static_cast<uint8_t>(m_sequence++);
+        detail::store16(out + 2, static_cast<uint16_t>(monotonicNs() / 1000));
+        detail::store16(out + 4, detail::toFixed(speed, kSpeedResolution));
+        detail::store16(out + 6, detail::toFixed(rpm, kRpmResolution));
+        return kCompactSize;
+    }
+
+    uint32_t sequence() const { return m_sequence; }
+
+private:
+    SignalSet m_signalSet;
+    uint32_t m_sequence;
+};
+
+// Decodes a full or compact frame, chosen by length; returns false for anything else
+inline bool decode(const uint8_t *data, size_t length, Frame &frame)
+{
+    if ((length != kFullSize && length != kCompactSize) || !detail::parseHeader(data[0], frame))
+    {
+        return false;
+    }
+    frame.compact = length == kCompactSize;
+    if (frame.compact)
+    {
+        frame.sequence = data[1];
+        frame.timestampNs = static_cast<uint64_t>(detail::load16(data + 2)) * 1000;
+        frame.speed = static_cast<float>(detail::load16(data + 4) * kSpeedResolution);
+        frame.rpm = static_cast<float>(detail::load16(data + 6) * kRpmResolution);
+    }
+    else
+    {
+        frame.speed = static_cast<float>(detail::load16(data + 2) * kSpeedResolution);
+        frame.rpm = static_cast<float>(detail::load16(data + 4) * kRpmResolution);
+        frame.sequence = detail::load32(data + 6);
+        frame.timestampNs = detail::load64(data + 10);
+    }
+    return true;
+}
+
+// Sender timestamp of a frame on the receiver's monotonic clock; compact stamps are placed in the
+// 65.536 ms window ending at nowNs
+inline uint64_t senderTimeNs(const Frame &frame, uint64_t nowNs)
+{
+    if (!frame.compact)
+    {
+        return frame.timestampNs;
+    }
+    uint64_t nowUs = nowNs / 1000;
+    uint64_t stampUs = frame.timestampNs / 1000;
+    return (nowUs - ((nowUs - stampUs) & 0xFFFF)) * 1000;
+}
+
+// Loss, duplication, reordering and latency of one stream of binary frames
+struct StreamStats
+{
+    uint64_t received = 0;
+    uint64_t lost = 0;          // Sequence numbers skipped and not (yet) seen
+    uint64_t duplicates = 0;    // Same sequence number as the previous frame
+    uint64_t reordered = 0;     // Arrived after a later sequence number
+    uint64_t latencyCount = 0;
+    uint64_t latencySumNs = 0;
+    uint64_t latencyMaxNs = 0;
+};
+
+// Classifies the sequence numbers of one stream. Sequences compare within half their range, so a gap
+// of more than 127 compact frames reads as reordering.
+class SequenceTracker
+{
+public:
+    void update(const Frame &frame, uint64_t nowNs)
+    {
+        ++m_stats.received;
+        uint32_t mask = frame.compact ? 0xFFu : 0xFFFFFFFFu;
+        uint32_t half = mask / 2 + 1;
+        if (!m_started)
+        {
+            m_started = true;
+            m_next = (frame.sequence + 1) & mask;
+        }
+        else
+        {
+            uint32_t ahead = (frame.sequence - m_next) & mask;
+            if (ahead < half)
+            {
+                m_stats.lost += ahead;
+                m_next = (frame.sequence + 1) & mask;
+            }
+            else if (((m_next - 1) & mask) == frame.sequence)
+            {
+                ++m_stats.duplicates;
+            }
+            else
+            {
+                // A late frame fills a gap that was counted as lost
+                ++m_stats.reordered;
+                if (m_stats.lost > 0)
+                {
+                    --m_stats.lost;
+                }
+            }
+        }
+
+        uint64_t sentNs = senderTimeNs(frame, nowNs);
+        if (sentNs <= nowNs)
+        {
+            uint64_t latency = nowNs - sentNs;
+            ++m_stats.latencyCount;
+            m_stats.latencySumNs += latency;
+            m_stats.latencyMaxNs = latency > m_stats.latencyMaxNs ? latency : m_stats.latencyMaxNs;
+        }
+    }
+
+    const StreamStats &stats() const { return m_stats; }
+
+private:
+    StreamStats m_stats;
+    bool m_started = false;
+    uint32_t m_next = 0;
+};
+
+} // namespace wire
+
+#endif // WIREFORMAT_HPP